@@ -0,0 +1,269 @@
+#include "common.h"
+#include "cache.h"
+#include <sched.h>
+#include <stddef.h>
+
+
+/*
+ * cache definitions
+ */
+
+#define DEAD UINT_MAX
+
+
+/**
+ * Cache entry structure, allocated together with its value. Entries are
+ * only unlinked under the cache mutex, and only freed once every lookup
+ * that could still see them has finished.
+ *   @next, dead: The next entry in the bucket and in the removal list.
+ *   @refcnt: The reference count, or 'DEAD' once claimed for removal.
+ *   @hash: The key hash.
+ *   @key: The key.
+ *   @val: The value.
+ */
+
+struct dsp_cache_ent_t {
+	struct dsp_cache_ent_t *next, *dead;
+	unsigned int refcnt;
+
+	uint64_t hash;
+	uint8_t key[DSP_CACHE_KEYLEN];
+
+	_Alignas(max_align_t) uint8_t val[];
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void cache_lock(struct dsp_cache_t *cache);
+static struct dsp_cache_ent_t *cache_find(struct dsp_cache_t *cache, struct dsp_cache_ent_t **bucket, uint64_t hash, const void *key);
+static void cache_wait(struct dsp_cache_t *cache);
+
+
+/**
+ * Allocate memory for a cached value.
+ *   @size: The value size.
+ *   &returns: The value memory.
+ */
+
+void *dsp_cache_alloc(size_t size)
+{
+	struct dsp_cache_ent_t *ent;
+
+	ent = mem_alloc(sizeof(struct dsp_cache_ent_t) + size);
+	ent->dead = NULL;
+	ent->refcnt = 1;
+
+	return ent->val;
+}
+
+/**
+ * Retrieve a value, building it if not already cached. Hits take no lock;
+ * they announce themselves on the reader counter of the current epoch so
+ * that removals can wait them out. Misses build the value without holding
+ * the mutex, so a concurrent miss on the same key may build it twice and
+ * discard one copy.
+ *   @cache: The cache.
+ *   @key: The key. Padding bytes must be cleared.
+ *   @build: The builder.
+ *   &returns: The value. It must be released with 'dsp_cache_put'.
+ */
+
+void *dsp_cache_get(struct dsp_cache_t *cache, const void *key, dsp_cache_build_f build)
+{
+	unsigned int epoch;
+	size_t i;
+	uint64_t hash = UINT64_C(14695981039346656037);
+	struct dsp_cache_ent_t *ent, *found, **bucket;
+
+	for(i = 0; i < cache->keylen; i++)
+		hash = (hash ^ ((const uint8_t *)key)[i]) * UINT64_C(1099511628211);
+
+	bucket = &cache->bucket[hash % DSP_CACHE_NBUCKET];
+
+	epoch = __atomic_load_n(&cache->epoch, __ATOMIC_SEQ_CST) % 2;
+	__atomic_add_fetch(&cache->readers[epoch], 1, __ATOMIC_SEQ_CST);
+	found = cache_find(cache, bucket, hash, key);
+	__atomic_sub_fetch(&cache->readers[epoch], 1, __ATOMIC_RELEASE);
+
+	if(found != NULL)
+		return found->val;
+
+	ent = (struct dsp_cache_ent_t *)((uint8_t *)build(key) - offsetof(struct dsp_cache_ent_t, val));
+	ent->hash = hash;
+	mem_set(ent->key, 0x00, DSP_CACHE_KEYLEN);
+	mem_copy(ent->key, key, cache->keylen);
+
+	cache_lock(cache);
+
+	found = cache_find(cache, bucket, hash, key);
+	if(found == NULL) {
+		ent->next = *bucket;
+		__atomic_store_n(bucket, ent, __ATOMIC_RELEASE);
+	}
+
+	thread_mutex_unlock(&cache->lock);
+
+	if(found == NULL)
+		return ent->val;
+
+	mem_free(ent);
+
+	return found->val;
+}
+
+/**
+ * Release a value. Unless the cache keeps unreferenced values, the last
+ * release removes the value, waiting out concurrent lookups before freeing
+ * it. A lookup may revive the value between the last release and its
+ * removal, so the release claims it from inside a reader section.
+ *   @cache: The cache.
+ *   @val: The value.
+ */
+
+void dsp_cache_put(struct dsp_cache_t *cache, const void *val)
+{
+	unsigned int epoch, zero = 0;
+	bool claim;
+	struct dsp_cache_ent_t *ent, **ref;
+
+	ent = (struct dsp_cache_ent_t *)((const uint8_t *)val - offsetof(struct dsp_cache_ent_t, val));
+
+	if(cache->keep) {
+		__atomic_sub_fetch(&ent->refcnt, 1, __ATOMIC_RELEASE);
+		return;
+	}
+
+	epoch = __atomic_load_n(&cache->epoch, __ATOMIC_SEQ_CST) % 2;
+	__atomic_add_fetch(&cache->readers[epoch], 1, __ATOMIC_SEQ_CST);
+	claim = (__atomic_sub_fetch(&ent->refcnt, 1, __ATOMIC_ACQ_REL) == 0) && __atomic_compare_exchange_n(&ent->refcnt, &zero, DEAD, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&cache->readers[epoch], 1, __ATOMIC_RELEASE);
+
+	if(!claim)
+		return;
+
+	cache_lock(cache);
+
+	for(ref = &cache->bucket[ent->hash % DSP_CACHE_NBUCKET]; *ref != ent; ref = &(*ref)->next)
+		;
+
+	__atomic_store_n(ref, ent->next, __ATOMIC_SEQ_CST);
+	cache_wait(cache);
+
+	thread_mutex_unlock(&cache->lock);
+
+	mem_free(ent);
+}
+
+/**
+ * Free every unreferenced value.
+ *   @cache: The cache.
+ *   &returns: The number of values freed.
+ */
+
+unsigned int dsp_cache_purge(struct dsp_cache_t *cache)
+{
+	unsigned int i, cnt, zero;
+	struct dsp_cache_ent_t **ref, *ent, *dead = NULL;
+
+	cache_lock(cache);
+
+	for(i = 0; i < DSP_CACHE_NBUCKET; i++) {
+		for(ref = &cache->bucket[i]; (ent = *ref) != NULL; ) {
+			zero = 0;
+
+			if(__atomic_compare_exchange_n(&ent->refcnt, &zero, DEAD, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+				__atomic_store_n(ref, ent->next, __ATOMIC_SEQ_CST);
+				ent->dead = dead;
+				dead = ent;
+			}
+			else
+				ref = &ent->next;
+		}
+	}
+
+	if(dead != NULL)
+		cache_wait(cache);
+
+	thread_mutex_unlock(&cache->lock);
+
+	for(cnt = 0; (ent = dead) != NULL; cnt++) {
+		dead = ent->dead;
+		mem_free(ent);
+	}
+
+	return cnt;
+}
+
+
+/**
+ * Lock the cache mutex, creating it on first use.
+ *   @cache: The cache.
+ */
+
+static void cache_lock(struct dsp_cache_t *cache)
+{
+	int state = 0;
+
+	if(__atomic_load_n(&cache->init, __ATOMIC_ACQUIRE) != 2) {
+		if(__atomic_compare_exchange_n(&cache->init, &state, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+			cache->lock = thread_mutex_new(NULL);
+			__atomic_store_n(&cache->init, 2, __ATOMIC_RELEASE);
+		}
+		else {
+			while(__atomic_load_n(&cache->init, __ATOMIC_ACQUIRE) != 2)
+				sched_yield();
+		}
+	}
+
+	thread_mutex_lock(&cache->lock);
+}
+
+/**
+ * Find and reference a live entry in a bucket. Entries claimed for removal
+ * are skipped.
+ *   @cache: The cache.
+ *   @bucket: The bucket.
+ *   @hash: The key hash.
+ *   @key: The key.
+ *   &returns: The referenced entry or null.
+ */
+
+static struct dsp_cache_ent_t *cache_find(struct dsp_cache_t *cache, struct dsp_cache_ent_t **bucket, uint64_t hash, const void *key)
+{
+	unsigned int cnt;
+	struct dsp_cache_ent_t *ent;
+
+	for(ent = __atomic_load_n(bucket, __ATOMIC_ACQUIRE); ent != NULL; ent = __atomic_load_n(&ent->next, __ATOMIC_ACQUIRE)) {
+		if((ent->hash != hash) || !mem_isequal(ent->key, key, cache->keylen))
+			continue;
+
+		for(cnt = __atomic_load_n(&ent->refcnt, __ATOMIC_RELAXED); cnt != DEAD; ) {
+			if(__atomic_compare_exchange_n(&ent->refcnt, &cnt, cnt + 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				return ent;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Wait for every lookup that started before the caller's unlinks. Flipping
+ * the epoch twice drains the reader counters of both parities. The mutex
+ * must be held.
+ *   @cache: The cache.
+ */
+
+static void cache_wait(struct dsp_cache_t *cache)
+{
+	unsigned int i, epoch;
+
+	for(i = 0; i < 2; i++) {
+		epoch = __atomic_fetch_add(&cache->epoch, 1, __ATOMIC_SEQ_CST);
+
+		while(__atomic_load_n(&cache->readers[epoch % 2], __ATOMIC_SEQ_CST) != 0)
+			sched_yield();
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+/*
+ * cache definitions
+ */
+
+#define DSP_CACHE_NBUCKET 64
+#define DSP_CACHE_KEYLEN 48
+
+/**
+ * Shared cache structure. Values are immutable once built, looked up
+ * without a lock, and reference counted. The structure is statically
+ * initialized with 'DSP_CACHE_INIT', which rejects oversized keys at compile
+ * time; its mutex is created on first use.
+ *   @keylen: The key length in bytes, at most 'DSP_CACHE_KEYLEN'.
+ *   @keep: Keep unreferenced values until the next purge instead of freeing
+ *     them on their last release.
+ *   @init: The mutex initialization state.
+ *   @lock: The mutex, serializing insertion and removal.
+ *   @epoch, readers: The purge epoch and the lookups in flight per parity.
+ *   @bucket: The hash buckets.
+ */
+
+struct dsp_cache_t {
+	size_t keylen;
+	bool keep;
+
+	int init;
+	struct thread_mutex_t lock;
+
+	unsigned int epoch, readers[2];
+	struct dsp_cache_ent_t *bucket[DSP_CACHE_NBUCKET];
+};
+
+#define DSP_CACHE_INIT(keylen, keep) { (keylen) + 0 * sizeof(struct { _Static_assert((keylen) <= DSP_CACHE_KEYLEN, "Cache key too long."); int n; }), (keep) }
+
+/**
+ * Value builder callback. The value must be allocated with
+ * 'dsp_cache_alloc'.
+ *   @key: The key.
+ *   &returns: The value.
+ */
+
+typedef void *(*dsp_cache_build_f)(const void *key);
+
+/*
+ * cache function declarations
+ */
+
+void *dsp_cache_alloc(size_t size);
+void *dsp_cache_get(struct dsp_cache_t *cache, const void *key, dsp_cache_build_f build);
+void dsp_cache_put(struct dsp_cache_t *cache, const void *val);
+unsigned int dsp_cache_purge(struct dsp_cache_t *cache);
+
+#endif
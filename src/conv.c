@@ -1,5 +1,31 @@
 #include "common.h"
 #include "conv.h"
+#include "buf.h"
+#include "resamp.h"
+
+
+/**
+ * Dither structure.
+ *   @seed: The random state.
+ *   @order: The noise shaping order.
+ *   @nchan: The number of channels.
+ *   @err: The quantization error history, two per channel.
+ */
+
+struct dsp_dither_t {
+	uint32_t seed;
+	unsigned int order, nchan;
+
+	double err[];
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void arr2int(void *out, double **in, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int len, struct dsp_dither_t *dither);
+static inline double rand_unit(uint32_t *seed);
 
 
 _export
@@ -9,7 +35,9 @@ unsigned int dsp_int2len(unsigned int inrate, unsigned int outrate, unsigned int
 }
 
 /**
- * Convert interlaced data to an array.
+ * Convert interlaced data to an array, resampling from the input rate to the
+ * output rate. The input is padded with silence at the end, so the output
+ * includes the decaying tail of the final input samples.
  *   @in: The input data.
  *   @inrate: The input rate.
  *   @out: The output data.
@@ -22,13 +50,329 @@ unsigned int dsp_int2len(unsigned int inrate, unsigned int outrate, unsigned int
 _export
 unsigned int dsp_int2arr(double *in, unsigned int inrate, double **out, unsigned int outrate, unsigned int len, unsigned int nchan)
 {
-	//double idx;
-	unsigned int i, outlen;
+	struct dsp_resamp_t *resamp;
+	unsigned int i, n, cnt, idx, outlen, frames = len / nchan;
+	double tmp[nchan][256], *buf[nchan], *ptr[nchan];
 
 	outlen = dsp_int2len(inrate, outrate, len, nchan);
-	for(i = 0; i < outlen; i++) {
-		//idx = i /
+	resamp = dsp_resamp_new(inrate, outrate, nchan);
+
+	for(i = 0; i < nchan; i++)
+		buf[i] = tmp[i];
+
+	idx = 0;
+	n = 0;
+	while(n < outlen) {
+		cnt = dsp_resamp_need(resamp, outlen - n);
+		if(cnt > 256)
+			cnt = 256;
+
+		if(idx < frames) {
+			if(cnt > frames - idx)
+				cnt = frames - idx;
+
+			dsp_fmt2arr(buf, in + idx * nchan, dsp_fmt_f64, nchan, cnt);
+			idx += cnt;
+		}
+		else {
+			for(i = 0; i < nchan; i++)
+				dsp_buf_zero(tmp[i], cnt);
+		}
+
+		dsp_resamp_write(resamp, buf, cnt);
+
+		for(i = 0; i < nchan; i++)
+			ptr[i] = out[i] + n;
+
+		n += dsp_resamp_read(resamp, ptr, outlen - n);
 	}
 
+	dsp_resamp_delete(resamp);
+
 	return outlen;
 }
+
+/**
+ * Convert packed interleaved samples into planar floating point arrays.
+ * Integer formats are scaled to the range negative one to one. Samples are
+ * loaded bytewise, so the input needs no alignment; file data chunks are
+ * only aligned to two bytes.
+ *   @out: The output arrays, one per channel.
+ *   @in: The packed input.
+ *   @fmt: The input sample format.
+ *   @nchan: The number of channels.
+ *   @len: The number of frames.
+ */
+
+_export
+void dsp_fmt2arr(double **out, const void *in, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int len)
+{
+	unsigned int i, n;
+
+	for(n = 0; n < nchan; n++) {
+		double *restrict dest = out[n];
+
+		switch(fmt) {
+		case dsp_fmt_s16:
+			{
+				const uint8_t *restrict src = (const uint8_t *)in + 2 * n;
+				int16_t v;
+
+				for(i = 0; i < len; i++) {
+					__builtin_memcpy(&v, src + 2 * i * nchan, sizeof(v));
+					dest[i] = v * (1.0 / 32768.0);
+				}
+			}
+			break;
+
+		case dsp_fmt_s24:
+			{
+				const uint8_t *restrict src = (const uint8_t *)in + 3 * n;
+
+				for(i = 0; i < len; i++, src += 3 * nchan)
+					dest[i] = ((int32_t)(((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 24)) >> 8) * (1.0 / 8388608.0);
+			}
+			break;
+
+		case dsp_fmt_s32:
+			{
+				const uint8_t *restrict src = (const uint8_t *)in + 4 * n;
+				int32_t v;
+
+				for(i = 0; i < len; i++) {
+					__builtin_memcpy(&v, src + 4 * i * nchan, sizeof(v));
+					dest[i] = v * (1.0 / 2147483648.0);
+				}
+			}
+			break;
+
+		case dsp_fmt_f32:
+			{
+				const uint8_t *restrict src = (const uint8_t *)in + 4 * n;
+				float v;
+
+				for(i = 0; i < len; i++) {
+					__builtin_memcpy(&v, src + 4 * i * nchan, sizeof(v));
+					dest[i] = v;
+				}
+			}
+			break;
+
+		case dsp_fmt_f64:
+			{
+				const uint8_t *restrict src = (const uint8_t *)in + 8 * n;
+
+				for(i = 0; i < len; i++)
+					__builtin_memcpy(&dest[i], src + 8 * i * nchan, sizeof(double));
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * Convert planar floating point arrays into packed interleaved samples.
+ * Integer outputs are clipped, and optionally dithered and noise shaped.
+ * Samples are stored bytewise, so the output needs no alignment.
+ *   @out: The packed output.
+ *   @in: The input arrays, one per channel.
+ *   @fmt: The output sample format.
+ *   @nchan: The number of channels.
+ *   @len: The number of frames.
+ *   @dither: Optional. The dither state, ignored for floating point formats.
+ */
+
+_export
+void dsp_arr2fmt(void *out, double **in, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int len, struct dsp_dither_t *dither)
+{
+	unsigned int i, n;
+
+	if((fmt != dsp_fmt_f32) && (fmt != dsp_fmt_f64)) {
+		arr2int(out, in, fmt, nchan, len, dither);
+		return;
+	}
+
+	for(n = 0; n < nchan; n++) {
+		const double *restrict src = in[n];
+
+		if(fmt == dsp_fmt_f32) {
+			uint8_t *restrict dest = (uint8_t *)out + 4 * n;
+			float v;
+
+			for(i = 0; i < len; i++) {
+				v = src[i];
+				__builtin_memcpy(dest + 4 * i * nchan, &v, sizeof(v));
+			}
+		}
+		else {
+			uint8_t *restrict dest = (uint8_t *)out + 8 * n;
+
+			for(i = 0; i < len; i++)
+				__builtin_memcpy(dest + 8 * i * nchan, &src[i], sizeof(double));
+		}
+	}
+}
+
+
+/**
+ * Create a dither state.
+ *   @nchan: The number of channels.
+ *   @order: The noise shaping order, zero for plain TPDF dither, or one or
+ *     two for first or second order high-pass shaping.
+ *   &returns: The dither state.
+ */
+
+_export
+struct dsp_dither_t *dsp_dither_new(unsigned int nchan, unsigned int order)
+{
+	unsigned int i;
+	struct dsp_dither_t *dither;
+
+	if(order > 2)
+		throw("Invalid noise shaping order.");
+
+	dither = mem_alloc(sizeof(struct dsp_dither_t) + 2 * nchan * sizeof(double));
+	dither->seed = 0x9E3779B9;
+	dither->order = order;
+	dither->nchan = nchan;
+
+	for(i = 0; i < 2 * nchan; i++)
+		dither->err[i] = 0.0;
+
+	return dither;
+}
+
+/**
+ * Delete a dither state.
+ *   @dither: The dither state.
+ */
+
+_export
+void dsp_dither_delete(struct dsp_dither_t *dither)
+{
+	mem_free(dither);
+}
+
+
+/**
+ * Convert planar arrays to a packed integer format.
+ *   @out: The packed output.
+ *   @in: The input arrays.
+ *   @fmt: The integer format.
+ *   @nchan: The number of channels.
+ *   @len: The number of frames.
+ *   @dither: Optional. The dither state.
+ */
+
+static void arr2int(void *out, double **in, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int len, struct dsp_dither_t *dither)
+{
+	unsigned int i, n;
+	double scale, max, min;
+	int16_t h;
+	int32_t v;
+
+	switch(fmt) {
+	case dsp_fmt_s16: scale = 32768.0; break;
+	case dsp_fmt_s24: scale = 8388608.0; break;
+	default: scale = 2147483648.0; break;
+	}
+
+	max = scale - 1.0;
+	min = -scale;
+
+	if((dither != NULL) && (dither->nchan < nchan))
+		throw("Dither channel count mismatch.");
+
+	for(n = 0; n < nchan; n++) {
+		const double *restrict src = in[n];
+
+		if(dither == NULL) {
+			if(fmt == dsp_fmt_s16) {
+				uint8_t *restrict dest = (uint8_t *)out + 2 * n;
+
+				for(i = 0; i < len; i++) {
+					double x = src[i] * scale;
+
+					x = (x > max) ? max : ((x < min) ? min : x);
+					h = (int16_t)(x + ((x < 0.0) ? -0.5 : 0.5));
+					__builtin_memcpy(dest + 2 * i * nchan, &h, sizeof(h));
+				}
+			}
+			else if(fmt == dsp_fmt_s32) {
+				uint8_t *restrict dest = (uint8_t *)out + 4 * n;
+
+				for(i = 0; i < len; i++) {
+					double x = src[i] * scale;
+
+					x = (x > max) ? max : ((x < min) ? min : x);
+					v = (int32_t)(x + ((x < 0.0) ? -0.5 : 0.5));
+					__builtin_memcpy(dest + 4 * i * nchan, &v, sizeof(v));
+				}
+			}
+			else {
+				uint8_t *restrict dest = (uint8_t *)out + 3 * n;
+
+				for(i = 0; i < len; i++, dest += 3 * nchan) {
+					double x = src[i] * scale;
+
+					x = (x > max) ? max : ((x < min) ? min : x);
+					v = (int32_t)(x + ((x < 0.0) ? -0.5 : 0.5));
+					dest[0] = v;
+					dest[1] = v >> 8;
+					dest[2] = v >> 16;
+				}
+			}
+		}
+		else {
+			double w, x, y, *err = dither->err + 2 * n;
+
+			for(i = 0; i < len; i++) {
+				w = src[i] * scale;
+				if(dither->order == 1)
+					w -= err[0];
+				else if(dither->order == 2)
+					w -= 2.0 * err[0] - err[1];
+
+				x = w + rand_unit(&dither->seed) - rand_unit(&dither->seed);
+				y = floor(x + 0.5);
+
+				err[1] = err[0];
+				err[0] = y - w;
+
+				v = (y > max) ? max : ((y < min) ? min : y);
+
+				if(fmt == dsp_fmt_s16) {
+					h = v;
+					__builtin_memcpy((uint8_t *)out + 2 * (i * nchan + n), &h, sizeof(h));
+				}
+				else if(fmt == dsp_fmt_s32)
+					__builtin_memcpy((uint8_t *)out + 4 * (i * nchan + n), &v, sizeof(v));
+				else {
+					uint8_t *dest = (uint8_t *)out + 3 * (i * nchan + n);
+
+					dest[0] = v;
+					dest[1] = v >> 8;
+					dest[2] = v >> 16;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Generate a uniform random value in the range zero to one.
+ *   @seed: The random state.
+ *   &returns: The random value.
+ */
+
+static inline double rand_unit(uint32_t *seed)
+{
+	uint32_t x = *seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+
+	return x * (1.0 / 4294967296.0);
+}
@@ -7,12 +7,24 @@
 
 /* %dsp.h% */
 
+/*
+ * structure prototypes
+ */
+
+struct dsp_dither_t;
+
 /*
  * conversion function declarations
  */
 
 unsigned int dsp_int2len(unsigned int inrate, unsigned int outrate, unsigned int len, unsigned int nchan);
-void dsp_conf_int2arr(double *in, unsigned int inrate, double **out, unsigned int outrate, unsigned int nchan);
+unsigned int dsp_int2arr(double *in, unsigned int inrate, double **out, unsigned int outrate, unsigned int len, unsigned int nchan);
+
+void dsp_fmt2arr(double **out, const void *in, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int len);
+void dsp_arr2fmt(void *out, double **in, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int len, struct dsp_dither_t *dither);
+
+struct dsp_dither_t *dsp_dither_new(unsigned int nchan, unsigned int order);
+void dsp_dither_delete(struct dsp_dither_t *dither);
 
 /* %~dsp.h% */
 
@@ -0,0 +1,468 @@
+#include "common.h"
+#include "convolve.h"
+#include "fft.h"
+
+
+/**
+ * Partition level structure. Each level convolves a contiguous region of the
+ * impulse response using uniform partitions of its block size, keeping the
+ * input spectra in a frequency-domain delay line. Levels past the first run
+ * on their own worker thread.
+ *   @conv: The parent convolver.
+ *   @blk, npart, off: The block size, partition count, and tap offset.
+ *   @head: The delay line write index.
+ *   @fft: The transform, twice the block size.
+ *   @ir, fdl: The response and delay line spectra, 'npart' per channel.
+ *   @acc: The accumulator scratch.
+ *   @in: The job input, two blocks per channel.
+ *   @out: The double-buffered job output, one block per channel.
+ *   @slot: The output slot of the pending job.
+ *   @thread: The worker thread.
+ *   @lock: The job lock.
+ *   @sync, done: The job posted and job completed conditions.
+ *   @seq, fin: The posted and completed job counts.
+ *   @quit: The shutdown flag.
+ */
+
+struct conv_level_t {
+	struct dsp_convolve_t *conv;
+
+	unsigned int blk, npart, off, head;
+	struct dsp_fft_t *fft;
+	double *ir, *fdl, *acc;
+
+	double *in, *out[2];
+	unsigned int slot;
+
+	struct thread_t *thread;
+	struct thread_mutex_t lock;
+	struct thread_cond_t sync, done;
+	unsigned int seq, fin;
+	bool quit;
+};
+
+/**
+ * Partitioned convolution structure.
+ *   @nchan, blk: The channel count and the first block size.
+ *   @t, pos: The number of complete input blocks in samples and the
+ *     position within the current block.
+ *   @mask: The history index mask.
+ *   @hist: The input history, 'mask + 1' samples per channel.
+ *   @win: The first level window scratch.
+ *   @out: The output of the current block, one block per channel.
+ *   @late: The number of tail jobs not complete by their deadline.
+ *   @nlevel: The number of levels.
+ *   @level: The levels.
+ */
+
+struct dsp_convolve_t {
+	unsigned int nchan, blk;
+	uint64_t t;
+	unsigned int pos;
+
+	unsigned int mask;
+	double *hist, *win, *out;
+
+	uint64_t late;
+
+	unsigned int nlevel;
+	struct conv_level_t *level;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void level_init(struct conv_level_t *level, struct dsp_convolve_t *conv, double **ir, unsigned int blk, unsigned int off, unsigned int end);
+static void level_destroy(struct conv_level_t *level);
+static void level_exec(struct conv_level_t *level, unsigned int ch, const double *win, double *out);
+static void level_wait(struct conv_level_t *level);
+static void *level_proc(void *arg);
+
+static void conv_block(struct dsp_convolve_t *conv);
+static void conv_window(struct dsp_convolve_t *conv, unsigned int ch, uint64_t end, unsigned int len, double *out);
+
+
+/**
+ * Create a partitioned convolver. The first level uses the given block size
+ * and runs in the caller; each further level quadruples the block size, up
+ * to 'DSP_CONVOLVE_MAXBLK', and runs on a worker thread with one block of
+ * its own size as its deadline.
+ *   @ir: The impulse responses, one per channel.
+ *   @len: The impulse response length.
+ *   @nchan: The number of channels.
+ *   @blk: The first block size, a power of two. This is the latency.
+ *   &returns: The convolver.
+ */
+
+_export
+struct dsp_convolve_t *dsp_convolve_new(double **ir, unsigned int len, unsigned int nchan, unsigned int blk)
+{
+	unsigned int i, off, end, max;
+	struct dsp_convolve_t *conv;
+
+	if((blk < 2) || (blk & (blk - 1)))
+		throw("Invalid convolution block size %u.", blk);
+
+	if(len == 0)
+		throw("Empty impulse response.");
+
+	conv = mem_alloc(sizeof(struct dsp_convolve_t));
+	conv->nchan = nchan;
+	conv->blk = blk;
+	conv->t = 0;
+	conv->pos = 0;
+	conv->late = 0;
+	conv->nlevel = 0;
+	conv->level = NULL;
+
+	for(off = 0, max = blk; off < len; off = end, blk *= 4) {
+		end = ((4 * blk) <= DSP_CONVOLVE_MAXBLK) ? (8 * blk) : len;
+		end = (end < len) ? end : len;
+
+		conv->level = mem_realloc(conv->level, (conv->nlevel + 1) * sizeof(struct conv_level_t));
+		level_init(&conv->level[conv->nlevel++], conv, ir, blk, off, end);
+		max = blk;
+	}
+
+	for(conv->mask = 1; conv->mask < 2 * max; conv->mask *= 2);
+
+	conv->hist = mem_alloc(nchan * conv->mask * sizeof(double));
+	mem_set(conv->hist, 0x00, nchan * conv->mask * sizeof(double));
+	conv->mask--;
+
+	conv->win = mem_alloc(2 * conv->blk * sizeof(double));
+	conv->out = mem_alloc(nchan * conv->blk * sizeof(double));
+	mem_set(conv->out, 0x00, nchan * conv->blk * sizeof(double));
+
+	for(i = 1; i < conv->nlevel; i++)
+		conv->level[i].thread = thread_new(level_proc, &conv->level[i], NULL);
+
+	return conv;
+}
+
+/**
+ * Delete a partitioned convolver.
+ *   @conv: The convolver.
+ */
+
+_export
+void dsp_convolve_delete(struct dsp_convolve_t *conv)
+{
+	unsigned int i;
+
+	for(i = 0; i < conv->nlevel; i++)
+		level_destroy(&conv->level[i]);
+
+	mem_free(conv->level);
+	mem_free(conv->hist);
+	mem_free(conv->win);
+	mem_free(conv->out);
+	mem_free(conv);
+}
+
+
+/**
+ * Process data through the convolver. The output is delayed by the first
+ * block size. The input and output may be the same buffers.
+ *   @conv: The convolver.
+ *   @in: The input, one array per channel.
+ *   @out: The output, one array per channel.
+ *   @len: The length.
+ */
+
+_export
+void dsp_convolve_proc(struct dsp_convolve_t *conv, double **in, double **out, unsigned int len)
+{
+	unsigned int i, j, n, idx = 0;
+
+	while(idx < len) {
+		n = conv->blk - conv->pos;
+		n = (n < (len - idx)) ? n : (len - idx);
+
+		for(i = 0; i < conv->nchan; i++) {
+			double *hist = conv->hist + i * (conv->mask + 1);
+
+			for(j = 0; j < n; j++)
+				hist[(conv->t + conv->pos + j) & conv->mask] = in[i][idx + j];
+
+			mem_copy(out[i] + idx, conv->out + i * conv->blk + conv->pos, n * sizeof(double));
+		}
+
+		idx += n;
+		conv->pos += n;
+
+		if(conv->pos == conv->blk) {
+			conv->t += conv->blk;
+			conv->pos = 0;
+			conv_block(conv);
+		}
+	}
+}
+
+
+/**
+ * Retrieve the latency of the convolver.
+ *   @conv: The convolver.
+ *   &returns: The latency in samples.
+ */
+
+_export
+unsigned int dsp_convolve_latency(struct dsp_convolve_t *conv)
+{
+	return conv->blk;
+}
+
+/**
+ * Retrieve the number of tail jobs that missed their deadline. The caller
+ * waits for a late job, so output remains exact.
+ *   @conv: The convolver.
+ *   &returns: The count.
+ */
+
+_export
+uint64_t dsp_convolve_late(struct dsp_convolve_t *conv)
+{
+	return conv->late;
+}
+
+
+/**
+ * Initialize a level, transforming its region of the impulse responses.
+ *   @level: The level.
+ *   @conv: The parent convolver.
+ *   @ir: The impulse responses.
+ *   @blk: The block size.
+ *   @off, end: The tap region.
+ */
+
+static void level_init(struct conv_level_t *level, struct dsp_convolve_t *conv, double **ir, unsigned int blk, unsigned int off, unsigned int end)
+{
+	unsigned int i, p, n, size = 2 * (blk + 1), nchan = conv->nchan;
+	double *spec;
+
+	level->conv = conv;
+	level->blk = blk;
+	level->npart = (end - off + blk - 1) / blk;
+	level->off = off;
+	level->head = 0;
+	level->fft = dsp_fft_new(2 * blk);
+
+	level->ir = mem_alloc(nchan * level->npart * size * sizeof(double));
+	level->fdl = mem_alloc(nchan * level->npart * size * sizeof(double));
+	level->acc = mem_alloc(size * sizeof(double));
+	mem_set(level->fdl, 0x00, nchan * level->npart * size * sizeof(double));
+
+	for(i = 0; i < nchan; i++) {
+		for(p = 0; p < level->npart; p++) {
+			spec = level->ir + (i * level->npart + p) * size;
+			mem_set(spec, 0x00, size * sizeof(double));
+
+			n = off + p * blk;
+			n = ((end - n) < blk) ? (end - n) : blk;
+			mem_copy(spec, ir[i] + off + p * blk, n * sizeof(double));
+
+			for(n = 0; n < blk; n++)
+				spec[n] /= 2 * blk;
+
+			dsp_fft_fwd(level->fft, spec, spec);
+		}
+	}
+
+	level->in = mem_alloc(nchan * 2 * blk * sizeof(double));
+	level->out[0] = mem_alloc(nchan * blk * sizeof(double));
+	level->out[1] = mem_alloc(nchan * blk * sizeof(double));
+	mem_set(level->out[0], 0x00, nchan * blk * sizeof(double));
+	mem_set(level->out[1], 0x00, nchan * blk * sizeof(double));
+	level->slot = 0;
+
+	level->thread = NULL;
+	level->lock = thread_mutex_new(NULL);
+	level->sync = thread_cond_new(NULL);
+	level->done = thread_cond_new(NULL);
+	level->seq = level->fin = 0;
+	level->quit = false;
+}
+
+/**
+ * Destroy a level, stopping its worker.
+ *   @level: The level.
+ */
+
+static void level_destroy(struct conv_level_t *level)
+{
+	if(level->thread != NULL) {
+		thread_mutex_lock(&level->lock);
+		level->quit = true;
+		thread_cond_signal(&level->sync);
+		thread_mutex_unlock(&level->lock);
+
+		thread_join(level->thread);
+	}
+
+	thread_cond_delete(&level->sync);
+	thread_cond_delete(&level->done);
+	thread_mutex_delete(&level->lock);
+
+	dsp_fft_delete(level->fft);
+	mem_free(level->ir);
+	mem_free(level->fdl);
+	mem_free(level->acc);
+	mem_free(level->in);
+	mem_free(level->out[0]);
+	mem_free(level->out[1]);
+}
+
+/**
+ * Execute one block of a level for a channel. The window spectrum enters the
+ * delay line and is multiplied against every partition; the second half of
+ * the inverse transform is the output.
+ *   @level: The level.
+ *   @ch: The channel.
+ *   @win: The input window, two blocks.
+ *   @out: The output, one block.
+ */
+
+static void level_exec(struct conv_level_t *level, unsigned int ch, const double *win, double *out)
+{
+	unsigned int p, blk = level->blk, size = 2 * (blk + 1), npart = level->npart;
+	double *fdl = level->fdl + ch * npart * size, *ir = level->ir + ch * npart * size;
+
+	dsp_fft_fwd(level->fft, win, fdl + level->head * size);
+	mem_set(level->acc, 0x00, size * sizeof(double));
+
+	for(p = 0; p < npart; p++)
+		dsp_fft_mac(level->acc, fdl + ((level->head + npart - p) % npart) * size, ir + p * size, blk + 1);
+
+	dsp_fft_inv(level->fft, level->acc, level->acc);
+	mem_copy(out, level->acc + blk, blk * sizeof(double));
+}
+
+/**
+ * Wait for the pending job of a level, counting it if late.
+ *   @level: The level.
+ */
+
+static void level_wait(struct conv_level_t *level)
+{
+	thread_mutex_lock(&level->lock);
+
+	if(level->fin != level->seq)
+		level->conv->late++;
+
+	while(level->fin != level->seq)
+		thread_cond_wait(&level->done, &level->lock);
+
+	thread_mutex_unlock(&level->lock);
+}
+
+/**
+ * Level worker thread.
+ *   @arg: The level.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *level_proc(void *arg)
+{
+	bool quit;
+	unsigned int i;
+	struct conv_level_t *level = arg;
+	struct dsp_convolve_t *conv = level->conv;
+
+	while(true) {
+		thread_mutex_lock(&level->lock);
+
+		while((level->fin == level->seq) && !level->quit)
+			thread_cond_wait(&level->sync, &level->lock);
+
+		quit = level->quit;
+		thread_mutex_unlock(&level->lock);
+
+		if(quit)
+			break;
+
+		for(i = 0; i < conv->nchan; i++)
+			level_exec(level, i, level->in + i * 2 * level->blk, level->out[level->slot] + i * level->blk);
+
+		level->head = (level->head + 1) % level->npart;
+
+		thread_mutex_lock(&level->lock);
+		level->fin++;
+		thread_cond_signal(&level->done);
+		thread_mutex_unlock(&level->lock);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Process a complete input block. The first level is computed directly; the
+ * output of each tail level is read from the slot written one job earlier,
+ * and tail levels at a block boundary wait for their previous job before
+ * posting the next.
+ *   @conv: The convolver.
+ */
+
+static void conv_block(struct dsp_convolve_t *conv)
+{
+	unsigned int i, j, k, o, blk = conv->blk;
+	uint64_t s, t = conv->t;
+	struct conv_level_t *level;
+
+	for(i = 0; i < conv->nchan; i++) {
+		conv_window(conv, i, t, 2 * blk, conv->win);
+		level_exec(&conv->level[0], i, conv->win, conv->out + i * blk);
+	}
+
+	conv->level[0].head = (conv->level[0].head + 1) % conv->level[0].npart;
+
+	for(k = 1; k < conv->nlevel; k++) {
+		level = &conv->level[k];
+		s = (t - blk) / level->blk;
+		o = (t - blk) % level->blk;
+
+		for(i = 0; i < conv->nchan; i++) {
+			double *dest = conv->out + i * blk;
+			const double *src = level->out[(s + 1) & 1] + i * level->blk + o;
+
+			for(j = 0; j < blk; j++)
+				dest[j] += src[j];
+		}
+
+		if((t % level->blk) != 0)
+			continue;
+
+		level_wait(level);
+
+		for(i = 0; i < conv->nchan; i++)
+			conv_window(conv, i, t, 2 * level->blk, level->in + i * 2 * level->blk);
+
+		thread_mutex_lock(&level->lock);
+		level->slot = (t / level->blk) & 1;
+		level->seq++;
+		thread_cond_signal(&level->sync);
+		thread_mutex_unlock(&level->lock);
+	}
+}
+
+/**
+ * Copy a window of the input history.
+ *   @conv: The convolver.
+ *   @ch: The channel.
+ *   @end: The end of the window in samples.
+ *   @len: The window length.
+ *   @out: The output.
+ */
+
+static void conv_window(struct dsp_convolve_t *conv, unsigned int ch, uint64_t end, unsigned int len, double *out)
+{
+	unsigned int n, idx = (end - len) & conv->mask;
+	const double *hist = conv->hist + ch * (conv->mask + 1);
+
+	n = conv->mask + 1 - idx;
+	n = (n < len) ? n : len;
+	mem_copy(out, hist + idx, n * sizeof(double));
+	mem_copy(out + n, hist, (len - n) * sizeof(double));
+}
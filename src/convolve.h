@@ -0,0 +1,41 @@
+#ifndef CONVOLVE_H
+#define CONVOLVE_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * partitioned convolution definitions
+ */
+
+#define DSP_CONVOLVE_MAXBLK 8192
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_convolve_t;
+
+/*
+ * partitioned convolution function declarations
+ */
+
+struct dsp_convolve_t *dsp_convolve_new(double **ir, unsigned int len, unsigned int nchan, unsigned int blk);
+void dsp_convolve_delete(struct dsp_convolve_t *conv);
+
+void dsp_convolve_proc(struct dsp_convolve_t *conv, double **in, double **out, unsigned int len);
+
+unsigned int dsp_convolve_latency(struct dsp_convolve_t *conv);
+uint64_t dsp_convolve_late(struct dsp_convolve_t *conv);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
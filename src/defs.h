@@ -7,6 +7,13 @@
 
 /* %dsp.h% */
 
+/*
+ * common definitions
+ */
+
+#define DSP_CACHELINE 64
+
+
 /**
  * Non-blocking reader lock structure.
  *   @mutex: The writer mutex.
@@ -43,6 +50,43 @@ struct dsp_pt_t {
 	double a;
 };
 
+
+/**
+ * Sample format enumerator.
+ *   @dsp_fmt_s16: Signed 16-bit integer.
+ *   @dsp_fmt_s24: Signed 24-bit packed integer.
+ *   @dsp_fmt_s32: Signed 32-bit integer.
+ *   @dsp_fmt_f32: 32-bit floating point.
+ *   @dsp_fmt_f64: 64-bit floating point.
+ */
+
+enum dsp_fmt_e {
+	dsp_fmt_s16,
+	dsp_fmt_s24,
+	dsp_fmt_s32,
+	dsp_fmt_f32,
+	dsp_fmt_f64
+};
+
+/**
+ * Retrieve the size of a sample format.
+ *   @fmt: The format.
+ *   &returns: The size in bytes.
+ */
+
+static inline unsigned int dsp_fmt_size(enum dsp_fmt_e fmt)
+{
+	switch(fmt) {
+	case dsp_fmt_s16: return 2;
+	case dsp_fmt_s24: return 3;
+	case dsp_fmt_s32: return 4;
+	case dsp_fmt_f32: return 4;
+	case dsp_fmt_f64: return 8;
+	}
+
+	return 0;
+}
+
 /* %~dsp.h% */
 
 /*
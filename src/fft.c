@@ -0,0 +1,247 @@
+#include "common.h"
+#include "fft.h"
+
+
+/**
+ * Real FFT structure. A real transform of length 'len' is computed as a
+ * complex transform of half the length followed by a split step. Spectra are
+ * stored as 'len / 2 + 1' interleaved complex bins.
+ *   @len, half: The real length and the complex length.
+ *   @rev: The bit reversal table for the complex transform.
+ *   @tw: The complex transform twiddles, 'half / 2' complex values.
+ *   @split: The split step twiddles, 'half / 2 + 1' complex values.
+ */
+
+struct dsp_fft_t {
+	unsigned int len, half;
+
+	unsigned int *rev;
+	double *tw, *split;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void fft_cplx(struct dsp_fft_t *fft, double *data, bool inv);
+
+
+/**
+ * Create a real FFT.
+ *   @len: The transform length, a power of two no less than four.
+ *   &returns: The FFT.
+ */
+
+_export
+struct dsp_fft_t *dsp_fft_new(unsigned int len)
+{
+	unsigned int i, j, bits;
+	struct dsp_fft_t *fft;
+
+	if((len < 4) || (len & (len - 1)))
+		throw("Invalid FFT length %u.", len);
+
+	fft = mem_alloc(sizeof(struct dsp_fft_t));
+	fft->len = len;
+	fft->half = len / 2;
+	fft->rev = mem_alloc(fft->half * sizeof(unsigned int));
+	fft->tw = mem_alloc(fft->half * sizeof(double));
+	fft->split = mem_alloc((fft->half + 2) * sizeof(double));
+
+	for(bits = 0; (1u << bits) < fft->half; bits++);
+
+	for(i = 0; i < fft->half; i++) {
+		for(fft->rev[i] = 0, j = 0; j < bits; j++)
+			fft->rev[i] |= ((i >> j) & 1) << (bits - j - 1);
+	}
+
+	for(i = 0; i < fft->half / 2; i++) {
+		fft->tw[2 * i] = cos(2.0 * M_PI * i / fft->half);
+		fft->tw[2 * i + 1] = -sin(2.0 * M_PI * i / fft->half);
+	}
+
+	for(i = 0; i <= fft->half / 2; i++) {
+		fft->split[2 * i] = cos(2.0 * M_PI * i / len);
+		fft->split[2 * i + 1] = -sin(2.0 * M_PI * i / len);
+	}
+
+	return fft;
+}
+
+/**
+ * Delete a real FFT.
+ *   @fft: The FFT.
+ */
+
+_export
+void dsp_fft_delete(struct dsp_fft_t *fft)
+{
+	mem_free(fft->rev);
+	mem_free(fft->tw);
+	mem_free(fft->split);
+	mem_free(fft);
+}
+
+
+/**
+ * Retrieve the transform length.
+ *   @fft: The FFT.
+ *   &returns: The length.
+ */
+
+_export
+unsigned int dsp_fft_len(struct dsp_fft_t *fft)
+{
+	return fft->len;
+}
+
+/**
+ * Compute the forward transform.
+ *   @fft: The FFT.
+ *   @in: The input, 'len' real values.
+ *   @out: The output spectrum, 'len + 2' values. May equal the input if it
+ *     has room for the spectrum.
+ */
+
+_export
+void dsp_fft_fwd(struct dsp_fft_t *fft, const double *in, double *out)
+{
+	unsigned int k, m = fft->half;
+	double er, ei, or, oi, wr, wi, tr, ti;
+
+	if(out != in)
+		mem_copy(out, in, fft->len * sizeof(double));
+
+	fft_cplx(fft, out, false);
+
+	er = out[0];
+	ei = out[1];
+	out[0] = er + ei;
+	out[1] = 0.0;
+	out[2 * m] = er - ei;
+	out[2 * m + 1] = 0.0;
+
+	for(k = 1; k <= m / 2; k++) {
+		double *a = out + 2 * k, *b = out + 2 * (m - k);
+
+		er = 0.5 * (a[0] + b[0]);
+		ei = 0.5 * (a[1] - b[1]);
+		or = 0.5 * (a[1] + b[1]);
+		oi = -0.5 * (a[0] - b[0]);
+
+		wr = fft->split[2 * k];
+		wi = fft->split[2 * k + 1];
+		tr = wr * or - wi * oi;
+		ti = wr * oi + wi * or;
+
+		a[0] = er + tr;
+		a[1] = ei + ti;
+		b[0] = er - tr;
+		b[1] = -(ei - ti);
+	}
+}
+
+/**
+ * Compute the unscaled inverse transform, so that a forward and inverse
+ * pair scales the data by the length.
+ *   @fft: The FFT.
+ *   @in: The input spectrum, 'len + 2' values. It is overwritten.
+ *   @out: The output, 'len' real values. May equal the input.
+ */
+
+_export
+void dsp_fft_inv(struct dsp_fft_t *fft, double *in, double *out)
+{
+	unsigned int k, m = fft->half;
+	double er, ei, or, oi, wr, wi, tr, ti;
+
+	er = in[0] + in[2 * m];
+	or = in[0] - in[2 * m];
+	in[0] = er;
+	in[1] = or;
+
+	for(k = 1; k <= m / 2; k++) {
+		double *a = in + 2 * k, *b = in + 2 * (m - k);
+
+		er = a[0] + b[0];
+		ei = a[1] - b[1];
+		tr = a[0] - b[0];
+		ti = a[1] + b[1];
+
+		wr = fft->split[2 * k];
+		wi = -fft->split[2 * k + 1];
+		or = tr * wr - ti * wi;
+		oi = tr * wi + ti * wr;
+
+		a[0] = er - oi;
+		a[1] = ei + or;
+		b[0] = er + oi;
+		b[1] = -ei + or;
+	}
+
+	fft_cplx(fft, in, true);
+
+	if(out != in)
+		mem_copy(out, in, fft->len * sizeof(double));
+}
+
+
+/**
+ * Multiply two spectra and accumulate the product.
+ *   @acc: The accumulator.
+ *   @x: The first spectrum.
+ *   @h: The second spectrum.
+ *   @len: The number of complex bins.
+ */
+
+_export
+void dsp_fft_mac(double *restrict acc, const double *restrict x, const double *restrict h, unsigned int len)
+{
+	unsigned int i;
+
+	for(i = 0; i < 2 * len; i += 2) {
+		acc[i] += x[i] * h[i] - x[i + 1] * h[i + 1];
+		acc[i + 1] += x[i] * h[i + 1] + x[i + 1] * h[i];
+	}
+}
+
+
+/**
+ * Compute an in-place radix-2 complex transform.
+ *   @fft: The FFT.
+ *   @data: The interleaved complex data, 'half' values.
+ *   @inv: Compute the inverse transform.
+ */
+
+static void fft_cplx(struct dsp_fft_t *fft, double *data, bool inv)
+{
+	unsigned int i, j, k, n, step, m = fft->half;
+	double sign = inv ? -1.0 : 1.0, wr, wi, tr, ti, t;
+
+	for(i = 0; i < m; i++) {
+		j = fft->rev[i];
+		if(j > i) {
+			t = data[2 * i], data[2 * i] = data[2 * j], data[2 * j] = t;
+			t = data[2 * i + 1], data[2 * i + 1] = data[2 * j + 1], data[2 * j + 1] = t;
+		}
+	}
+
+	for(n = 1, step = m / 2; n < m; n *= 2, step /= 2) {
+		for(k = 0; k < n; k++) {
+			wr = fft->tw[2 * k * step];
+			wi = sign * fft->tw[2 * k * step + 1];
+
+			for(i = k; i < m; i += 2 * n) {
+				double *a = data + 2 * i, *b = data + 2 * (i + n);
+
+				tr = b[0] * wr - b[1] * wi;
+				ti = b[0] * wi + b[1] * wr;
+				b[0] = a[0] - tr;
+				b[1] = a[1] - ti;
+				a[0] += tr;
+				a[1] += ti;
+			}
+		}
+	}
+}
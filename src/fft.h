@@ -0,0 +1,36 @@
+#ifndef FFT_H
+#define FFT_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_fft_t;
+
+
+/*
+ * fft function declarations
+ */
+
+struct dsp_fft_t *dsp_fft_new(unsigned int len);
+void dsp_fft_delete(struct dsp_fft_t *fft);
+
+unsigned int dsp_fft_len(struct dsp_fft_t *fft);
+void dsp_fft_fwd(struct dsp_fft_t *fft, const double *in, double *out);
+void dsp_fft_inv(struct dsp_fft_t *fft, double *in, double *out);
+
+void dsp_fft_mac(double *restrict acc, const double *restrict x, const double *restrict h, unsigned int len);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -0,0 +1,463 @@
+#include "../common.h"
+#include "auto.h"
+#include "fir.h"
+#include "../convolve.h"
+#include "../fft.h"
+#include "../simd.h"
+#include <time.h>
+
+
+/*
+ * automatic fir definitions
+ */
+
+#define BLKLEN 256
+#define MAGIC "dsp-auto-1"
+
+
+/**
+ * Dense engine structure.
+ *   @len: The number of taps.
+ *   @wr, cap: The next history write index and the capacity.
+ *   @coef: The reversed coefficients.
+ *   @hist: The input history.
+ */
+
+struct auto_dense_t {
+	unsigned int len;
+	unsigned int wr, cap;
+	double *coef, *hist;
+};
+
+/**
+ * Automatic FIR structure.
+ *   @kind: The selected engine.
+ *   @fir: The sparse engine.
+ *   @dense: The dense engine, or the head of the FFT engine.
+ *   @conv: The FFT engine tail.
+ */
+
+struct dsp_filter_auto_t {
+	enum dsp_filter_auto_e kind;
+
+	struct dsp_filter_fir_t *fir;
+	struct auto_dense_t dense;
+	struct dsp_convolve_t *conv;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void dense_init(struct auto_dense_t *dense, const double *coef, unsigned int len);
+static void dense_destroy(struct auto_dense_t *dense);
+static void dense_proc(struct auto_dense_t *dense, const double *in, double *out, unsigned int len);
+
+static double cost_fft(unsigned int len, unsigned int blk);
+
+static bool model_load(const char *path);
+static void model_save(const char *path);
+static double model_time(void);
+
+/*
+ * global variables
+ */
+
+static struct dsp_filter_auto_model_t model = { 0.35, 0.55, 1.5, 1.7 };
+
+
+/**
+ * Create an automatic FIR filter. Like 'dsp_filter_sparse_fir', each point
+ * adds its value times the input delayed by its offset to the direct input.
+ * The engine with the lowest modelled cost per sample is selected.
+ *   @pt: The point set.
+ *   @npts: The number of points.
+ *   @blk: The expected block length, a power of two. It is the first
+ *     partition of the FFT engine, which adds no latency and is not
+ *     considered for a block length of one.
+ *   &returns: The filter.
+ */
+
+_export
+struct dsp_filter_auto_t *dsp_filter_auto_new(const struct dsp_pt_t *pt, unsigned int npts, unsigned int blk)
+{
+	unsigned int i, len = 1;
+	double *coef, sparse, dense, fft;
+	struct dsp_filter_auto_t *filt;
+
+	if((blk == 0) || (blk & (blk - 1)))
+		throw("Invalid block length %u.", blk);
+
+	for(i = 0; i < npts; i++)
+		len = (pt[i].n + 1 > len) ? (pt[i].n + 1) : len;
+
+	sparse = model.sparse * npts;
+	dense = model.dense * len;
+	fft = ((blk >= 2) && (len > 2 * blk)) ? cost_fft(len, blk) : INFINITY;
+
+	filt = mem_alloc(sizeof(struct dsp_filter_auto_t));
+	filt->fir = NULL;
+	filt->conv = NULL;
+	filt->dense.len = 0;
+
+	if((sparse <= dense) && (sparse <= fft)) {
+		filt->kind = dsp_filter_auto_sparse;
+		filt->fir = dsp_filter_fir_new(pt, npts);
+
+		return filt;
+	}
+
+	coef = mem_alloc(len * sizeof(double));
+	mem_set(coef, 0x00, len * sizeof(double));
+
+	for(coef[0] = 1.0, i = 0; i < npts; i++)
+		coef[pt[i].n] += pt[i].a;
+
+	if(dense <= fft) {
+		filt->kind = dsp_filter_auto_dense;
+		dense_init(&filt->dense, coef, len);
+	}
+	else {
+		double *tail = coef + blk;
+
+		filt->kind = dsp_filter_auto_fft;
+		dense_init(&filt->dense, coef, blk);
+		filt->conv = dsp_convolve_new(&tail, len - blk, 1, blk);
+	}
+
+	mem_free(coef);
+
+	return filt;
+}
+
+/**
+ * Delete an automatic FIR filter.
+ *   @filt: The filter.
+ */
+
+_export
+void dsp_filter_auto_delete(struct dsp_filter_auto_t *filt)
+{
+	if(filt->fir != NULL)
+		dsp_filter_fir_delete(filt->fir);
+
+	if(filt->conv != NULL)
+		dsp_convolve_delete(filt->conv);
+
+	if(filt->dense.len > 0)
+		dense_destroy(&filt->dense);
+
+	mem_free(filt);
+}
+
+
+/**
+ * Retrieve the selected engine.
+ *   @filt: The filter.
+ *   &returns: The engine.
+ */
+
+_export
+enum dsp_filter_auto_e dsp_filter_auto_kind(struct dsp_filter_auto_t *filt)
+{
+	return filt->kind;
+}
+
+/**
+ * Process a block through the automatic FIR filter. The input and output may
+ * be the same buffer.
+ *   @filt: The filter.
+ *   @in: The input.
+ *   @out: The output.
+ *   @len: The length.
+ */
+
+_export
+void dsp_filter_auto_proc(struct dsp_filter_auto_t *filt, const double *in, double *out, unsigned int len)
+{
+	unsigned int i, n;
+	double tmp[BLKLEN], *ptr;
+
+	switch(filt->kind) {
+	case dsp_filter_auto_sparse:
+		dsp_filter_fir_proc(filt->fir, in, out, len);
+		break;
+
+	case dsp_filter_auto_dense:
+		dense_proc(&filt->dense, in, out, len);
+		break;
+
+	case dsp_filter_auto_fft:
+		for(; len > 0; in += n, out += n, len -= n) {
+			n = (len < BLKLEN) ? len : BLKLEN;
+			ptr = tmp;
+
+			dsp_convolve_proc(filt->conv, (double **)&in, &ptr, n);
+			dense_proc(&filt->dense, in, out, n);
+
+			for(i = 0; i < n; i++)
+				out[i] += tmp[i];
+		}
+
+		break;
+	}
+}
+
+
+/**
+ * Retrieve the current cost model.
+ *   &returns: The model.
+ */
+
+_export
+struct dsp_filter_auto_model_t dsp_filter_auto_model(void)
+{
+	return model;
+}
+
+/**
+ * Calibrate the cost model for this machine. A model previously saved to
+ * the path is loaded; otherwise each engine is timed and the result saved.
+ * Call before creating filters from other threads.
+ *   @path: Optional. The cache file path.
+ */
+
+_export
+void dsp_filter_auto_calib(const char *path)
+{
+	unsigned int i, k;
+	double t, best;
+	double *in, *out, *spec;
+	struct dsp_pt_t pt[64];
+	struct dsp_filter_fir_t *fir;
+	struct auto_dense_t dense;
+	struct dsp_fft_t *fft;
+
+	if((path != NULL) && model_load(path))
+		return;
+
+	in = mem_alloc(4 * BLKLEN * sizeof(double));
+	out = mem_alloc(4 * BLKLEN * sizeof(double));
+	spec = mem_alloc(2 * 1026 * sizeof(double));
+
+	for(i = 0; i < 4 * BLKLEN; i++)
+		in[i] = sin(0.1 * i);
+
+	for(i = 0; i < 64; i++)
+		pt[i] = (struct dsp_pt_t){ 1 + (i * 4099) % 4096, 0.001 * i };
+
+	fir = dsp_filter_fir_new(pt, 64);
+	for(best = INFINITY, k = 0; k < 5; k++) {
+		t = model_time();
+		for(i = 0; i < 16; i++)
+			dsp_filter_fir_proc(fir, in, out, 4 * BLKLEN);
+
+		t = model_time() - t;
+		best = (t < best) ? t : best;
+	}
+
+	model.sparse = best / (16.0 * 4 * BLKLEN * 64);
+	dsp_filter_fir_delete(fir);
+
+	dense_init(&dense, in, 256);
+	for(best = INFINITY, k = 0; k < 5; k++) {
+		t = model_time();
+		for(i = 0; i < 16; i++)
+			dense_proc(&dense, in, out, 4 * BLKLEN);
+
+		t = model_time() - t;
+		best = (t < best) ? t : best;
+	}
+
+	model.dense = best / (16.0 * 4 * BLKLEN * 256);
+	dense_destroy(&dense);
+
+	fft = dsp_fft_new(1024);
+	for(best = INFINITY, k = 0; k < 5; k++) {
+		t = model_time();
+		for(i = 0; i < 64; i++) {
+			dsp_fft_fwd(fft, in, spec);
+			dsp_fft_inv(fft, spec, spec);
+		}
+
+		t = model_time() - t;
+		best = (t < best) ? t : best;
+	}
+
+	model.fft = best / (64.0 * 1024 * 10);
+	dsp_fft_delete(fft);
+
+	for(best = INFINITY, k = 0; k < 5; k++) {
+		t = model_time();
+		for(i = 0; i < 256; i++)
+			dsp_fft_mac(spec + 1026, spec, in, 512);
+
+		t = model_time() - t;
+		best = (t < best) ? t : best;
+	}
+
+	model.mac = best / (256.0 * 512);
+
+	mem_free(in);
+	mem_free(out);
+	mem_free(spec);
+
+	if(path != NULL)
+		model_save(path);
+}
+
+
+/**
+ * Initialize a dense engine.
+ *   @dense: The dense engine.
+ *   @coef: The coefficients.
+ *   @len: The number of taps.
+ */
+
+static void dense_init(struct auto_dense_t *dense, const double *coef, unsigned int len)
+{
+	unsigned int i;
+
+	dense->len = len;
+	dense->wr = len - 1;
+	dense->cap = len - 1 + BLKLEN;
+	dense->coef = mem_alloc(len * sizeof(double));
+	dense->hist = mem_alloc(dense->cap * sizeof(double));
+	mem_set(dense->hist, 0x00, dense->cap * sizeof(double));
+
+	for(i = 0; i < len; i++)
+		dense->coef[i] = coef[len - 1 - i];
+}
+
+/**
+ * Destroy a dense engine.
+ *   @dense: The dense engine.
+ */
+
+static void dense_destroy(struct auto_dense_t *dense)
+{
+	mem_free(dense->coef);
+	mem_free(dense->hist);
+}
+
+/**
+ * Process a block through a dense engine.
+ *   @dense: The dense engine.
+ *   @in: The input.
+ *   @out: The output.
+ *   @len: The length.
+ */
+
+static void dense_proc(struct auto_dense_t *dense, const double *in, double *out, unsigned int len)
+{
+	unsigned int i, n;
+
+	while(len > 0) {
+		if(dense->wr == dense->cap) {
+			mem_move(dense->hist, dense->hist + dense->cap - (dense->len - 1), (dense->len - 1) * sizeof(double));
+			dense->wr = dense->len - 1;
+		}
+
+		n = dense->cap - dense->wr;
+		n = (n < len) ? n : len;
+		mem_copy(dense->hist + dense->wr, in, n * sizeof(double));
+
+		for(i = 0; i < n; i++)
+			out[i] = dsp_vec_dot(dense->coef, dense->hist + dense->wr + 1 + i - dense->len, dense->len);
+
+		dense->wr += n;
+		in += n;
+		out += n;
+		len -= n;
+	}
+}
+
+
+/**
+ * Estimate the cost of the FFT engine, using the partition layout of
+ * 'dsp_convolve_new' for the tail.
+ *   @len: The number of taps.
+ *   @blk: The first partition size.
+ *   &returns: The cost per sample.
+ */
+
+static double cost_fft(unsigned int len, unsigned int blk)
+{
+	unsigned int off, end, npart;
+	double cost = model.dense * blk;
+
+	for(off = 0, len -= blk; off < len; off = end, blk *= 4) {
+		end = ((4 * blk) <= DSP_CONVOLVE_MAXBLK) ? (8 * blk) : len;
+		end = (end < len) ? end : len;
+		npart = (end - off + blk - 1) / blk;
+
+		cost += model.fft * 2.0 * log2(2.0 * blk) + model.mac * npart * (blk + 1) / blk;
+	}
+
+	return cost;
+}
+
+
+/**
+ * Load the cost model from a file.
+ *   @path: The path.
+ *   &returns: True if loaded.
+ */
+
+static bool model_load(const char *path)
+{
+	FILE *file;
+	char magic[16];
+	struct dsp_filter_auto_model_t tmp;
+	int cnt;
+
+	file = fopen(path, "r");
+	if(file == NULL)
+		return false;
+
+	cnt = fscanf(file, "%15s %lf %lf %lf %lf", magic, &tmp.sparse, &tmp.dense, &tmp.fft, &tmp.mac);
+	fclose(file);
+
+	if((cnt != 5) || (strcmp(magic, MAGIC) != 0))
+		return false;
+
+	if(!(tmp.sparse > 0.0) || !(tmp.dense > 0.0) || !(tmp.fft > 0.0) || !(tmp.mac > 0.0))
+		return false;
+
+	model = tmp;
+
+	return true;
+}
+
+/**
+ * Save the cost model to a file. Failure is ignored, since the model is
+ * only a cache.
+ *   @path: The path.
+ */
+
+static void model_save(const char *path)
+{
+	FILE *file;
+
+	file = fopen(path, "w");
+	if(file == NULL)
+		return;
+
+	fprintf(file, "%s %.17g %.17g %.17g %.17g\n", MAGIC, model.sparse, model.dense, model.fft, model.mac);
+	fclose(file);
+}
+
+/**
+ * Retrieve the monotonic time.
+ *   &returns: The time in nanoseconds.
+ */
+
+static double model_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
@@ -0,0 +1,62 @@
+#ifndef FILTER_AUTO_H
+#define FILTER_AUTO_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/**
+ * Automatic FIR engine enumerator.
+ *   @dsp_filter_auto_sparse: Sparse block processing.
+ *   @dsp_filter_auto_dense: Dense inner products.
+ *   @dsp_filter_auto_fft: Dense head with a partitioned FFT tail.
+ */
+
+enum dsp_filter_auto_e {
+	dsp_filter_auto_sparse,
+	dsp_filter_auto_dense,
+	dsp_filter_auto_fft
+};
+
+/**
+ * Automatic FIR cost model, in nanoseconds.
+ *   @sparse: Cost per tap per sample of sparse processing.
+ *   @dense: Cost per tap per sample of dense processing.
+ *   @fft: Cost per point of a forward and inverse transform pair, divided
+ *     by the base two logarithm of the length.
+ *   @mac: Cost per bin of a spectral multiply-accumulate.
+ */
+
+struct dsp_filter_auto_model_t {
+	double sparse, dense, fft, mac;
+};
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_filter_auto_t;
+
+/*
+ * automatic fir function declarations
+ */
+
+struct dsp_filter_auto_t *dsp_filter_auto_new(const struct dsp_pt_t *pt, unsigned int npts, unsigned int blk);
+void dsp_filter_auto_delete(struct dsp_filter_auto_t *filt);
+
+enum dsp_filter_auto_e dsp_filter_auto_kind(struct dsp_filter_auto_t *filt);
+void dsp_filter_auto_proc(struct dsp_filter_auto_t *filt, const double *in, double *out, unsigned int len);
+
+struct dsp_filter_auto_model_t dsp_filter_auto_model(void);
+void dsp_filter_auto_calib(const char *path);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
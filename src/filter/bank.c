@@ -0,0 +1,313 @@
+#include "../common.h"
+#include "bank.h"
+#include "butter.h"
+#include "moog.h"
+#include "rc.h"
+#include "../simd.h"
+
+
+/*
+ * filter bank definitions
+ */
+
+#define LANES DSP_NVEC_LEN
+
+
+/**
+ * Group of channels, one per native vector lane. Every filter is held as the
+ * recurrence 'y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2 - a3 y3 - a4 y4'.
+ *   @b0, b1, b2, a1, a2, a3, a4: The coefficients.
+ *   @x1, x2, y1, y2, y3, y4: The input and output histories.
+ */
+
+struct bank_grp_t {
+	double b0[LANES], b1[LANES], b2[LANES], a1[LANES], a2[LANES], a3[LANES], a4[LANES];
+	double x1[LANES], x2[LANES], y1[LANES], y2[LANES], y3[LANES], y4[LANES];
+};
+
+/**
+ * Multichannel filter bank structure.
+ *   @nchan, ngrp: The number of channels and groups.
+ *   @nb, na: The highest feed-forward and feedback orders in use.
+ *   @grp: The groups.
+ */
+
+struct dsp_filter_bank_t {
+	unsigned int nchan, ngrp;
+	unsigned int nb, na;
+
+	struct bank_grp_t *grp;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void bank_set(struct dsp_filter_bank_t *bank, unsigned int chan, unsigned int nb, unsigned int na, const double *b, const double *a);
+static inline void bank_run(struct bank_grp_t *grp, double *const *ptr, unsigned int len, unsigned int nb, unsigned int na);
+
+
+/**
+ * Create a multichannel filter bank. Every channel starts as a pass
+ * through until its filter is set.
+ *   @nchan: The number of channels.
+ *   &returns: The bank.
+ */
+
+_export
+struct dsp_filter_bank_t *dsp_filter_bank_new(unsigned int nchan)
+{
+	unsigned int i;
+	struct dsp_filter_bank_t *bank;
+
+	bank = mem_alloc(sizeof(struct dsp_filter_bank_t));
+	bank->nchan = nchan;
+	bank->ngrp = (nchan + LANES - 1) / LANES;
+	bank->nb = bank->na = 1;
+	bank->grp = mem_alloc(bank->ngrp * sizeof(struct bank_grp_t));
+	mem_set(bank->grp, 0x00, bank->ngrp * sizeof(struct bank_grp_t));
+
+	for(i = 0; i < nchan; i++)
+		bank->grp[i / LANES].b0[i % LANES] = 1.0;
+
+	return bank;
+}
+
+/**
+ * Delete a multichannel filter bank.
+ *   @bank: The bank.
+ */
+
+_export
+void dsp_filter_bank_delete(struct dsp_filter_bank_t *bank)
+{
+	mem_free(bank->grp);
+	mem_free(bank);
+}
+
+/**
+ * Clear the history of every channel.
+ *   @bank: The bank.
+ */
+
+_export
+void dsp_filter_bank_reset(struct dsp_filter_bank_t *bank)
+{
+	unsigned int i;
+
+	for(i = 0; i < bank->ngrp; i++) {
+		mem_set(bank->grp[i].x1, 0x00, sizeof(bank->grp[i].x1));
+		mem_set(bank->grp[i].x2, 0x00, sizeof(bank->grp[i].x2));
+		mem_set(bank->grp[i].y1, 0x00, sizeof(bank->grp[i].y1));
+		mem_set(bank->grp[i].y2, 0x00, sizeof(bank->grp[i].y2));
+		mem_set(bank->grp[i].y3, 0x00, sizeof(bank->grp[i].y3));
+		mem_set(bank->grp[i].y4, 0x00, sizeof(bank->grp[i].y4));
+	}
+}
+
+
+/**
+ * Set a channel to a low-pass RC filter, matching 'dsp_rc_low'.
+ *   @bank: The bank.
+ *   @chan: The channel.
+ *   @c: The constant.
+ */
+
+_export
+void dsp_filter_bank_rc_low(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_rc_1 c)
+{
+	bank_set(bank, chan, 1, 1, (double[]){ 1.0 - c.val }, (double[]){ -c.val });
+}
+
+/**
+ * Set a channel to a high-pass RC filter, matching 'dsp_rc_high'.
+ *   @bank: The bank.
+ *   @chan: The channel.
+ *   @c: The constant.
+ */
+
+_export
+void dsp_filter_bank_rc_high(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_rc_1 c)
+{
+	bank_set(bank, chan, 2, 1, (double[]){ c.val, -c.val }, (double[]){ -c.val });
+}
+
+/**
+ * Set a channel to a band-pass RC filter, matching 'dsp_rc_pass'.
+ *   @bank: The bank.
+ *   @chan: The channel.
+ *   @c: The constant.
+ */
+
+_export
+void dsp_filter_bank_rc_pass(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_rc_2 c)
+{
+	bank_set(bank, chan, 2, 2, (double[]){ c.high * (1.0 - c.low), c.low * (c.low - 1.0) }, (double[]){ -(c.low + c.high), c.low * c.high });
+}
+
+/**
+ * Set a channel to a 2nd-order low-pass butterworth filter, matching
+ * 'dsp_filt_butter2_low'.
+ *   @bank: The bank.
+ *   @chan: The channel.
+ *   @c: The constant.
+ */
+
+_export
+void dsp_filter_bank_butter2_low(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_butter_2 c)
+{
+	bank_set(bank, chan, 1, 2, (double[]){ c.a }, (double[]){ c.b1, c.b2 });
+}
+
+/**
+ * Set a channel to a 2nd-order high-pass butterworth filter, matching
+ * 'dsp_filt_butter2_high'.
+ *   @bank: The bank.
+ *   @chan: The channel.
+ *   @c: The constant.
+ */
+
+_export
+void dsp_filter_bank_butter2_high(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_butter_2 c)
+{
+	bank_set(bank, chan, 3, 2, (double[]){ 1.0, -2.0, 1.0 }, (double[]){ c.b1, c.b2 });
+}
+
+/**
+ * Set a channel to a moog resonant filter, matching 'dsp_moog_next'.
+ *   @bank: The bank.
+ *   @chan: The channel.
+ *   @c: The constant.
+ */
+
+_export
+void dsp_filter_bank_moog(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_moog_t c)
+{
+	double w2 = c.w * c.w;
+
+	bank_set(bank, chan, 1, 4, (double[]){ c.g }, (double[]){ -c.w * c.a, w2 * c.b, -w2 * c.w * c.a, w2 * w2 });
+}
+
+
+/**
+ * Filter bank flow callback, processing the buffers in place. Create a node
+ * with 'dsp_node_new(nchan, nchan, dsp_filter_bank_proc, bank)'.
+ *   @buf: The buffers, one per channel.
+ *   @len: The length.
+ *   @arg: The bank.
+ */
+
+_export
+void dsp_filter_bank_proc(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i, j;
+	double *ptr[LANES];
+	struct dsp_filter_bank_t *bank = arg;
+
+	for(i = 0; i < bank->ngrp; i++) {
+		for(j = 0; j < LANES; j++)
+			ptr[j] = buf[(LANES * i + j < bank->nchan) ? (LANES * i + j) : (bank->nchan - 1)];
+
+		if((bank->nb == 1) && (bank->na == 1))
+			bank_run(&bank->grp[i], ptr, len, 1, 1);
+		else if(bank->na <= 2)
+			bank_run(&bank->grp[i], ptr, len, 3, 2);
+		else
+			bank_run(&bank->grp[i], ptr, len, 3, 4);
+	}
+}
+
+
+/**
+ * Set the recurrence of a channel, clearing its history.
+ *   @bank: The bank.
+ *   @chan: The channel.
+ *   @nb: The number of feed-forward coefficients.
+ *   @na: The number of feedback coefficients.
+ *   @b: The feed-forward coefficients.
+ *   @a: The feedback coefficients.
+ */
+
+static void bank_set(struct dsp_filter_bank_t *bank, unsigned int chan, unsigned int nb, unsigned int na, const double *b, const double *a)
+{
+	unsigned int j = chan % LANES;
+	struct bank_grp_t *grp = &bank->grp[chan / LANES];
+
+	if(chan >= bank->nchan)
+		throw("Invalid filter bank channel %u.", chan);
+
+	grp->b0[j] = b[0];
+	grp->b1[j] = (nb > 1) ? b[1] : 0.0;
+	grp->b2[j] = (nb > 2) ? b[2] : 0.0;
+	grp->a1[j] = a[0];
+	grp->a2[j] = (na > 1) ? a[1] : 0.0;
+	grp->a3[j] = (na > 2) ? a[2] : 0.0;
+	grp->a4[j] = (na > 3) ? a[3] : 0.0;
+
+	grp->x1[j] = grp->x2[j] = 0.0;
+	grp->y1[j] = grp->y2[j] = grp->y3[j] = grp->y4[j] = 0.0;
+
+	bank->nb = (nb > bank->nb) ? nb : bank->nb;
+	bank->na = (na > bank->na) ? na : bank->na;
+}
+
+/**
+ * Run a group over a block in place, gathering one sample per channel for
+ * each step. Lanes past the last channel alias the last channel and have
+ * zero coefficients, and the scatter lets the real lane win. The
+ * orders are constants at each call site, so unused terms compile away.
+ *   @grp: The group.
+ *   @ptr: The channel buffers.
+ *   @len: The length.
+ *   @nb: The feed-forward order bound.
+ *   @na: The feedback order bound.
+ */
+
+static inline void bank_run(struct bank_grp_t *grp, double *const *ptr, unsigned int len, unsigned int nb, unsigned int na)
+{
+	unsigned int i;
+	dsp_nvec_t b0, b1, b2, a1, a2, a3, a4, x1, x2, y1, y2, y3, y4, x, y;
+
+	dsp_nvec_load(&b0, grp->b0);
+	dsp_nvec_load(&b1, grp->b1);
+	dsp_nvec_load(&b2, grp->b2);
+	dsp_nvec_load(&a1, grp->a1);
+	dsp_nvec_load(&a2, grp->a2);
+	dsp_nvec_load(&a3, grp->a3);
+	dsp_nvec_load(&a4, grp->a4);
+	dsp_nvec_load(&x1, grp->x1);
+	dsp_nvec_load(&x2, grp->x2);
+	dsp_nvec_load(&y1, grp->y1);
+	dsp_nvec_load(&y2, grp->y2);
+	dsp_nvec_load(&y3, grp->y3);
+	dsp_nvec_load(&y4, grp->y4);
+
+	for(i = 0; i < len; i++) {
+		dsp_nvec_gather(&x, ptr, i);
+
+		y = b0 * x;
+		if(nb > 1)
+			y += b1 * x1;
+		if(nb > 2)
+			y += b2 * x2;
+		if(na > 3)
+			y -= a4 * y4 + a3 * y3;
+		if(na > 1)
+			y -= a2 * y2;
+
+		y -= a1 * y1;
+
+		x2 = x1, x1 = x;
+		y4 = y3, y3 = y2, y2 = y1, y1 = y;
+
+		dsp_nvec_scatter(ptr, i, &y);
+	}
+
+	dsp_nvec_store(grp->x1, &x1);
+	dsp_nvec_store(grp->x2, &x2);
+	dsp_nvec_store(grp->y1, &y1);
+	dsp_nvec_store(grp->y2, &y2);
+	dsp_nvec_store(grp->y3, &y3);
+	dsp_nvec_store(grp->y4, &y4);
+}
@@ -0,0 +1,43 @@
+#ifndef FILTER_BANK_H
+#define FILTER_BANK_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_rc_1;
+struct dsp_rc_2;
+struct dsp_butter_2;
+struct dsp_moog_t;
+struct dsp_filter_bank_t;
+
+/*
+ * filter bank function declarations
+ */
+
+struct dsp_filter_bank_t *dsp_filter_bank_new(unsigned int nchan);
+void dsp_filter_bank_delete(struct dsp_filter_bank_t *bank);
+void dsp_filter_bank_reset(struct dsp_filter_bank_t *bank);
+
+void dsp_filter_bank_rc_low(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_rc_1 c);
+void dsp_filter_bank_rc_high(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_rc_1 c);
+void dsp_filter_bank_rc_pass(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_rc_2 c);
+void dsp_filter_bank_butter2_low(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_butter_2 c);
+void dsp_filter_bank_butter2_high(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_butter_2 c);
+void dsp_filter_bank_moog(struct dsp_filter_bank_t *bank, unsigned int chan, struct dsp_moog_t c);
+
+void dsp_filter_bank_proc(double **buf, unsigned int len, void *arg);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -72,6 +72,48 @@ static inline double dsp_filt_butter2_high(double x, struct dsp_butter_2 c, stru
 	return y;
 }
 
+/**
+ * Process a block with a 2nd-order low-pass butterworth filter. The input
+ * and output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @c: The constant.
+ *   @data: The two point data store.
+ */
+
+static inline void dsp_filt_butter2_low_block(const double *x, double *y, unsigned int len, struct dsp_butter_2 c, struct dsp_data_2 *data)
+{
+	unsigned int i;
+	struct dsp_data_2 d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_filt_butter2_low(x[i], c, &d);
+
+	*data = d;
+}
+
+/**
+ * Process a block with a 2nd-order high-pass butterworth filter. The input
+ * and output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @c: The constant.
+ *   @data: The two point data store.
+ */
+
+static inline void dsp_filt_butter2_high_block(const double *x, double *y, unsigned int len, struct dsp_butter_2 c, struct dsp_data_2 *data)
+{
+	unsigned int i;
+	struct dsp_data_2 d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_filt_butter2_high(x[i], c, &d);
+
+	*data = d;
+}
+
 /* %~dsp.h% */
 
 /*
@@ -0,0 +1,219 @@
+#include "../common.h"
+#include "cascade.h"
+#include "design.h"
+#include "../simd.h"
+
+
+/*
+ * section cascade definitions
+ */
+
+#define LANES DSP_NVEC_LEN
+#define NCOEF (5 * LANES)
+#define NSTATE (2 * LANES)
+
+
+/*
+ * local function declarations
+ */
+
+static inline void cascade_step(const double *coef, unsigned int ngrp, dsp_nvec_t *y, dsp_nvec_t *s1, dsp_nvec_t *s2, double x);
+static void cascade_edge(const double *coef, unsigned int ngrp, dsp_nvec_t *y, dsp_nvec_t *s1, dsp_nvec_t *s2, double *buf, unsigned int t, unsigned int len);
+
+
+/**
+ * Create a section cascade. The last group is padded with sections that
+ * pass their input through unchanged.
+ *   @sos: The sections, applied in order.
+ *   @nsos: The number of sections.
+ *   &returns: The cascade.
+ */
+
+_export
+struct dsp_filter_cascade_t *dsp_filter_cascade_new(const struct dsp_sos_t *sos, unsigned int nsos)
+{
+	unsigned int i, j;
+	double *coef;
+	struct dsp_filter_cascade_t *cascade;
+
+	cascade = mem_alloc(sizeof(struct dsp_filter_cascade_t));
+	cascade->nsos = nsos;
+	cascade->ngrp = (nsos + LANES - 1) / LANES;
+	cascade->coef = mem_alloc(NCOEF * cascade->ngrp * sizeof(double));
+	cascade->state = mem_alloc(NSTATE * cascade->ngrp * sizeof(double));
+	mem_set(cascade->coef, 0x00, NCOEF * cascade->ngrp * sizeof(double));
+	mem_set(cascade->state, 0x00, NSTATE * cascade->ngrp * sizeof(double));
+
+	for(i = 0; i < LANES * cascade->ngrp; i++) {
+		coef = cascade->coef + NCOEF * (i / LANES);
+		j = i % LANES;
+
+		if(i < nsos) {
+			coef[j] = sos[i].b0;
+			coef[LANES + j] = sos[i].b1;
+			coef[2 * LANES + j] = sos[i].b2;
+			coef[3 * LANES + j] = sos[i].a1;
+			coef[4 * LANES + j] = sos[i].a2;
+		}
+		else
+			coef[j] = 1.0;
+	}
+
+	return cascade;
+}
+
+/**
+ * Create a section cascade from a filter design.
+ *   @param: The design parameters.
+ *   &returns: The cascade.
+ */
+
+_export
+struct dsp_filter_cascade_t *dsp_filter_cascade_design(const struct dsp_design_param_t *param)
+{
+	struct dsp_design_t *design;
+	struct dsp_filter_cascade_t *cascade;
+
+	design = dsp_design_get(param);
+	cascade = dsp_filter_cascade_new(design->sos, design->nsos);
+	dsp_design_put(design);
+
+	return cascade;
+}
+
+/**
+ * Delete a section cascade.
+ *   @cascade: The cascade.
+ */
+
+_export
+void dsp_filter_cascade_delete(struct dsp_filter_cascade_t *cascade)
+{
+	mem_free(cascade->coef);
+	mem_free(cascade->state);
+	mem_free(cascade);
+}
+
+
+/**
+ * Clear the state of a section cascade.
+ *   @cascade: The cascade.
+ */
+
+_export
+void dsp_filter_cascade_reset(struct dsp_filter_cascade_t *cascade)
+{
+	mem_set(cascade->state, 0x00, NSTATE * cascade->ngrp * sizeof(double));
+}
+
+/**
+ * Process a block through a section cascade. The input and output may be
+ * the same buffer.
+ *   @cascade: The cascade.
+ *   @in: The input.
+ *   @out: The output.
+ *   @len: The length.
+ */
+
+_export
+void dsp_filter_cascade_proc(struct dsp_filter_cascade_t *cascade, const double *in, double *out, unsigned int len)
+{
+	unsigned int t, g, ngrp = cascade->ngrp, lag = LANES * ngrp - 1;
+	dsp_nvec_t y[ngrp + 1], s1[ngrp + 1], s2[ngrp + 1];
+
+	if(in != out)
+		mem_move(out, in, len * sizeof(double));
+
+	if(ngrp == 0)
+		return;
+
+	for(g = 0; g < ngrp; g++) {
+		y[g] = (dsp_nvec_t){ };
+		dsp_nvec_load(&s1[g], cascade->state + NSTATE * g);
+		dsp_nvec_load(&s2[g], cascade->state + NSTATE * g + LANES);
+	}
+
+	for(t = 0; t < lag; t++)
+		cascade_edge(cascade->coef, ngrp, y, s1, s2, out, t, len);
+
+	for(t = lag; t < len; t++) {
+		cascade_step(cascade->coef, ngrp, y, s1, s2, out[t]);
+		out[t - lag] = y[ngrp - 1][LANES - 1];
+	}
+
+	for(t = (len > lag) ? len : lag; t < len + lag; t++)
+		cascade_edge(cascade->coef, ngrp, y, s1, s2, out, t, len);
+
+	for(g = 0; g < ngrp; g++) {
+		dsp_nvec_store(cascade->state + NSTATE * g, &s1[g]);
+		dsp_nvec_store(cascade->state + NSTATE * g + LANES, &s2[g]);
+	}
+}
+
+
+/**
+ * Advance every lane of the pipeline by one step. Each lane works on the
+ * sample that the lane before it finished on the previous step, and the
+ * first lane of a group takes the last lane of the group before it, so
+ * groups are visited last to first.
+ *   @coef: The coefficients.
+ *   @ngrp: The number of groups.
+ *   @y: The lane outputs.
+ *   @s1, s2: The state vectors.
+ *   @x: The input sample.
+ */
+
+static inline void cascade_step(const double *coef, unsigned int ngrp, dsp_nvec_t *y, dsp_nvec_t *s1, dsp_nvec_t *s2, double x)
+{
+	unsigned int g;
+	dsp_nvec_t b0, b1, b2, a1, a2, u;
+
+	for(g = ngrp; g-- > 0; ) {
+		dsp_nvec_load(&b0, coef + NCOEF * g);
+		dsp_nvec_load(&b1, coef + NCOEF * g + LANES);
+		dsp_nvec_load(&b2, coef + NCOEF * g + 2 * LANES);
+		dsp_nvec_load(&a1, coef + NCOEF * g + 3 * LANES);
+		dsp_nvec_load(&a2, coef + NCOEF * g + 4 * LANES);
+
+		u = y[g];
+		dsp_nvec_shift(&u, (g == 0) ? x : y[g - 1][LANES - 1]);
+
+		y[g] = b0 * u + s1[g];
+		s1[g] = (b1 * u + s2[g]) - a1 * y[g];
+		s2[g] = b2 * u - a2 * y[g];
+	}
+}
+
+/**
+ * Run one pipeline fill or drain step. Only lanes that hold a sample of the
+ * block keep their updated state.
+ *   @coef: The coefficients.
+ *   @ngrp: The number of groups.
+ *   @y: The lane outputs.
+ *   @s1, s2: The state vectors.
+ *   @buf: The buffer.
+ *   @t: The step.
+ *   @len: The length.
+ */
+
+static void cascade_edge(const double *coef, unsigned int ngrp, dsp_nvec_t *y, dsp_nvec_t *s1, dsp_nvec_t *s2, double *buf, unsigned int t, unsigned int len)
+{
+	unsigned int g, j, k, lag = LANES * ngrp - 1;
+	dsp_nvec_t n1[ngrp], n2[ngrp];
+
+	mem_copy(n1, s1, ngrp * sizeof(dsp_nvec_t));
+	mem_copy(n2, s2, ngrp * sizeof(dsp_nvec_t));
+	cascade_step(coef, ngrp, y, n1, n2, (t < len) ? buf[t] : 0.0);
+
+	for(g = 0; g < ngrp; g++) {
+		for(j = 0; j < LANES; j++) {
+			k = LANES * g + j;
+
+			if((t >= k) && (t - k < len))
+				s1[g][j] = n1[g][j], s2[g][j] = n2[g][j];
+		}
+	}
+
+	if(t >= lag)
+		buf[t - lag] = y[ngrp - 1][LANES - 1];
+}
@@ -0,0 +1,52 @@
+#ifndef FILTER_CASCADE_H
+#define FILTER_CASCADE_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_sos_t;
+struct dsp_design_param_t;
+
+/**
+ * Cascade of second-order sections in transposed direct form II. Sections
+ * are grouped by native vector width, one per lane, and the whole cascade
+ * is pipelined across samples so that each lane processes the sample its
+ * predecessor finished on the previous step. The pipeline is drained at the
+ * end of every block, so the cascade adds no latency.
+ *   @nsos, ngrp: The number of sections and groups.
+ *   @coef: The coefficients, per group 'b0', 'b1', 'b2', 'a1' and 'a2' each
+ *     spread over the lanes.
+ *   @state: The state registers, per group 's1' and 's2' over the lanes.
+ */
+
+struct dsp_filter_cascade_t {
+	unsigned int nsos, ngrp;
+	double *coef, *state;
+};
+
+
+/*
+ * section cascade function declarations
+ */
+
+struct dsp_filter_cascade_t *dsp_filter_cascade_new(const struct dsp_sos_t *sos, unsigned int nsos);
+struct dsp_filter_cascade_t *dsp_filter_cascade_design(const struct dsp_design_param_t *param);
+void dsp_filter_cascade_delete(struct dsp_filter_cascade_t *cascade);
+
+void dsp_filter_cascade_reset(struct dsp_filter_cascade_t *cascade);
+void dsp_filter_cascade_proc(struct dsp_filter_cascade_t *cascade, const double *in, double *out, unsigned int len);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
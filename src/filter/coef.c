@@ -0,0 +1,199 @@
+#include "../common.h"
+#include "coef.h"
+#include "butter.h"
+#include "moog.h"
+#include "rc.h"
+#include "../probe.h"
+#include "res.h"
+#include "../cache.h"
+
+
+/*
+ * coefficient cache definitions
+ */
+
+/**
+ * Coefficient kind enumerator.
+ *   @coef_rc_1, coef_rc_2: RC filter and band constants.
+ *   @coef_butter2: 2nd-order butterworth constant.
+ *   @coef_moog: Moog resonant filter constant.
+ *   @coef_notch: Notch filter constant.
+ */
+
+enum coef_e {
+	coef_rc_1,
+	coef_rc_2,
+	coef_butter2,
+	coef_moog,
+	coef_notch
+};
+
+/**
+ * Cache key structure.
+ *   @kind: The kind.
+ *   @rate: The rate.
+ *   @param: The parameters, unused ones zero.
+ */
+
+struct coef_key_t {
+	enum coef_e kind;
+	unsigned int rate;
+	double param[3];
+};
+
+/**
+ * Coefficient union.
+ *   @rc_1, rc_2, butter2, moog, notch: The constant of each kind.
+ */
+
+union coef_val_u {
+	struct dsp_rc_1 rc_1;
+	struct dsp_rc_2 rc_2;
+	struct dsp_butter_2 butter2;
+	struct dsp_moog_t moog;
+	struct dsp_notch_t notch;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void *coef_get(enum coef_e kind, unsigned int rate, double p0, double p1, double p2);
+static void *coef_build(const void *key);
+
+/*
+ * global variables
+ */
+
+static struct dsp_cache_t cache = DSP_CACHE_INIT(sizeof(struct coef_key_t), true);
+
+
+/**
+ * Retrieve the cached RC constant.
+ *   @rate: The rate.
+ *   @freq: The frequency.
+ *   &returns: The shared constant. It must be released with 'dsp_coef_put'.
+ */
+
+_export
+const struct dsp_rc_1 *dsp_coef_rc_1(unsigned int rate, double freq)
+{
+	return coef_get(coef_rc_1, rate, freq, 0.0, 0.0);
+}
+
+/**
+ * Retrieve the cached RC band constant.
+ *   @rate: The rate.
+ *   @low: The low frequency.
+ *   @high: The high frequency.
+ *   &returns: The shared constant. It must be released with 'dsp_coef_put'.
+ */
+
+_export
+const struct dsp_rc_2 *dsp_coef_rc_2(unsigned int rate, double low, double high)
+{
+	return coef_get(coef_rc_2, rate, low, high, 0.0);
+}
+
+/**
+ * Retrieve the cached 2nd-order butterworth constant.
+ *   @rate: The rate.
+ *   @freq: The frequency.
+ *   &returns: The shared constant. It must be released with 'dsp_coef_put'.
+ */
+
+_export
+const struct dsp_butter_2 *dsp_coef_butter2(unsigned int rate, double freq)
+{
+	return coef_get(coef_butter2, rate, freq, 0.0, 0.0);
+}
+
+/**
+ * Retrieve the cached moog filter constant.
+ *   @rate: The rate.
+ *   @freq: The frequency.
+ *   @res: The resonance.
+ *   &returns: The shared constant. It must be released with 'dsp_coef_put'.
+ */
+
+_export
+const struct dsp_moog_t *dsp_coef_moog(unsigned int rate, double freq, double res)
+{
+	return coef_get(coef_moog, rate, freq, res, 0.0);
+}
+
+/**
+ * Retrieve the cached notch filter constant.
+ *   @rate: The rate.
+ *   @freq: The frequency.
+ *   @k: The resonance.
+ *   &returns: The shared constant. It must be released with 'dsp_coef_put'.
+ */
+
+_export
+const struct dsp_notch_t *dsp_coef_notch(unsigned int rate, double freq, double k)
+{
+	return coef_get(coef_notch, rate, freq, k, 0.0);
+}
+
+/**
+ * Release a cached constant. Unreferenced constants stay cached until the
+ * next purge.
+ *   @coef: The constant.
+ */
+
+_export
+void dsp_coef_put(const void *coef)
+{
+	dsp_cache_put(&cache, coef);
+}
+
+/**
+ * Free every unreferenced constant.
+ *   &returns: The number of constants freed.
+ */
+
+_export
+unsigned int dsp_coef_purge(void)
+{
+	return dsp_cache_purge(&cache);
+}
+
+
+/**
+ * Retrieve a constant, computing it on a miss.
+ *   @kind: The kind.
+ *   @rate: The rate.
+ *   @p0, p1, p2: The parameters, unused ones zero.
+ *   &returns: The constant.
+ */
+
+static void *coef_get(enum coef_e kind, unsigned int rate, double p0, double p1, double p2)
+{
+	return dsp_cache_get(&cache, &(struct coef_key_t){ kind, rate, { p0, p1, p2 } }, coef_build);
+}
+
+/**
+ * Compute a constant for the cache.
+ *   @key: The key.
+ *   &returns: The constant.
+ */
+
+static void *coef_build(const void *key)
+{
+	const struct coef_key_t *ptr = key;
+	union coef_val_u *val;
+
+	val = dsp_cache_alloc(sizeof(union coef_val_u));
+
+	switch(ptr->kind) {
+	case coef_rc_1: val->rc_1 = dsp_rc_1(ptr->rate, ptr->param[0]); break;
+	case coef_rc_2: val->rc_2 = dsp_rc_2(ptr->rate, ptr->param[0], ptr->param[1]); break;
+	case coef_butter2: val->butter2 = dsp_filt_butter2_init(ptr->rate, ptr->param[0]); break;
+	case coef_moog: val->moog = dsp_moog_init(ptr->rate, ptr->param[0], ptr->param[1]); break;
+	case coef_notch: val->notch = dsp_notch_init(ptr->rate, ptr->param[0], ptr->param[1]); break;
+	}
+
+	return val;
+}
@@ -0,0 +1,39 @@
+#ifndef FILTER_COEF_H
+#define FILTER_COEF_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_rc_1;
+struct dsp_rc_2;
+struct dsp_butter_2;
+struct dsp_moog_t;
+struct dsp_notch_t;
+
+/*
+ * coefficient cache function declarations
+ */
+
+const struct dsp_rc_1 *dsp_coef_rc_1(unsigned int rate, double freq);
+const struct dsp_rc_2 *dsp_coef_rc_2(unsigned int rate, double low, double high);
+const struct dsp_butter_2 *dsp_coef_butter2(unsigned int rate, double freq);
+const struct dsp_moog_t *dsp_coef_moog(unsigned int rate, double freq, double res);
+const struct dsp_notch_t *dsp_coef_notch(unsigned int rate, double freq, double k);
+void dsp_coef_put(const void *coef);
+
+unsigned int dsp_coef_purge(void);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -0,0 +1,507 @@
+#include "../common.h"
+#include "design.h"
+#include "../cache.h"
+#include <complex.h>
+
+
+/*
+ * filter design definitions
+ */
+
+#define MAXORDER 32
+#define MAXROOT (2 * MAXORDER)
+
+
+/**
+ * Root group structure, holding either a conjugate pair, two real roots or a
+ * single real root.
+ *   @r: The roots.
+ *   @n: The number of roots.
+ */
+
+struct design_grp_t {
+	double complex r[2];
+	unsigned int n;
+};
+
+/**
+ * Zero-pole-gain structure.
+ *   @z, p: The zeros and poles.
+ *   @nz, np: The number of zeros and poles.
+ *   @k: The gain.
+ */
+
+struct design_zpk_t {
+	double complex z[MAXROOT], p[MAXROOT];
+	unsigned int nz, np;
+	double k;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void design_check(struct dsp_design_param_t *param);
+static void *design_build(const void *key);
+
+static void design_proto(struct design_zpk_t *zpk, enum dsp_design_e type, unsigned int order, double ripple);
+static void design_low(struct design_zpk_t *zpk, double w);
+static void design_high(struct design_zpk_t *zpk, double w);
+static void design_pass(struct design_zpk_t *zpk, double w0, double bw);
+static void design_bilinear(struct design_zpk_t *zpk, double rate);
+
+static unsigned int design_group(struct design_grp_t *grp, const double complex *root, unsigned int cnt);
+static double design_radius(const struct design_grp_t *grp);
+static void design_poly(const struct design_grp_t *grp, double *c1, double *c2);
+
+/*
+ * global variables
+ */
+
+static struct dsp_cache_t cache = DSP_CACHE_INIT(sizeof(struct dsp_design_param_t), false);
+
+
+/**
+ * Retrieve a filter design, computing it if no design with the same
+ * parameters is already cached. Identical parameters always yield the same
+ * shared, immutable design. Designs are built outside the cache lock.
+ *   @param: The parameters.
+ *   &returns: The design. It must be released with 'dsp_design_put'.
+ */
+
+_export
+struct dsp_design_t *dsp_design_get(const struct dsp_design_param_t *param)
+{
+	struct dsp_design_param_t norm;
+
+	mem_set(&norm, 0x00, sizeof(struct dsp_design_param_t));
+	norm.type = param->type;
+	norm.band = param->band;
+	norm.order = param->order;
+	norm.rate = param->rate;
+	norm.freq = param->freq;
+	norm.width = param->width;
+	norm.ripple = param->ripple;
+	design_check(&norm);
+
+	return dsp_cache_get(&cache, &norm, design_build);
+}
+
+/**
+ * Release a filter design, removing it from the cache once unused.
+ *   @design: The design.
+ */
+
+_export
+void dsp_design_put(struct dsp_design_t *design)
+{
+	dsp_cache_put(&cache, design);
+}
+
+
+/**
+ * Compute the magnitude response of a design.
+ *   @design: The design.
+ *   @freq: The frequency.
+ *   &returns: The linear magnitude.
+ */
+
+_export
+double dsp_design_mag(const struct dsp_design_t *design, double freq)
+{
+	unsigned int i;
+	double complex e1, e2, h = 1.0;
+	const struct dsp_sos_t *sos;
+
+	e1 = cexp(-I * 2.0 * M_PI * freq / design->param.rate);
+	e2 = e1 * e1;
+
+	for(i = 0; i < design->nsos; i++) {
+		sos = &design->sos[i];
+		h *= (sos->b0 + sos->b1 * e1 + sos->b2 * e2) / (1.0 + sos->a1 * e1 + sos->a2 * e2);
+	}
+
+	return cabs(h);
+}
+
+
+/**
+ * Validate parameters and clear the fields unused by the design, so that
+ * equivalent requests share a cache entry. Comparisons are written so that
+ * NaN values are rejected.
+ *   @param: The parameters.
+ */
+
+static void design_check(struct dsp_design_param_t *param)
+{
+	double lo, hi;
+
+	if((param->order == 0) || (param->order > MAXORDER))
+		throw("Invalid filter order %u.", param->order);
+
+	if((param->type == dsp_design_linkwitz) && (param->order % 2 != 0))
+		throw("Linkwitz-Riley order must be even.");
+
+	if(!(param->rate > 0.0))
+		throw("Invalid sample rate.");
+
+	lo = param->freq - ((param->band == dsp_band_pass) ? (param->width / 2.0) : 0.0);
+	hi = param->freq + ((param->band == dsp_band_pass) ? (param->width / 2.0) : 0.0);
+
+	if(!(lo > 0.0) || !(hi < param->rate / 2.0) || (hi < lo) || ((param->band == dsp_band_pass) && (hi == lo)))
+		throw("Invalid filter frequency.");
+
+	if((param->type == dsp_design_cheby1) || (param->type == dsp_design_cheby2)) {
+		if(!(param->ripple > 0.0))
+			throw("Invalid filter ripple.");
+	}
+	else
+		param->ripple = 0.0;
+
+	if(param->band != dsp_band_pass)
+		param->width = 0.0;
+}
+
+/**
+ * Build a design from its analog prototype. The prototype is frequency
+ * transformed against prewarped edges, mapped with the bilinear transform
+ * and split into second-order sections, pairing each pole group with its
+ * nearest zero group. This runs without any lock held.
+ *   @key: The normalized parameters.
+ *   &returns: The design.
+ */
+
+static void *design_build(const void *key)
+{
+	const struct dsp_design_param_t *param = key;
+	unsigned int i, j, best, ngrp, nzgrp;
+	double dist, min, c1, c2, lo, hi;
+	struct design_zpk_t zpk;
+	struct design_grp_t pgrp[MAXROOT], zgrp[MAXROOT], tmp;
+	struct dsp_design_t *design;
+	struct dsp_sos_t *sos;
+
+	if(param->type == dsp_design_linkwitz) {
+		design_proto(&zpk, dsp_design_butter, param->order / 2, 0.0);
+
+		for(i = 0; i < zpk.np; i++)
+			zpk.p[zpk.np + i] = zpk.p[i];
+
+		zpk.np *= 2;
+		zpk.k *= zpk.k;
+	}
+	else
+		design_proto(&zpk, param->type, param->order, param->ripple);
+
+	switch(param->band) {
+	case dsp_band_low:
+		design_low(&zpk, 2.0 * param->rate * tan(M_PI * param->freq / param->rate));
+		break;
+
+	case dsp_band_high:
+		design_high(&zpk, 2.0 * param->rate * tan(M_PI * param->freq / param->rate));
+		break;
+
+	case dsp_band_pass:
+		lo = 2.0 * param->rate * tan(M_PI * (param->freq - param->width / 2.0) / param->rate);
+		hi = 2.0 * param->rate * tan(M_PI * (param->freq + param->width / 2.0) / param->rate);
+		design_pass(&zpk, sqrt(lo * hi), hi - lo);
+		break;
+	}
+
+	design_bilinear(&zpk, param->rate);
+
+	ngrp = design_group(pgrp, zpk.p, zpk.np);
+	nzgrp = design_group(zgrp, zpk.z, zpk.nz);
+
+	/* order pole groups by decreasing radius, so those nearest the unit circle pick their zeros first */
+	for(i = 1; i < ngrp; i++) {
+		for(j = i; (j > 0) && (design_radius(&pgrp[j]) > design_radius(&pgrp[j - 1])); j--)
+			tmp = pgrp[j], pgrp[j] = pgrp[j - 1], pgrp[j - 1] = tmp;
+	}
+
+	design = dsp_cache_alloc(sizeof(struct dsp_design_t) + ngrp * sizeof(struct dsp_sos_t));
+	design->param = *param;
+	design->nsos = ngrp;
+
+	for(i = 0; i < ngrp; i++) {
+		best = nzgrp;
+		min = INFINITY;
+
+		for(j = 0; j < nzgrp; j++) {
+			if(zgrp[j].n != pgrp[i].n)
+				continue;
+
+			dist = fmin(cabs(zgrp[j].r[0] - pgrp[i].r[0]), cabs(zgrp[j].r[zgrp[j].n - 1] - pgrp[i].r[0]));
+			if(dist < min)
+				min = dist, best = j;
+		}
+
+		if(best == nzgrp)
+			throw("Unmatched filter zeros.");
+
+		sos = &design->sos[ngrp - 1 - i];
+		design_poly(&pgrp[i], &sos->a1, &sos->a2);
+		design_poly(&zgrp[best], &c1, &c2);
+		sos->b0 = 1.0;
+		sos->b1 = c1;
+		sos->b2 = c2;
+
+		zgrp[best] = zgrp[--nzgrp];
+	}
+
+	design->sos[0].b0 *= zpk.k;
+	design->sos[0].b1 *= zpk.k;
+	design->sos[0].b2 *= zpk.k;
+
+	return design;
+}
+
+
+/**
+ * Compute the analog prototype with a unit cutoff.
+ *   @zpk: The output zeros, poles and gain.
+ *   @type: The design family, not Linkwitz-Riley.
+ *   @order: The order.
+ *   @ripple: The ripple or attenuation in decibels.
+ */
+
+static void design_proto(struct design_zpk_t *zpk, enum dsp_design_e type, unsigned int order, double ripple)
+{
+	unsigned int i;
+	double m, eps, mu;
+	double complex p, num, den;
+
+	zpk->nz = zpk->np = 0;
+	zpk->k = 1.0;
+
+	switch(type) {
+	case dsp_design_butter:
+	case dsp_design_linkwitz:
+		for(i = 0; i < order; i++) {
+			m = -(double)order + 1.0 + 2.0 * i;
+			zpk->p[zpk->np++] = -cexp(I * M_PI * m / (2.0 * order));
+		}
+
+		break;
+
+	case dsp_design_cheby1:
+		eps = sqrt(pow(10.0, 0.1 * ripple) - 1.0);
+		mu = asinh(1.0 / eps) / order;
+		num = 1.0;
+
+		for(i = 0; i < order; i++) {
+			m = -(double)order + 1.0 + 2.0 * i;
+			p = -csinh(mu + I * M_PI * m / (2.0 * order));
+			zpk->p[zpk->np++] = p;
+			num *= -p;
+		}
+
+		zpk->k = creal(num);
+		if(order % 2 == 0)
+			zpk->k /= sqrt(1.0 + eps * eps);
+
+		break;
+
+	case dsp_design_cheby2:
+		eps = 1.0 / sqrt(pow(10.0, 0.1 * ripple) - 1.0);
+		mu = asinh(1.0 / eps) / order;
+		num = den = 1.0;
+
+		for(i = 0; i < order; i++) {
+			m = -(double)order + 1.0 + 2.0 * i;
+
+			p = -cexp(I * M_PI * m / (2.0 * order));
+			p = 1.0 / (sinh(mu) * creal(p) + I * cosh(mu) * cimag(p));
+			zpk->p[zpk->np++] = p;
+			num *= -p;
+
+			if(m != 0.0) {
+				zpk->z[zpk->nz] = I / sin(M_PI * m / (2.0 * order));
+				den *= -zpk->z[zpk->nz++];
+			}
+		}
+
+		zpk->k = creal(num / den);
+		break;
+	}
+}
+
+/**
+ * Transform a prototype to a low-pass at an analog frequency.
+ *   @zpk: The zeros, poles and gain.
+ *   @w: The analog cutoff.
+ */
+
+static void design_low(struct design_zpk_t *zpk, double w)
+{
+	unsigned int i;
+
+	for(i = 0; i < zpk->nz; i++)
+		zpk->z[i] *= w;
+
+	for(i = 0; i < zpk->np; i++)
+		zpk->p[i] *= w;
+
+	zpk->k *= pow(w, zpk->np - zpk->nz);
+}
+
+/**
+ * Transform a prototype to a high-pass at an analog frequency.
+ *   @zpk: The zeros, poles and gain.
+ *   @w: The analog cutoff.
+ */
+
+static void design_high(struct design_zpk_t *zpk, double w)
+{
+	unsigned int i;
+	double complex num = 1.0, den = 1.0;
+
+	for(i = 0; i < zpk->nz; i++) {
+		num *= -zpk->z[i];
+		zpk->z[i] = w / zpk->z[i];
+	}
+
+	for(i = 0; i < zpk->np; i++) {
+		den *= -zpk->p[i];
+		zpk->p[i] = w / zpk->p[i];
+	}
+
+	zpk->k *= creal(num / den);
+
+	while(zpk->nz < zpk->np)
+		zpk->z[zpk->nz++] = 0.0;
+}
+
+/**
+ * Transform a prototype to a band-pass, doubling its roots.
+ *   @zpk: The zeros, poles and gain.
+ *   @w0: The analog center.
+ *   @bw: The analog width.
+ */
+
+static void design_pass(struct design_zpk_t *zpk, double w0, double bw)
+{
+	unsigned int i, n;
+	double complex h, d;
+
+	zpk->k *= pow(bw, zpk->np - zpk->nz);
+
+	for(i = 0, n = zpk->nz; i < n; i++) {
+		h = zpk->z[i] * bw / 2.0;
+		d = csqrt(h * h - w0 * w0);
+		zpk->z[i] = h + d;
+		zpk->z[n + i] = h - d;
+	}
+
+	for(i = 0, n = zpk->np; i < n; i++) {
+		h = zpk->p[i] * bw / 2.0;
+		d = csqrt(h * h - w0 * w0);
+		zpk->p[i] = h + d;
+		zpk->p[n + i] = h - d;
+	}
+
+	n = zpk->np - zpk->nz;
+	zpk->nz *= 2;
+	zpk->np *= 2;
+
+	while(n-- > 0)
+		zpk->z[zpk->nz++] = 0.0;
+}
+
+/**
+ * Map an analog filter to the digital domain with the bilinear transform.
+ *   @zpk: The zeros, poles and gain.
+ *   @rate: The sample rate.
+ */
+
+static void design_bilinear(struct design_zpk_t *zpk, double rate)
+{
+	unsigned int i;
+	double fs2 = 2.0 * rate;
+	double complex num = 1.0, den = 1.0;
+
+	for(i = 0; i < zpk->nz; i++) {
+		num *= fs2 - zpk->z[i];
+		zpk->z[i] = (fs2 + zpk->z[i]) / (fs2 - zpk->z[i]);
+	}
+
+	for(i = 0; i < zpk->np; i++) {
+		den *= fs2 - zpk->p[i];
+		zpk->p[i] = (fs2 + zpk->p[i]) / (fs2 - zpk->p[i]);
+	}
+
+	zpk->k *= creal(num / den);
+
+	while(zpk->nz < zpk->np)
+		zpk->z[zpk->nz++] = -1.0;
+}
+
+
+/**
+ * Group roots into conjugate pairs and pairs of sorted real roots, leaving
+ * at most one single real root last.
+ *   @grp: The output groups.
+ *   @root: The roots.
+ *   @cnt: The number of roots.
+ *   &returns: The number of groups.
+ */
+
+static unsigned int design_group(struct design_grp_t *grp, const double complex *root, unsigned int cnt)
+{
+	unsigned int i, j, n = 0, nreal = 0;
+	double real[MAXROOT], tmp;
+
+	for(i = 0; i < cnt; i++) {
+		if(fabs(cimag(root[i])) <= 1e-10 * (1.0 + cabs(root[i]))) {
+			real[nreal] = creal(root[i]);
+
+			for(j = nreal++; (j > 0) && (real[j] < real[j - 1]); j--)
+				tmp = real[j], real[j] = real[j - 1], real[j - 1] = tmp;
+		}
+		else if(cimag(root[i]) > 0.0) {
+			grp[n].r[0] = root[i];
+			grp[n].r[1] = conj(root[i]);
+			grp[n++].n = 2;
+		}
+	}
+
+	for(i = 0; i < nreal; i += 2) {
+		grp[n].r[0] = real[i];
+		grp[n].r[1] = (i + 1 < nreal) ? real[i + 1] : 0.0;
+		grp[n++].n = (i + 1 < nreal) ? 2 : 1;
+	}
+
+	return n;
+}
+
+/**
+ * Retrieve the largest radius of a group.
+ *   @grp: The group.
+ *   &returns: The radius.
+ */
+
+static double design_radius(const struct design_grp_t *grp)
+{
+	return (grp->n == 2) ? fmax(cabs(grp->r[0]), cabs(grp->r[1])) : cabs(grp->r[0]);
+}
+
+/**
+ * Expand a group into the polynomial '1 + c1 z^-1 + c2 z^-2'.
+ *   @grp: The group.
+ *   @c1: The first-order coefficient.
+ *   @c2: The second-order coefficient.
+ */
+
+static void design_poly(const struct design_grp_t *grp, double *c1, double *c2)
+{
+	if(grp->n == 2) {
+		*c1 = -creal(grp->r[0] + grp->r[1]);
+		*c2 = creal(grp->r[0] * grp->r[1]);
+	}
+	else {
+		*c1 = -creal(grp->r[0]);
+		*c2 = 0.0;
+	}
+}
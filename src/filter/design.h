@@ -0,0 +1,100 @@
+#ifndef FILTER_DESIGN_H
+#define FILTER_DESIGN_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/**
+ * Filter design family enumerator.
+ *   @dsp_design_butter: Butterworth.
+ *   @dsp_design_cheby1: Chebyshev type I, with passband ripple.
+ *   @dsp_design_cheby2: Chebyshev type II, with stopband attenuation.
+ *   @dsp_design_linkwitz: Linkwitz-Riley, a squared Butterworth of half the
+ *     order.
+ */
+
+enum dsp_design_e {
+	dsp_design_butter,
+	dsp_design_cheby1,
+	dsp_design_cheby2,
+	dsp_design_linkwitz
+};
+
+/**
+ * Filter band enumerator.
+ *   @dsp_band_low: Low-pass.
+ *   @dsp_band_high: High-pass.
+ *   @dsp_band_pass: Band-pass.
+ */
+
+enum dsp_band_e {
+	dsp_band_low,
+	dsp_band_high,
+	dsp_band_pass
+};
+
+/**
+ * Filter design parameters.
+ *   @type: The design family.
+ *   @band: The band.
+ *   @order: The order. Band-pass designs have twice as many poles.
+ *   @rate: The sample rate.
+ *   @freq: The cutoff, or the center for band-pass. For Chebyshev type II
+ *     this is the stopband edge.
+ *   @width: The band-pass width.
+ *   @ripple: The passband ripple or stopband attenuation in decibels.
+ */
+
+struct dsp_design_param_t {
+	enum dsp_design_e type;
+	enum dsp_band_e band;
+	unsigned int order;
+	double rate, freq, width, ripple;
+};
+
+/**
+ * Second-order section. The output is 'b0 x[n] + b1 x[n-1] + b2 x[n-2] -
+ * a1 y[n-1] - a2 y[n-2]'.
+ *   @b0, b1, b2: The feed-forward coefficients.
+ *   @a1, a2: The feedback coefficients.
+ */
+
+struct dsp_sos_t {
+	double b0, b1, b2, a1, a2;
+};
+
+/**
+ * Filter design, shared between all users of the same parameters and
+ * immutable once created.
+ *   @param: The parameters.
+ *   @nsos: The number of sections.
+ *   @sos: The sections, ordered by increasing pole radius.
+ */
+
+struct dsp_design_t {
+	struct dsp_design_param_t param;
+
+	unsigned int nsos;
+	struct dsp_sos_t sos[];
+};
+
+
+/*
+ * filter design function declarations
+ */
+
+struct dsp_design_t *dsp_design_get(const struct dsp_design_param_t *param);
+void dsp_design_put(struct dsp_design_t *design);
+
+double dsp_design_mag(const struct dsp_design_t *design, double freq);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
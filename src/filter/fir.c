@@ -0,0 +1,146 @@
+#include "../common.h"
+#include "fir.h"
+#include "sparse.h"
+#include "../simd.h"
+
+
+/*
+ * local function declarations
+ */
+
+static int pt_cmp(const void *left, const void *right);
+static void fir_seg(struct dsp_filter_fir_t *fir, const double *in, double *out, unsigned int len);
+
+
+/**
+ * Create a sparse block FIR filter. Each point adds its value times the
+ * input delayed by its offset to the direct input, matching
+ * 'dsp_filter_sparse_fir'.
+ *   @pt: The point set.
+ *   @npts: The number of points.
+ *   &returns: The filter.
+ */
+
+_export
+struct dsp_filter_fir_t *dsp_filter_fir_new(const struct dsp_pt_t *pt, unsigned int npts)
+{
+	unsigned int i, max = 0;
+	struct dsp_filter_fir_t *fir;
+
+	fir = mem_alloc(sizeof(struct dsp_filter_fir_t) + npts * sizeof(struct dsp_pt_t));
+	fir->npts = npts;
+	mem_copy(fir->pt, pt, npts * sizeof(struct dsp_pt_t));
+	qsort(fir->pt, npts, sizeof(struct dsp_pt_t), pt_cmp);
+
+	for(i = 0; i < npts; i++)
+		max = (fir->pt[i].n > max) ? fir->pt[i].n : max;
+
+	fir->idx = 0;
+	fir->len = max + DSP_FIR_BLOCK;
+	fir->hist = mem_alloc(2 * fir->len * sizeof(double));
+	mem_set(fir->hist, 0x00, 2 * fir->len * sizeof(double));
+
+	return fir;
+}
+
+/**
+ * Create a sparse block FIR filter from the points of a sparse filter. An
+ * offset of zero is read as the full ring length, as in the sparse filter.
+ *   @sparse: The sparse filter.
+ *   &returns: The filter.
+ */
+
+_export
+struct dsp_filter_fir_t *dsp_filter_fir_sparse(const struct dsp_filter_sparse_t *sparse)
+{
+	unsigned int i, len = sparse->ring->len;
+	struct dsp_pt_t pt[sparse->npts];
+
+	for(i = 0; i < sparse->npts; i++)
+		pt[i] = (struct dsp_pt_t){ (sparse->pt[i].n % len) ? (sparse->pt[i].n % len) : len, sparse->pt[i].a };
+
+	return dsp_filter_fir_new(pt, sparse->npts);
+}
+
+/**
+ * Delete a sparse block FIR filter.
+ *   @fir: The filter.
+ */
+
+_export
+void dsp_filter_fir_delete(struct dsp_filter_fir_t *fir)
+{
+	mem_free(fir->hist);
+	mem_free(fir);
+}
+
+
+/**
+ * Process a block through the sparse FIR filter. The input and output may
+ * be the same buffer.
+ *   @fir: The filter.
+ *   @in: The input.
+ *   @out: The output.
+ *   @len: The length.
+ */
+
+_export
+void dsp_filter_fir_proc(struct dsp_filter_fir_t *fir, const double *in, double *out, unsigned int len)
+{
+	unsigned int n;
+
+	while(len > 0) {
+		n = fir->len - fir->idx;
+		n = (n < DSP_FIR_BLOCK) ? n : DSP_FIR_BLOCK;
+		n = (n < len) ? n : len;
+
+		fir_seg(fir, in, out, n);
+
+		fir->idx += n;
+		if(fir->idx == fir->len)
+			fir->idx = 0;
+
+		in += n;
+		out += n;
+		len -= n;
+	}
+}
+
+
+/**
+ * Compare two points by offset.
+ *   @left: The left point.
+ *   @right: The right point.
+ *   &returns: Their order.
+ */
+
+static int pt_cmp(const void *left, const void *right)
+{
+	const struct dsp_pt_t *l = left, *r = right;
+
+	return (l->n > r->n) - (l->n < r->n);
+}
+
+/**
+ * Process a segment that does not wrap the history. The segment is written
+ * to both halves of the history first; since the history holds the longest
+ * offset plus a full block, no tap reads a slot written by this segment
+ * except through the upper half.
+ *   @fir: The filter.
+ *   @in: The input.
+ *   @out: The output.
+ *   @len: The length, at most 'DSP_FIR_BLOCK'.
+ */
+
+static void fir_seg(struct dsp_filter_fir_t *fir, const double *in, double *out, unsigned int len)
+{
+	unsigned int i;
+	double *cur = fir->hist + fir->len + fir->idx;
+
+	mem_copy(fir->hist + fir->idx, in, len * sizeof(double));
+	mem_copy(cur, in, len * sizeof(double));
+	mem_copy(out, cur, len * sizeof(double));
+
+	for(i = 0; i < fir->npts; i++)
+		dsp_vec_axpy(out, cur - fir->pt[i].n, fir->pt[i].a, len);
+}
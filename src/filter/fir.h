@@ -0,0 +1,58 @@
+#ifndef FILTER_FIR_H
+#define FILTER_FIR_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * block fir definitions
+ */
+
+#define DSP_FIR_BLOCK 64
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_filter_sparse_t;
+
+/**
+ * Sparse block FIR filter. The history is mirrored so that the delayed input
+ * for every tap over a block is a single contiguous run, and taps are sorted
+ * by offset so neighbouring taps read neighbouring memory.
+ *   @idx, len: The write index and history length.
+ *   @hist: The mirrored history, twice the history length.
+ *   @npts: The number of points.
+ *   @pt: The point set, sorted by offset.
+ */
+
+struct dsp_filter_fir_t {
+	unsigned int idx, len;
+	double *hist;
+
+	unsigned int npts;
+	struct dsp_pt_t pt[];
+};
+
+
+/*
+ * block fir function declarations
+ */
+
+struct dsp_filter_fir_t *dsp_filter_fir_new(const struct dsp_pt_t *pt, unsigned int npts);
+struct dsp_filter_fir_t *dsp_filter_fir_sparse(const struct dsp_filter_sparse_t *sparse);
+void dsp_filter_fir_delete(struct dsp_filter_fir_t *fir);
+
+void dsp_filter_fir_proc(struct dsp_filter_fir_t *fir, const double *in, double *out, unsigned int len);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
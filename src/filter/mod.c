@@ -0,0 +1,219 @@
+#include "../common.h"
+#include "mod.h"
+#include "butter.h"
+#include "moog.h"
+#include "../probe.h"
+#include "res.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void mod_coef(struct dsp_filter_mod_t *mod, double freq, double *coef);
+static inline void mod_run(struct dsp_filter_mod_t *mod, const double *in, double *out, const double *freq, unsigned int len, enum dsp_mod_e kind);
+
+
+/**
+ * Create a modulated filter.
+ *   @kind: The filter kind.
+ *   @rate: The sample rate.
+ *   @res: The resonance constant, ignored by the butterworth filters.
+ *   &returns: The filter.
+ */
+
+_export
+struct dsp_filter_mod_t *dsp_filter_mod_new(enum dsp_mod_e kind, unsigned int rate, double res)
+{
+	struct dsp_filter_mod_t *mod;
+
+	mod = mem_alloc(sizeof(struct dsp_filter_mod_t));
+	mod->kind = kind;
+	mod->rate = rate;
+	mod->res = res;
+
+	switch(kind) {
+	case dsp_mod_butter2_low:
+	case dsp_mod_butter2_high:
+		mod->ncoef = sizeof(struct dsp_butter_2) / sizeof(double);
+		break;
+
+	case dsp_mod_moog:
+		mod->ncoef = sizeof(struct dsp_moog_t) / sizeof(double);
+		break;
+
+	case dsp_mod_notch_res:
+	case dsp_mod_notch_cut:
+		mod->ncoef = sizeof(struct dsp_notch_t) / sizeof(double);
+		break;
+
+	default:
+		throw("Invalid modulated filter kind.");
+	}
+
+	dsp_filter_mod_reset(mod);
+
+	return mod;
+}
+
+/**
+ * Delete a modulated filter.
+ *   @mod: The filter.
+ */
+
+_export
+void dsp_filter_mod_delete(struct dsp_filter_mod_t *mod)
+{
+	mem_free(mod);
+}
+
+/**
+ * Reset a modulated filter, clearing its history. The next block starts
+ * directly on the coefficients for its first frequency.
+ *   @mod: The filter.
+ */
+
+_export
+void dsp_filter_mod_reset(struct dsp_filter_mod_t *mod)
+{
+	mod->init = false;
+	mod->left = 0;
+	mod->data = dsp_data_4();
+}
+
+
+/**
+ * Process a block through a modulated filter. The frequency is read once
+ * per control period, and the coefficients ramp to their new values over
+ * the following period. For the butterworth and notch kinds the ramped
+ * values are the feedback coefficients of a second-order section, so a
+ * ramp between two stable sections stays stable, since the stability
+ * region is convex. The moog constants enter its recurrence as products,
+ * so no such guarantee holds for it. The input and output may be the same
+ * buffer.
+ *   @mod: The filter.
+ *   @in: The input.
+ *   @out: The output.
+ *   @freq: The per-sample frequency.
+ *   @len: The length.
+ */
+
+_export
+void dsp_filter_mod_proc(struct dsp_filter_mod_t *mod, const double *in, double *out, const double *freq, unsigned int len)
+{
+	switch(mod->kind) {
+	case dsp_mod_butter2_low: mod_run(mod, in, out, freq, len, dsp_mod_butter2_low); break;
+	case dsp_mod_butter2_high: mod_run(mod, in, out, freq, len, dsp_mod_butter2_high); break;
+	case dsp_mod_moog: mod_run(mod, in, out, freq, len, dsp_mod_moog); break;
+	case dsp_mod_notch_res: mod_run(mod, in, out, freq, len, dsp_mod_notch_res); break;
+	case dsp_mod_notch_cut: mod_run(mod, in, out, freq, len, dsp_mod_notch_cut); break;
+	}
+}
+
+
+/**
+ * Compute the coefficients for a frequency.
+ *   @mod: The filter.
+ *   @freq: The frequency.
+ *   @coef: The output coefficients.
+ */
+
+static void mod_coef(struct dsp_filter_mod_t *mod, double freq, double *coef)
+{
+	struct dsp_butter_2 butter;
+	struct dsp_moog_t moog;
+	struct dsp_notch_t notch;
+
+	switch(mod->kind) {
+	case dsp_mod_butter2_low:
+	case dsp_mod_butter2_high:
+		butter = dsp_filt_butter2_init(mod->rate, freq);
+		mem_copy(coef, &butter, sizeof(butter));
+		break;
+
+	case dsp_mod_moog:
+		moog = dsp_moog_init(mod->rate, freq, mod->res);
+		mem_copy(coef, &moog, sizeof(moog));
+		break;
+
+	case dsp_mod_notch_res:
+	case dsp_mod_notch_cut:
+		notch = dsp_notch_init(mod->rate, freq, mod->res);
+		mem_copy(coef, &notch, sizeof(notch));
+		break;
+	}
+}
+
+/**
+ * Run the filter over a block. The kind is a constant at every call site,
+ * so the kernel selection folds away and the history stays in locals.
+ *   @mod: The filter.
+ *   @in: The input.
+ *   @out: The output.
+ *   @freq: The per-sample frequency.
+ *   @len: The length.
+ *   @kind: The filter kind.
+ */
+
+static inline void mod_run(struct dsp_filter_mod_t *mod, const double *in, double *out, const double *freq, unsigned int len, enum dsp_mod_e kind)
+{
+	unsigned int i, k, n = mod->ncoef, left = mod->left;
+	double c[5], tgt[5], step[5];
+	struct dsp_data_2 d2;
+	struct dsp_data_4 d4 = mod->data;
+
+	mem_copy(c, mod->cur, sizeof(c));
+	mem_copy(step, mod->step, sizeof(step));
+	d2 = (struct dsp_data_2){ { d4.x[0], d4.x[1] }, { d4.y[0], d4.y[1] } };
+
+	for(i = 0; i < len; i++) {
+		if(left == 0) {
+			mod_coef(mod, freq[i], tgt);
+
+			if(!mod->init) {
+				mem_copy(c, tgt, sizeof(tgt));
+				mod->init = true;
+			}
+
+			for(k = 0; k < n; k++)
+				step[k] = (tgt[k] - c[k]) / DSP_MOD_PERIOD;
+
+			left = DSP_MOD_PERIOD;
+		}
+
+		for(k = 0; k < n; k++)
+			c[k] += step[k];
+
+		left--;
+
+		switch(kind) {
+		case dsp_mod_butter2_low:
+			out[i] = dsp_filt_butter2_low(in[i], (struct dsp_butter_2){ c[0], c[1], c[2] }, &d2);
+			break;
+
+		case dsp_mod_butter2_high:
+			out[i] = dsp_filt_butter2_high(in[i], (struct dsp_butter_2){ c[0], c[1], c[2] }, &d2);
+			break;
+
+		case dsp_mod_moog:
+			out[i] = dsp_moog_next(in[i], (struct dsp_moog_t){ c[0], c[1], c[2], c[3] }, &d4);
+			break;
+
+		case dsp_mod_notch_res:
+			out[i] = dsp_notch_res(in[i], (struct dsp_notch_t){ c[0], c[1], c[2], c[3], c[4] }, &d2);
+			break;
+
+		case dsp_mod_notch_cut:
+			out[i] = dsp_notch_cut(in[i], (struct dsp_notch_t){ c[0], c[1], c[2], c[3], c[4] }, &d2);
+			break;
+		}
+	}
+
+	if(kind != dsp_mod_moog)
+		d4 = (struct dsp_data_4){ { d2.x[0], d2.x[1], 0.0, 0.0 }, { d2.y[0], d2.y[1], 0.0, 0.0 } };
+
+	mod->left = left;
+	mem_copy(mod->cur, c, sizeof(c));
+	mem_copy(mod->step, step, sizeof(step));
+	mod->data = d4;
+}
@@ -0,0 +1,75 @@
+#ifndef FILTER_MOD_H
+#define FILTER_MOD_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * modulated filter definitions
+ */
+
+#define DSP_MOD_PERIOD 32
+
+
+/**
+ * Modulated filter kind enumerator.
+ *   @dsp_mod_butter2_low: 2nd-order low-pass butterworth.
+ *   @dsp_mod_butter2_high: 2nd-order high-pass butterworth.
+ *   @dsp_mod_moog: Moog resonant filter.
+ *   @dsp_mod_notch_res: Notch filter with resonance.
+ *   @dsp_mod_notch_cut: Notch filter by cutting.
+ */
+
+enum dsp_mod_e {
+	dsp_mod_butter2_low,
+	dsp_mod_butter2_high,
+	dsp_mod_moog,
+	dsp_mod_notch_res,
+	dsp_mod_notch_cut
+};
+
+/**
+ * Modulated filter. Coefficients are recomputed from the frequency once
+ * every 'DSP_MOD_PERIOD' samples and ramped linearly in between.
+ *   @kind: The filter kind.
+ *   @rate: The sample rate.
+ *   @res: The resonance constant, used by the moog and notch filters.
+ *   @ncoef, left: The number of coefficients and samples left on the ramp.
+ *   @init: Whether the coefficients have been set.
+ *   @cur, step: The current coefficients and their per-sample step.
+ *   @data: The history.
+ */
+
+struct dsp_filter_mod_t {
+	enum dsp_mod_e kind;
+	unsigned int rate;
+	double res;
+
+	unsigned int ncoef, left;
+	bool init;
+	double cur[5], step[5];
+
+	struct dsp_data_4 data;
+};
+
+
+/*
+ * modulated filter function declarations
+ */
+
+struct dsp_filter_mod_t *dsp_filter_mod_new(enum dsp_mod_e kind, unsigned int rate, double res);
+void dsp_filter_mod_delete(struct dsp_filter_mod_t *mod);
+void dsp_filter_mod_reset(struct dsp_filter_mod_t *mod);
+
+void dsp_filter_mod_proc(struct dsp_filter_mod_t *mod, const double *in, double *out, const double *freq, unsigned int len);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -60,6 +60,27 @@ static inline double dsp_moog_next(double x, struct dsp_moog_t c, struct dsp_dat
 	return y;
 }
 
+/**
+ * Process a block with the moog resonant filter. The input and output may
+ * be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @c: The constant.
+ *   @data: The historical data.
+ */
+
+static inline void dsp_moog_block(const double *x, double *y, unsigned int len, struct dsp_moog_t c, struct dsp_data_4 *data)
+{
+	unsigned int i;
+	struct dsp_data_4 d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_moog_next(x[i], c, &d);
+
+	*data = d;
+}
+
 /* %~dsp.h% */
 
 /*
@@ -0,0 +1,504 @@
+#include "../common.h"
+#include "multirate.h"
+#include "../simd.h"
+
+
+/*
+ * multirate definitions
+ */
+
+#define BLKLEN 256
+
+
+/**
+ * Polyphase table structure. Each phase keeps only the span between its
+ * first and last nonzero taps, reversed so that each output is a single
+ * inner product over contiguous history. Phases start on vector boundaries
+ * within one allocation.
+ *   @factor: The number of phases.
+ *   @span: The longest history needed by any phase.
+ *   @off, len: The offset and length of each phase span.
+ *   @coef: The coefficient pointer of each phase.
+ *   @mem: The coefficient allocation.
+ */
+
+struct multirate_tab_t {
+	unsigned int factor, span;
+	unsigned int *off, *len;
+	double **coef;
+	void *mem;
+};
+
+/**
+ * Decimator structure.
+ *   @tab: The polyphase table.
+ *   @ph: The input phase.
+ *   @wr, cap: The history write index and capacity.
+ *   @hist: The history of each phase, 'cap' samples each.
+ */
+
+struct dsp_decim_t {
+	struct multirate_tab_t tab;
+
+	unsigned int ph;
+	unsigned int wr, cap;
+	double *hist;
+};
+
+/**
+ * Interpolator structure.
+ *   @tab: The polyphase table.
+ *   @wr, cap: The history write index and capacity.
+ *   @hist: The input history.
+ */
+
+struct dsp_interp_t {
+	struct multirate_tab_t tab;
+
+	unsigned int wr, cap;
+	double *hist;
+};
+
+/**
+ * Oversampling structure.
+ *   @nchan, factor: The channel count and oversampling factor.
+ *   @func: The callback run at the higher rate.
+ *   @arg: The callback argument.
+ *   @interp: The interpolators.
+ *   @decim: The decimators.
+ *   @len: The scratch capacity at the base rate.
+ *   @buf: The scratch buffer, 'len * factor' samples per channel.
+ */
+
+struct dsp_over_t {
+	unsigned int nchan, factor;
+	dsp_flow_f func;
+	void *arg;
+
+	struct dsp_interp_t **interp;
+	struct dsp_decim_t **decim;
+
+	unsigned int len;
+	double *buf;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static struct multirate_tab_t tab_new(unsigned int factor, const double *coef, unsigned int ntaps, double gain);
+static void tab_destroy(struct multirate_tab_t *tab);
+
+
+/**
+ * Compute the Kaiser window.
+ *   @t: The position in the range negative one to one.
+ *   @beta: The window parameter.
+ *   &returns: The window value.
+ */
+
+_export
+double dsp_multirate_kaiser(double t, double beta)
+{
+	unsigned int k;
+	double x, term, num, den;
+
+	if(fabs(t) >= 1.0)
+		return 0.0;
+
+	x = beta * sqrt(1.0 - t * t) / 2.0;
+	for(k = 1, num = 1.0, term = 1.0; k < 32; k++) {
+		term *= (x / k) * (x / k);
+		num += term;
+	}
+
+	x = beta / 2.0;
+	for(k = 1, den = 1.0, term = 1.0; k < 32; k++) {
+		term *= (x / k) * (x / k);
+		den += term;
+	}
+
+	return num / den;
+}
+
+/**
+ * Design a windowed-sinc low-pass filter using a Kaiser window. The
+ * coefficients are normalized to unity gain at zero frequency.
+ *   @coef: The output coefficients.
+ *   @ntaps: The number of taps.
+ *   @cutoff: The cutoff as a fraction of the sample rate, below one half.
+ *   @beta: The Kaiser window parameter.
+ */
+
+_export
+void dsp_multirate_sinc(double *coef, unsigned int ntaps, double cutoff, double beta)
+{
+	unsigned int i;
+	double u, sum = 0.0, mid = (ntaps - 1) / 2.0;
+
+	for(i = 0; i < ntaps; i++) {
+		u = i - mid;
+		coef[i] = ((u == 0.0) ? 1.0 : sin(2.0 * M_PI * cutoff * u) / (2.0 * M_PI * cutoff * u)) * dsp_multirate_kaiser((mid > 0.0) ? (u / (mid + 1.0)) : 0.0, beta);
+		sum += coef[i];
+	}
+
+	for(i = 0; i < ntaps; i++)
+		coef[i] /= sum;
+}
+
+/**
+ * Design a halfband low-pass filter. Every other tap besides the center is
+ * exactly zero, which the polyphase tables skip.
+ *   @coef: The output coefficients.
+ *   @ntaps: The number of taps, three more than a multiple of four.
+ *   @beta: The Kaiser window parameter.
+ */
+
+_export
+void dsp_multirate_halfband(double *coef, unsigned int ntaps, double beta)
+{
+	unsigned int i, mid = (ntaps - 1) / 2;
+	double sum = 0.0;
+
+	if((ntaps % 4) != 3)
+		throw("Invalid halfband length %u.", ntaps);
+
+	dsp_multirate_sinc(coef, ntaps, 0.25, beta);
+
+	for(i = 0; i < ntaps; i++) {
+		if((i != mid) && (((mid - i) % 2) == 0))
+			coef[i] = 0.0;
+		else if(i != mid)
+			sum += coef[i];
+	}
+
+	for(i = 0; i < ntaps; i++)
+		coef[i] = (i == mid) ? 0.5 : (0.5 * coef[i] / sum);
+}
+
+
+/**
+ * Create a polyphase decimator. Only the kept outputs are computed.
+ *   @factor: The decimation factor.
+ *   @coef: The low-pass coefficients at the input rate.
+ *   @ntaps: The number of taps.
+ *   &returns: The decimator.
+ */
+
+_export
+struct dsp_decim_t *dsp_decim_new(unsigned int factor, const double *coef, unsigned int ntaps)
+{
+	struct dsp_decim_t *decim;
+
+	if(factor == 0)
+		throw("Invalid decimation factor.");
+
+	decim = mem_alloc(sizeof(struct dsp_decim_t));
+	decim->tab = tab_new(factor, coef, ntaps, 1.0);
+	decim->ph = 0;
+	decim->wr = decim->tab.span;
+	decim->cap = decim->tab.span + BLKLEN;
+	decim->hist = mem_alloc(factor * decim->cap * sizeof(double));
+	mem_set(decim->hist, 0x00, factor * decim->cap * sizeof(double));
+
+	return decim;
+}
+
+/**
+ * Delete a polyphase decimator.
+ *   @decim: The decimator.
+ */
+
+_export
+void dsp_decim_delete(struct dsp_decim_t *decim)
+{
+	tab_destroy(&decim->tab);
+	mem_free(decim->hist);
+	mem_free(decim);
+}
+
+/**
+ * Process data through the decimator. Input sample 'i * factor' produces
+ * output 'i', counting from the creation of the decimator.
+ *   @decim: The decimator.
+ *   @in: The input.
+ *   @len: The input length.
+ *   @out: The output, with room for 'len / factor + 1' samples.
+ *   &returns: The number of output samples.
+ */
+
+_export
+unsigned int dsp_decim_proc(struct dsp_decim_t *decim, const double *in, unsigned int len, double *out)
+{
+	unsigned int i, p, n = 0, m = decim->tab.factor;
+	double y;
+
+	for(i = 0; i < len; i++) {
+		p = (m - decim->ph) % m;
+		decim->hist[p * decim->cap + decim->wr] = in[i];
+		decim->ph = (decim->ph + 1) % m;
+
+		if(p != 0)
+			continue;
+
+		for(y = 0.0, p = 0; p < m; p++) {
+			const double *x = decim->hist + p * decim->cap + decim->wr + 1 - decim->tab.off[p] - decim->tab.len[p];
+
+			y += dsp_vec_dot(decim->tab.coef[p], x, decim->tab.len[p]);
+		}
+
+		out[n++] = y;
+
+		if(++decim->wr == decim->cap) {
+			for(p = 0; p < m; p++)
+				mem_move(decim->hist + p * decim->cap, decim->hist + p * decim->cap + decim->cap - decim->tab.span, decim->tab.span * sizeof(double));
+
+			decim->wr = decim->tab.span;
+		}
+	}
+
+	return n;
+}
+
+
+/**
+ * Create a polyphase interpolator. The coefficients are scaled by the factor
+ * so the passband has unity gain.
+ *   @factor: The interpolation factor.
+ *   @coef: The low-pass coefficients at the output rate.
+ *   @ntaps: The number of taps.
+ *   &returns: The interpolator.
+ */
+
+_export
+struct dsp_interp_t *dsp_interp_new(unsigned int factor, const double *coef, unsigned int ntaps)
+{
+	struct dsp_interp_t *interp;
+
+	if(factor == 0)
+		throw("Invalid interpolation factor.");
+
+	interp = mem_alloc(sizeof(struct dsp_interp_t));
+	interp->tab = tab_new(factor, coef, ntaps, factor);
+	interp->wr = interp->tab.span;
+	interp->cap = interp->tab.span + BLKLEN;
+	interp->hist = mem_alloc(interp->cap * sizeof(double));
+	mem_set(interp->hist, 0x00, interp->cap * sizeof(double));
+
+	return interp;
+}
+
+/**
+ * Delete a polyphase interpolator.
+ *   @interp: The interpolator.
+ */
+
+_export
+void dsp_interp_delete(struct dsp_interp_t *interp)
+{
+	tab_destroy(&interp->tab);
+	mem_free(interp->hist);
+	mem_free(interp);
+}
+
+/**
+ * Process data through the interpolator.
+ *   @interp: The interpolator.
+ *   @in: The input.
+ *   @len: The input length.
+ *   @out: The output, 'len * factor' samples.
+ */
+
+_export
+void dsp_interp_proc(struct dsp_interp_t *interp, const double *in, unsigned int len, double *out)
+{
+	unsigned int i, p, l = interp->tab.factor;
+
+	for(i = 0; i < len; i++) {
+		interp->hist[interp->wr] = in[i];
+
+		for(p = 0; p < l; p++) {
+			const double *x = interp->hist + interp->wr + 1 - interp->tab.off[p] - interp->tab.len[p];
+
+			*out++ = dsp_vec_dot(interp->tab.coef[p], x, interp->tab.len[p]);
+		}
+
+		if(++interp->wr == interp->cap) {
+			mem_move(interp->hist, interp->hist + interp->cap - interp->tab.span, interp->tab.span * sizeof(double));
+			interp->wr = interp->tab.span;
+		}
+	}
+}
+
+
+/**
+ * Create an oversampling wrapper. The wrapped callback runs in place at the
+ * higher rate between a windowed-sinc interpolator and decimator, using a
+ * halfband design when oversampling by two, so the wrapper itself is a flow
+ * callback at the base rate.
+ *   @nchan: The number of channels.
+ *   @factor: The oversampling factor.
+ *   @ntaps: The number of filter taps at the higher rate, rounded up so that
+ *     the delay is a whole number of samples at the base rate.
+ *   @func: The callback run at the higher rate.
+ *   @arg: The callback argument.
+ *   &returns: The oversampler.
+ */
+
+_export
+struct dsp_over_t *dsp_over_new(unsigned int nchan, unsigned int factor, unsigned int ntaps, dsp_flow_f func, void *arg)
+{
+	unsigned int i;
+	double *coef;
+	struct dsp_over_t *over;
+
+	if(factor == 0)
+		throw("Invalid oversampling factor.");
+
+	if(factor == 2)
+		ntaps |= 3;
+	else
+		ntaps = (ntaps + factor - 1) / factor * factor + 1;
+
+	coef = mem_alloc(ntaps * sizeof(double));
+
+	if(factor == 2)
+		dsp_multirate_halfband(coef, ntaps, 8.0);
+	else
+		dsp_multirate_sinc(coef, ntaps, 0.45 / factor, 8.0);
+
+	over = mem_alloc(sizeof(struct dsp_over_t));
+	over->nchan = nchan;
+	over->factor = factor;
+	over->func = func;
+	over->arg = arg;
+	over->interp = mem_alloc(nchan * sizeof(void *));
+	over->decim = mem_alloc(nchan * sizeof(void *));
+	over->len = 0;
+	over->buf = NULL;
+
+	for(i = 0; i < nchan; i++) {
+		over->interp[i] = dsp_interp_new(factor, coef, ntaps);
+		over->decim[i] = dsp_decim_new(factor, coef, ntaps);
+	}
+
+	mem_free(coef);
+
+	return over;
+}
+
+/**
+ * Delete an oversampling wrapper.
+ *   @over: The oversampler.
+ */
+
+_export
+void dsp_over_delete(struct dsp_over_t *over)
+{
+	unsigned int i;
+
+	for(i = 0; i < over->nchan; i++) {
+		dsp_interp_delete(over->interp[i]);
+		dsp_decim_delete(over->decim[i]);
+	}
+
+	mem_free(over->interp);
+	mem_free(over->decim);
+	mem_delete(over->buf);
+	mem_free(over);
+}
+
+/**
+ * Oversampling flow callback, processing the buffers in place. Create a
+ * node with 'dsp_node_new(nchan, nchan, dsp_over_proc, over)'.
+ *   @buf: The buffers, one per channel.
+ *   @len: The length.
+ *   @arg: The oversampler.
+ */
+
+_export
+void dsp_over_proc(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i;
+	struct dsp_over_t *over = arg;
+	double *up[over->nchan];
+
+	if(len > over->len) {
+		over->len = len;
+		over->buf = mem_realloc(over->buf, over->nchan * len * over->factor * sizeof(double));
+	}
+
+	for(i = 0; i < over->nchan; i++) {
+		up[i] = over->buf + i * over->len * over->factor;
+		dsp_interp_proc(over->interp[i], buf[i], len, up[i]);
+	}
+
+	if(over->func != NULL)
+		over->func(up, len * over->factor, over->arg);
+
+	for(i = 0; i < over->nchan; i++)
+		dsp_decim_proc(over->decim[i], up[i], len * over->factor, buf[i]);
+}
+
+
+/**
+ * Create a polyphase table.
+ *   @factor: The number of phases.
+ *   @coef: The coefficients.
+ *   @ntaps: The number of taps.
+ *   @gain: The coefficient gain.
+ *   &returns: The table.
+ */
+
+static struct multirate_tab_t tab_new(unsigned int factor, const double *coef, unsigned int ntaps, double gain)
+{
+	unsigned int p, k, n, lo, hi, size = 0;
+	double *data;
+	struct multirate_tab_t tab;
+
+	tab.factor = factor;
+	tab.span = 1;
+	tab.off = mem_alloc(factor * sizeof(unsigned int));
+	tab.len = mem_alloc(factor * sizeof(unsigned int));
+	tab.coef = mem_alloc(factor * sizeof(double *));
+
+	for(p = 0; p < factor; p++) {
+		n = (p < ntaps) ? ((ntaps - p + factor - 1) / factor) : 0;
+
+		for(lo = 0; (lo < n) && (coef[p + lo * factor] == 0.0); lo++);
+		for(hi = n; (hi > lo) && (coef[p + (hi - 1) * factor] == 0.0); hi--);
+
+		tab.off[p] = lo;
+		tab.len[p] = hi - lo;
+		tab.span = (hi > tab.span) ? hi : tab.span;
+		size += (tab.len[p] + 3) & ~3;
+	}
+
+	tab.mem = mem_alloc((size + 1) * sizeof(double) + sizeof(dsp_vec_t));
+	data = (double *)(((uintptr_t)tab.mem + sizeof(dsp_vec_t) - 1) & ~(uintptr_t)(sizeof(dsp_vec_t) - 1));
+
+	for(size = p = 0; p < factor; p++) {
+		tab.coef[p] = data + size;
+
+		for(k = 0; k < tab.len[p]; k++)
+			tab.coef[p][k] = gain * coef[p + (tab.off[p] + tab.len[p] - 1 - k) * factor];
+
+		size += (tab.len[p] + 3) & ~3;
+	}
+
+	return tab;
+}
+
+/**
+ * Destroy a polyphase table.
+ *   @tab: The table.
+ */
+
+static void tab_destroy(struct multirate_tab_t *tab)
+{
+	mem_free(tab->off);
+	mem_free(tab->len);
+	mem_free(tab->coef);
+	mem_free(tab->mem);
+}
@@ -0,0 +1,44 @@
+#ifndef FILTER_MULTIRATE_H
+#define FILTER_MULTIRATE_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_decim_t;
+struct dsp_interp_t;
+struct dsp_over_t;
+
+/*
+ * multirate function declarations
+ */
+
+double dsp_multirate_kaiser(double t, double beta);
+void dsp_multirate_sinc(double *coef, unsigned int ntaps, double cutoff, double beta);
+void dsp_multirate_halfband(double *coef, unsigned int ntaps, double beta);
+
+struct dsp_decim_t *dsp_decim_new(unsigned int factor, const double *coef, unsigned int ntaps);
+void dsp_decim_delete(struct dsp_decim_t *decim);
+unsigned int dsp_decim_proc(struct dsp_decim_t *decim, const double *in, unsigned int len, double *out);
+
+struct dsp_interp_t *dsp_interp_new(unsigned int factor, const double *coef, unsigned int ntaps);
+void dsp_interp_delete(struct dsp_interp_t *interp);
+void dsp_interp_proc(struct dsp_interp_t *interp, const double *in, unsigned int len, double *out);
+
+struct dsp_over_t *dsp_over_new(unsigned int nchan, unsigned int factor, unsigned int ntaps, dsp_flow_f func, void *arg);
+void dsp_over_delete(struct dsp_over_t *over);
+void dsp_over_proc(double **buf, unsigned int len, void *arg);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -112,6 +112,70 @@ static inline double dsp_rc_pass(double x, struct dsp_rc_2 c, struct dsp_data_2
 	return y;
 }
 
+/**
+ * Process a block with a low-pass RC filter. The history is copied to a
+ * local so that it stays in registers across the loop. The input and
+ * output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @c: The constant.
+ *   @data: The one-point data store.
+ */
+
+static inline void dsp_rc_low_block(const double *x, double *y, unsigned int len, struct dsp_rc_1 c, struct dsp_data_1 *data)
+{
+	unsigned int i;
+	struct dsp_data_1 d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_rc_low(x[i], c, &d);
+
+	*data = d;
+}
+
+/**
+ * Process a block with a high-pass RC filter. The input and output may be
+ * the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @c: The constant.
+ *   @data: The one-point data store.
+ */
+
+static inline void dsp_rc_high_block(const double *x, double *y, unsigned int len, struct dsp_rc_1 c, struct dsp_data_1 *data)
+{
+	unsigned int i;
+	struct dsp_data_1 d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_rc_high(x[i], c, &d);
+
+	*data = d;
+}
+
+/**
+ * Process a block with a band-pass RC filter. The input and output may be
+ * the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @c: The constant.
+ *   @data: The two-point data store.
+ */
+
+static inline void dsp_rc_pass_block(const double *x, double *y, unsigned int len, struct dsp_rc_2 c, struct dsp_data_2 *data)
+{
+	unsigned int i;
+	struct dsp_data_2 d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_rc_pass(x[i], c, &d);
+
+	*data = d;
+}
+
 /* %~dsp.h% */
 
 /*
@@ -38,8 +38,12 @@ static inline struct dsp_notch_t dsp_notch_init(unsigned int rate, double freq,
 	c.c = -2.0*exp(w*dt*(k-1.0)/(k+1.0)) * cos(2*w*dt*sqrt(k)/(k+1.0));
 	c.d = exp(2.0*w*dt*(k-1.0)/(k+1.0));
 	c.g = (1.0 + c.c + c.d) / (1.0 + c.a + c.b);
-	printf("%f\n%f\n%f\n%f\n%f\n", c.a, c.b, c.c, c.d, c.g);
-	printf("%f vs %f\n", c.c+c.d, c.a+c.b);
+
+	DSP_PROBE("notch.a", c.a);
+	DSP_PROBE("notch.b", c.b);
+	DSP_PROBE("notch.c", c.c);
+	DSP_PROBE("notch.d", c.d);
+	DSP_PROBE("notch.g", c.g);
 
 	return c;
 }
@@ -56,11 +60,9 @@ static inline double dsp_notch_res(double x, struct dsp_notch_t c, struct dsp_da
 {
 	double y;
 
-	static int i =0;
 	y = c.g*(x + c.a*data->x[0] + c.b*data->x[1]) - c.c*data->y[0] - c.d*data->y[1];
-	if(i++==1000)
-		printf("%f -> %f + %f + %f = %f\n", x, c.g*x, c.g*c.a*data->x[0], c.g*c.b*data->x[1], c.g*x+ c.g*c.a*data->x[0]+ c.g*c.b*data->x[1]),
-		printf("+ %f*%f + %f*%f = %f\n", -c.c,data->y[0], -c.d,data->y[1], y);
+	DSP_PROBE("notch.res.ff", c.g*(x + c.a*data->x[0] + c.b*data->x[1]));
+	DSP_PROBE("notch.res.y", y);
 	dsp_data_2_inc(data, x, y);
 
 	return y;
@@ -78,16 +80,56 @@ static inline double dsp_notch_cut(double x, struct dsp_notch_t c, struct dsp_da
 {
 	double y;
 
-	static int i = 0;
 	y = (x + c.c*data->x[0] + c.d*data->x[1])/c.g - c.a*data->y[0] - c.b*data->y[1];
-	if(i++==1000)
-		printf("%f -> %f + %f + %f = %f\n", x, x/c.g, c.c/c.g*data->x[0], c.d/c.g*data->x[1], x/c.g+ c.c/c.g*data->x[0]+ c.d/c.g*data->x[1]),
-		printf("+ %f*%f + %f*%f = %f\n", -c.a,data->y[0], -c.b,data->y[1], y);
+	DSP_PROBE("notch.cut.ff", (x + c.c*data->x[0] + c.d*data->x[1])/c.g);
+	DSP_PROBE("notch.cut.y", y);
 	dsp_data_2_inc(data, x, y);
 
 	return y;
 }
 
+/**
+ * Process a block with the notch filter with resonance. The input and
+ * output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @c: The constant.
+ *   @data: The historical data.
+ */
+
+static inline void dsp_notch_res_block(const double *x, double *y, unsigned int len, struct dsp_notch_t c, struct dsp_data_2 *data)
+{
+	unsigned int i;
+	struct dsp_data_2 d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_notch_res(x[i], c, &d);
+
+	*data = d;
+}
+
+/**
+ * Process a block with the notch filter by cutting. The input and output
+ * may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @c: The constant.
+ *   @data: The historical data.
+ */
+
+static inline void dsp_notch_cut_block(const double *x, double *y, unsigned int len, struct dsp_notch_t c, struct dsp_data_2 *data)
+{
+	unsigned int i;
+	struct dsp_data_2 d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_notch_cut(x[i], c, &d);
+
+	*data = d;
+}
+
 /* %~dsp.h% */
 
 /*
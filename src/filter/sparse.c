@@ -1,6 +1,14 @@
 #include "../common.h"
 #include "sparse.h"
 #include "../reverb/ring.h"
+#include "../simd.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void ring_axpy(double *out, const struct dsp_ring_t *ring, unsigned int off, double a, unsigned int len);
 
 
 /**
@@ -37,3 +45,77 @@ void dsp_filter_sparse_delete(struct dsp_filter_sparse_t *sparse)
 	dsp_ring_delete(sparse->ring);
 	mem_free(sparse);
 }
+
+
+/**
+ * Process a block through the sparse filter as an IIR filter. When every
+ * offset is at least the run length, no output in the run depends on
+ * another, so each run is computed from the ring with vector multiply-adds
+ * and appended in one pass. Runs are limited to the smallest offset, and
+ * filters with offsets below four fall back to per-sample processing. The
+ * input and output may be the same buffer.
+ *   @sparse: The sparse filter.
+ *   @in: The input.
+ *   @out: The output.
+ *   @len: The length.
+ */
+
+_export
+void dsp_filter_sparse_iir_block(struct dsp_filter_sparse_t *sparse, const double *in, double *out, unsigned int len)
+{
+	unsigned int i, n, d, min;
+	struct dsp_ring_t *ring = sparse->ring;
+
+	min = ring->len;
+	for(i = 0; i < sparse->npts; i++) {
+		d = sparse->pt[i].n % ring->len;
+		if((d > 0) && (d < min))
+			min = d;
+	}
+
+	if(min < 4) {
+		for(i = 0; i < len; i++)
+			out[i] = dsp_filter_sparse_iir(sparse, in[i]);
+
+		return;
+	}
+
+	while(len > 0) {
+		n = (len < min) ? len : min;
+
+		if(out != in)
+			mem_copy(out, in, n * sizeof(double));
+
+		for(i = 0; i < sparse->npts; i++)
+			ring_axpy(out, ring, dsp_mod(ring->idx - sparse->pt[i].n, ring->len), sparse->pt[i].a, n);
+
+		d = ring->len - ring->idx;
+		d = (n < d) ? n : d;
+		mem_copy(ring->arr + ring->idx, out, d * sizeof(double));
+		mem_copy(ring->arr, out + d, (n - d) * sizeof(double));
+		ring->idx = (ring->idx + n) % ring->len;
+
+		in += n;
+		out += n;
+		len -= n;
+	}
+}
+
+
+/**
+ * Add a scaled run from the ring, wrapping at most once.
+ *   @out: The output.
+ *   @ring: The ring buffer.
+ *   @off: The starting offset in the ring.
+ *   @a: The scale.
+ *   @len: The length, at most the ring length.
+ */
+
+static void ring_axpy(double *out, const struct dsp_ring_t *ring, unsigned int off, double a, unsigned int len)
+{
+	unsigned int n = ring->len - off;
+
+	n = (len < n) ? len : n;
+	dsp_vec_axpy(out, ring->arr + off, a, n);
+	dsp_vec_axpy(out + n, ring->arr, a, len - n);
+}
@@ -30,6 +30,8 @@ struct dsp_filter_sparse_t {
 struct dsp_filter_sparse_t *dsp_filter_sparse_empty(unsigned int npts, unsigned int len);
 void dsp_filter_sparse_delete(struct dsp_filter_sparse_t *sparse);
 
+void dsp_filter_sparse_iir_block(struct dsp_filter_sparse_t *sparse, const double *in, double *out, unsigned int len);
+
 
 /**
  * Process the parse filter as an FIR filter.
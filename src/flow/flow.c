@@ -477,6 +477,11 @@ static void flow_commit(void *arg)
 		sink->source[1] = sink->source[0];
 	}
 
+	avltree_destroy(&flow->upsource);
+	avltree_destroy(&flow->upsink);
+	flow->upsource = avltree_empty(compare_ptr, delete_noop);
+	flow->upsink = avltree_empty(compare_ptr, delete_noop);
+
 	dsp_lock_wrunlock(&flow->lock);
 }
 
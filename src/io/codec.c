@@ -0,0 +1,910 @@
+#include "../common.h"
+#include "codec.h"
+#include "../buf.h"
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+
+/*
+ * codec definitions
+ */
+
+#define CODEC_VERSION 1
+#define CODEC_ORDER 4
+#define CODEC_ESCAPE 24
+#define CODEC_RAW 40
+
+
+/**
+ * Bit writer structure.
+ *   @buf, len, cap: The buffer, its length and capacity in bytes.
+ *   @acc, cnt: The bit accumulator and number of pending bits.
+ */
+
+struct codec_put_t {
+	uint8_t *buf;
+	size_t len, cap;
+
+	uint64_t acc;
+	unsigned int cnt;
+};
+
+/**
+ * Bit reader structure.
+ *   @buf, len, idx: The buffer, its length and read index in bytes.
+ *   @acc, cnt: The bit accumulator and number of available bits.
+ *   @err: Set if the read went past the end of the buffer.
+ */
+
+struct codec_get_t {
+	const uint8_t *buf;
+	size_t len, idx;
+
+	uint64_t acc;
+	unsigned int cnt;
+	bool err;
+};
+
+/**
+ * Encoder worker structure.
+ *   @enc: The encoder.
+ *   @id: The worker index.
+ *   @thread: The thread.
+ *   @sync: The wake-up condition.
+ *   @gen: The last processed generation.
+ *   @resid, cap: The residual buffer and its capacity.
+ */
+
+struct enc_work_t {
+	struct dsp_enc_t *enc;
+	unsigned int id;
+
+	struct thread_t *thread;
+	struct thread_cond_t sync;
+	unsigned int gen;
+
+	int64_t *resid;
+	unsigned int cap;
+};
+
+/**
+ * Encoder structure.
+ *   @file: The output file.
+ *   @nchan, rate, bits: The channel count, sample rate, and sample width.
+ *   @size: The number of bytes written.
+ *   @len, cap: The current block length and the block capacity.
+ *   @pcm: The quantized block, 'cap' samples per channel.
+ *   @out: The encoded output, one per channel.
+ *   @resid, tmp: The residual buffer and its capacity, used without workers.
+ *   @nthread: The number of workers.
+ *   @work: The workers.
+ *   @lock: The worker lock.
+ *   @done: The completion condition.
+ *   @gen, pend: The block generation and pending worker count.
+ *   @quit: The shutdown flag.
+ */
+
+struct dsp_enc_t {
+	FILE *file;
+	unsigned int nchan, rate, bits;
+	uint64_t size;
+
+	unsigned int len, cap;
+	int32_t *pcm;
+	struct codec_put_t *out;
+
+	int64_t *resid;
+	unsigned int tmp;
+
+	unsigned int nthread;
+	struct enc_work_t *work;
+
+	struct thread_mutex_t lock;
+	struct thread_cond_t done;
+	unsigned int gen, pend;
+	bool quit;
+};
+
+/**
+ * Decoder structure.
+ *   @file: The input file.
+ *   @nchan, rate, bits: The channel count, sample rate, and sample width.
+ *   @eof: The end-of-stream flag.
+ *   @rem: The number of bytes left in the file.
+ *   @len, idx, cap: The block length, read index, and block capacity.
+ *   @pcm: The decoded block, 'cap' samples per channel.
+ *   @data, size: The channel data buffer and its capacity.
+ */
+
+struct dsp_dec_t {
+	FILE *file;
+	unsigned int nchan, rate, bits;
+	bool eof;
+	uint64_t rem;
+
+	unsigned int len, idx, cap;
+	int32_t *pcm;
+
+	uint8_t *data;
+	size_t size;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void *enc_proc(void *arg);
+static void enc_write(struct dsp_enc_t *enc, const void *data, size_t size);
+
+static bool dec_frame(struct dsp_dec_t *dec);
+
+static void chan_enc(struct codec_put_t *put, const int32_t *x, unsigned int len, unsigned int bits, int64_t *resid);
+static bool chan_dec(struct codec_get_t *get, int32_t *x, unsigned int len, unsigned int bits);
+static int64_t chan_pred(const int32_t *x, unsigned int i, unsigned int order);
+
+static void put_bits(struct codec_put_t *put, uint32_t val, unsigned int n);
+static void put_flush(struct codec_put_t *put);
+static uint32_t get_bits(struct codec_get_t *get, unsigned int n);
+static unsigned int get_unary(struct codec_get_t *get);
+
+static void put_u32(uint8_t *data, uint32_t val);
+static uint32_t get_u32(const uint8_t *data);
+
+
+/**
+ * Create a new lossless encoder. Samples are quantized to the given width
+ * and compressed with fixed linear predictors and Rice coding, so decoding
+ * reproduces the quantized samples exactly.
+ *   @path: The output path.
+ *   @nchan: The number of channels.
+ *   @rate: The sample rate.
+ *   @bits: The sample width, from 8 to 32 bits.
+ *   @nthread: The number of worker threads, zero to encode on the caller.
+ *   &returns: The encoder.
+ */
+
+_export
+struct dsp_enc_t *dsp_enc_new(const char *path, unsigned int nchan, unsigned int rate, unsigned int bits, unsigned int nthread)
+{
+	unsigned int i;
+	struct dsp_enc_t *enc;
+	uint8_t hdr[DSP_CODEC_HDRLEN];
+
+	if((nchan == 0) || (nchan > UINT16_MAX) || (bits < 8) || (bits > 32))
+		throw("Invalid encoder configuration.");
+
+	enc = mem_alloc(sizeof(struct dsp_enc_t));
+	enc->file = fopen(path, "wb");
+	if(enc->file == NULL) {
+		mem_free(enc);
+		throw("Failed to open '%s'. %s.", path, strerror(errno));
+	}
+
+	enc->nchan = nchan;
+	enc->rate = rate;
+	enc->bits = bits;
+	enc->size = 0;
+	enc->len = enc->cap = 0;
+	enc->pcm = NULL;
+	enc->resid = NULL;
+	enc->tmp = 0;
+	enc->out = mem_alloc(nchan * sizeof(struct codec_put_t));
+
+	for(i = 0; i < nchan; i++)
+		enc->out[i] = (struct codec_put_t){ NULL, 0, 0, 0, 0 };
+
+	mem_copy(hdr, DSP_CODEC_MAGIC, 4);
+	hdr[4] = CODEC_VERSION;
+	hdr[5] = bits;
+	hdr[6] = nchan & 0xff;
+	hdr[7] = nchan >> 8;
+	put_u32(hdr + 8, rate);
+	enc_write(enc, hdr, DSP_CODEC_HDRLEN);
+
+	enc->nthread = (nthread > nchan) ? nchan : nthread;
+	enc->work = mem_alloc(enc->nthread * sizeof(struct enc_work_t));
+	enc->lock = thread_mutex_new(NULL);
+	enc->done = thread_cond_new(NULL);
+	enc->gen = enc->pend = 0;
+	enc->quit = false;
+
+	for(i = 0; i < enc->nthread; i++) {
+		enc->work[i].enc = enc;
+		enc->work[i].id = i;
+		enc->work[i].sync = thread_cond_new(NULL);
+		enc->work[i].gen = 0;
+		enc->work[i].resid = NULL;
+		enc->work[i].cap = 0;
+		enc->work[i].thread = thread_new(enc_proc, &enc->work[i], NULL);
+	}
+
+	return enc;
+}
+
+/**
+ * Delete an encoder, stopping the workers and closing the file.
+ *   @enc: The encoder.
+ */
+
+_export
+void dsp_enc_delete(struct dsp_enc_t *enc)
+{
+	unsigned int i;
+
+	thread_mutex_lock(&enc->lock);
+	enc->quit = true;
+
+	for(i = 0; i < enc->nthread; i++)
+		thread_cond_signal(&enc->work[i].sync);
+
+	thread_mutex_unlock(&enc->lock);
+
+	for(i = 0; i < enc->nthread; i++) {
+		thread_join(enc->work[i].thread);
+		thread_cond_delete(&enc->work[i].sync);
+		mem_delete(enc->work[i].resid);
+	}
+
+	for(i = 0; i < enc->nchan; i++)
+		mem_delete(enc->out[i].buf);
+
+	fclose(enc->file);
+	thread_cond_delete(&enc->done);
+	thread_mutex_delete(&enc->lock);
+	mem_free(enc->work);
+	mem_free(enc->out);
+	mem_delete(enc->pcm);
+	mem_delete(enc->resid);
+	mem_free(enc);
+}
+
+
+/**
+ * Encode a block of samples as a single frame.
+ *   @enc: The encoder.
+ *   @buf: The channel buffers.
+ *   @len: The block length, at most 'DSP_CODEC_MAXLEN'.
+ */
+
+_export
+void dsp_enc_proc(struct dsp_enc_t *enc, double **buf, unsigned int len)
+{
+	unsigned int i, n;
+	int64_t val;
+	int32_t *pcm;
+	uint8_t hdr[4];
+	double scale = ldexp(1.0, enc->bits - 1);
+	int64_t max = (int64_t)1 << (enc->bits - 1);
+
+	if(len == 0)
+		return;
+	else if((len > DSP_CODEC_MAXLEN) || (len > SIZE_MAX / sizeof(int32_t) / enc->nchan))
+		throw("Encoder block length %u too long.", len);
+
+	if(len > enc->cap) {
+		enc->cap = len;
+		enc->pcm = mem_realloc(enc->pcm, (size_t)enc->nchan * len * sizeof(int32_t));
+	}
+
+	for(i = 0; i < enc->nchan; i++) {
+		pcm = enc->pcm + (size_t)i * enc->cap;
+
+		for(n = 0; n < len; n++) {
+			val = llrint(m_dblmax(m_dblmin(buf[i][n], 1.0), -1.0) * scale);
+			pcm[n] = (val >= max) ? (max - 1) : val;
+		}
+	}
+
+	enc->len = len;
+
+	if(enc->nthread == 0) {
+		if(len > enc->tmp) {
+			enc->tmp = len;
+			enc->resid = mem_realloc(enc->resid, len * sizeof(int64_t));
+		}
+
+		for(i = 0; i < enc->nchan; i++)
+			chan_enc(&enc->out[i], enc->pcm + (size_t)i * enc->cap, len, enc->bits, enc->resid);
+	}
+	else {
+		thread_mutex_lock(&enc->lock);
+
+		enc->gen++;
+		enc->pend = enc->nthread;
+
+		for(i = 0; i < enc->nthread; i++)
+			thread_cond_signal(&enc->work[i].sync);
+
+		while(enc->pend > 0)
+			thread_cond_wait(&enc->done, &enc->lock);
+
+		thread_mutex_unlock(&enc->lock);
+	}
+
+	put_u32(hdr, len);
+	enc_write(enc, hdr, 4);
+
+	for(i = 0; i < enc->nchan; i++) {
+		put_u32(hdr, enc->out[i].len);
+		enc_write(enc, hdr, 4);
+		enc_write(enc, enc->out[i].buf, enc->out[i].len);
+	}
+}
+
+/**
+ * Recording callback for an encoder.
+ *   @buf: The buffer array.
+ *   @len: The buffer length.
+ *   @arg: The encoder.
+ */
+
+_export
+void dsp_enc_rec(double **buf, unsigned int len, void *arg)
+{
+	dsp_enc_proc(arg, buf, len);
+}
+
+/**
+ * Retrieve the number of bytes written by an encoder.
+ *   @enc: The encoder.
+ *   &returns: The size in bytes.
+ */
+
+_export
+uint64_t dsp_enc_size(struct dsp_enc_t *enc)
+{
+	return enc->size;
+}
+
+
+/**
+ * Encoder worker thread. Each worker encodes every 'nthread'-th channel of
+ * the current block.
+ *   @arg: The worker.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *enc_proc(void *arg)
+{
+	unsigned int i;
+	struct enc_work_t *work = arg;
+	struct dsp_enc_t *enc = work->enc;
+
+	thread_mutex_lock(&enc->lock);
+
+	while(true) {
+		while((work->gen == enc->gen) && !enc->quit)
+			thread_cond_wait(&work->sync, &enc->lock);
+
+		if(enc->quit)
+			break;
+
+		work->gen = enc->gen;
+		thread_mutex_unlock(&enc->lock);
+
+		if(enc->len > work->cap) {
+			work->cap = enc->len;
+			work->resid = mem_realloc(work->resid, work->cap * sizeof(int64_t));
+		}
+
+		for(i = work->id; i < enc->nchan; i += enc->nthread)
+			chan_enc(&enc->out[i], enc->pcm + (size_t)i * enc->cap, enc->len, enc->bits, work->resid);
+
+		thread_mutex_lock(&enc->lock);
+
+		if(--enc->pend == 0)
+			thread_cond_signal(&enc->done);
+	}
+
+	thread_mutex_unlock(&enc->lock);
+
+	return NULL;
+}
+
+/**
+ * Write data to the encoder output.
+ *   @enc: The encoder.
+ *   @data: The data.
+ *   @size: The size in bytes.
+ */
+
+static void enc_write(struct dsp_enc_t *enc, const void *data, size_t size)
+{
+	if(fwrite(data, 1, size, enc->file) != size)
+		throw("Failed to write encoded output. %s.", strerror(errno));
+
+	enc->size += size;
+}
+
+
+/**
+ * Open a lossless file for decoding.
+ *   @path: The path.
+ *   &returns: The decoder.
+ */
+
+_export
+struct dsp_dec_t *dsp_dec_new(const char *path)
+{
+	FILE *file;
+	struct stat info;
+	struct dsp_dec_t *dec;
+	uint8_t hdr[DSP_CODEC_HDRLEN];
+
+	file = fopen(path, "rb");
+	if(file == NULL)
+		throw("Failed to open '%s'. %s.", path, strerror(errno));
+
+	if(fstat(fileno(file), &info) < 0) {
+		fclose(file);
+		throw("Failed to stat '%s'. %s.", path, strerror(errno));
+	}
+
+	if((fread(hdr, 1, DSP_CODEC_HDRLEN, file) != DSP_CODEC_HDRLEN) || !mem_isequal(hdr, DSP_CODEC_MAGIC, 4) || (hdr[4] != CODEC_VERSION) || (hdr[5] < 8) || (hdr[5] > 32) || ((hdr[6] | hdr[7]) == 0)) {
+		fclose(file);
+		throw("Unsupported lossless file '%s'.", path);
+	}
+
+	dec = mem_alloc(sizeof(struct dsp_dec_t));
+	dec->file = file;
+	dec->bits = hdr[5];
+	dec->nchan = hdr[6] | (hdr[7] << 8);
+	dec->rate = get_u32(hdr + 8);
+	dec->eof = false;
+	dec->rem = S_ISREG(info.st_mode) ? (info.st_size - DSP_CODEC_HDRLEN) : UINT64_MAX;
+	dec->len = dec->idx = dec->cap = 0;
+	dec->pcm = NULL;
+	dec->data = NULL;
+	dec->size = 0;
+
+	return dec;
+}
+
+/**
+ * Delete a decoder.
+ *   @dec: The decoder.
+ */
+
+_export
+void dsp_dec_delete(struct dsp_dec_t *dec)
+{
+	fclose(dec->file);
+	mem_delete(dec->pcm);
+	mem_delete(dec->data);
+	mem_free(dec);
+}
+
+
+/**
+ * Retrieve the number of channels.
+ *   @dec: The decoder.
+ *   &returns: The channel count.
+ */
+
+_export
+unsigned int dsp_dec_nchan(struct dsp_dec_t *dec)
+{
+	return dec->nchan;
+}
+
+/**
+ * Retrieve the sample rate.
+ *   @dec: The decoder.
+ *   &returns: The sample rate.
+ */
+
+_export
+unsigned int dsp_dec_rate(struct dsp_dec_t *dec)
+{
+	return dec->rate;
+}
+
+/**
+ * Retrieve the sample width.
+ *   @dec: The decoder.
+ *   &returns: The sample width in bits.
+ */
+
+_export
+unsigned int dsp_dec_bits(struct dsp_dec_t *dec)
+{
+	return dec->bits;
+}
+
+
+/**
+ * Read frames from the decoder. Any part of the buffer past the end of the
+ * stream is zero filled.
+ *   @dec: The decoder.
+ *   @buf: The channel buffers.
+ *   @len: The number of frames to read.
+ *   &returns: The number of frames read.
+ */
+
+_export
+unsigned int dsp_dec_read(struct dsp_dec_t *dec, double **buf, unsigned int len)
+{
+	unsigned int i, n, cnt, tot = 0;
+	double scale = ldexp(1.0, 1 - (int)dec->bits);
+
+	while(tot < len) {
+		if(dec->idx == dec->len) {
+			if(dec->eof || !dec_frame(dec))
+				break;
+		}
+
+		cnt = dec->len - dec->idx;
+		if(cnt > len - tot)
+			cnt = len - tot;
+
+		for(i = 0; i < dec->nchan; i++) {
+			const int32_t *pcm = dec->pcm + (size_t)i * dec->cap + dec->idx;
+
+			for(n = 0; n < cnt; n++)
+				buf[i][tot + n] = pcm[n] * scale;
+		}
+
+		dec->idx += cnt;
+		tot += cnt;
+	}
+
+	for(i = 0; i < dec->nchan; i++)
+		dsp_buf_zero(buf[i] + tot, len - tot);
+
+	return tot;
+}
+
+/**
+ * Playback callback for a decoder. Decoding occurs on the playback helper
+ * thread.
+ *   @buf: The buffer array.
+ *   @len: The buffer length.
+ *   @arg: The decoder.
+ */
+
+_export
+void dsp_dec_play(double **buf, unsigned int len, void *arg)
+{
+	dsp_dec_read(arg, buf, len);
+}
+
+
+/**
+ * Decode the next frame. A truncated or corrupt frame ends the stream,
+ * including one whose lengths exceed the encoder bound or the file.
+ *   @dec: The decoder.
+ *   &returns: True if a frame was decoded.
+ */
+
+static bool dec_frame(struct dsp_dec_t *dec)
+{
+	unsigned int i;
+	uint32_t len, size;
+	uint8_t hdr[4];
+	struct codec_get_t get;
+
+	dec->idx = dec->len = 0;
+	dec->eof = true;
+
+	if((dec->rem < 4) || (fread(hdr, 1, 4, dec->file) != 4))
+		return false;
+
+	dec->rem -= 4;
+
+	len = get_u32(hdr);
+	if((len > DSP_CODEC_MAXLEN) || (len > SIZE_MAX / sizeof(int32_t) / dec->nchan))
+		return false;
+
+	if(len > dec->cap) {
+		dec->cap = len;
+		dec->pcm = mem_realloc(dec->pcm, (size_t)dec->nchan * len * sizeof(int32_t));
+	}
+
+	for(i = 0; i < dec->nchan; i++) {
+		if((dec->rem < 4) || (fread(hdr, 1, 4, dec->file) != 4))
+			return false;
+
+		size = get_u32(hdr);
+		if(size > dec->rem - 4)
+			return false;
+
+		dec->rem -= 4 + size;
+
+		if(size > dec->size) {
+			dec->size = size;
+			dec->data = mem_realloc(dec->data, size);
+		}
+
+		if(fread(dec->data, 1, size, dec->file) != size)
+			return false;
+
+		get = (struct codec_get_t){ dec->data, size, 0, 0, 0, false };
+		if(!chan_dec(&get, dec->pcm + (size_t)i * dec->cap, len, dec->bits))
+			return false;
+	}
+
+	dec->len = len;
+	dec->eof = false;
+
+	return true;
+}
+
+
+/**
+ * Encode a single channel. The fixed predictor order with the smallest
+ * residual is selected, followed by Rice coded residuals with a parameter
+ * per partition.
+ *   @put: The bit writer, reset on entry.
+ *   @x: The samples.
+ *   @len: The number of samples.
+ *   @bits: The sample width.
+ *   @resid: The residual buffer, at least 'len' long.
+ */
+
+static void chan_enc(struct codec_put_t *put, const int32_t *x, unsigned int len, unsigned int bits, int64_t *resid)
+{
+	int64_t r;
+	uint64_t u, sum, best[CODEC_ORDER + 1];
+	unsigned int i, k, q, end, order, max = (len < CODEC_ORDER) ? len : CODEC_ORDER;
+	uint32_t mask = (bits == 32) ? UINT32_MAX : (((uint32_t)1 << bits) - 1);
+	size_t need = 1 + (size_t)len * 8 + len / DSP_CODEC_PART + 16;
+
+	put->len = 0;
+	put->acc = 0;
+	put->cnt = 0;
+
+	if(need > put->cap) {
+		put->cap = need;
+		put->buf = mem_realloc(put->buf, need);
+	}
+
+	for(order = 0; order <= max; order++) {
+		best[order] = 0;
+
+		for(i = max; i < len; i++) {
+			r = x[i] - chan_pred(x, i, order);
+			best[order] += (r < 0) ? -r : r;
+		}
+	}
+
+	for(order = 0, i = 1; i <= max; i++) {
+		if(best[i] < best[order])
+			order = i;
+	}
+
+	put_bits(put, order, 3);
+
+	for(i = 0; i < order; i++)
+		put_bits(put, (uint32_t)x[i] & mask, bits);
+
+	for(i = order; i < len; i = end) {
+		end = (i / DSP_CODEC_PART + 1) * DSP_CODEC_PART;
+		if(end > len)
+			end = len;
+
+		for(sum = 0, q = i; q < end; q++) {
+			r = x[q] - chan_pred(x, q, order);
+			resid[q] = r;
+			sum += ((uint64_t)r << 1) ^ (uint64_t)(r >> 63);
+		}
+
+		for(k = 0; (k < 30) && (((uint64_t)(end - i) << (k + 1)) < sum); k++);
+
+		put_bits(put, k, 5);
+
+		for(q = i; q < end; q++) {
+			u = ((uint64_t)resid[q] << 1) ^ (uint64_t)(resid[q] >> 63);
+
+			if((u >> k) < CODEC_ESCAPE) {
+				put_bits(put, 1, (u >> k) + 1);
+				put_bits(put, u & (((uint64_t)1 << k) - 1), k);
+			}
+			else {
+				put_bits(put, 0, CODEC_ESCAPE);
+				put_bits(put, u >> (CODEC_RAW / 2), CODEC_RAW / 2);
+				put_bits(put, u & ((1 << (CODEC_RAW / 2)) - 1), CODEC_RAW / 2);
+			}
+		}
+	}
+
+	put_flush(put);
+}
+
+/**
+ * Decode a single channel.
+ *   @get: The bit reader.
+ *   @x: The output samples.
+ *   @len: The number of samples.
+ *   @bits: The sample width.
+ *   &returns: True on success, false if the data is corrupt.
+ */
+
+static bool chan_dec(struct codec_get_t *get, int32_t *x, unsigned int len, unsigned int bits)
+{
+	uint64_t u;
+	unsigned int i, k, q, end, order;
+
+	order = get_bits(get, 3);
+	if((order > CODEC_ORDER) || (order > len))
+		return false;
+
+	for(i = 0; i < order; i++)
+		x[i] = (int32_t)(get_bits(get, bits) << (32 - bits)) >> (32 - bits);
+
+	for(i = order; i < len; i = end) {
+		end = (i / DSP_CODEC_PART + 1) * DSP_CODEC_PART;
+		if(end > len)
+			end = len;
+
+		k = get_bits(get, 5);
+
+		for(q = i; q < end; q++) {
+			u = get_unary(get);
+
+			if(u < CODEC_ESCAPE)
+				u = (u << k) | get_bits(get, k);
+			else {
+				u = (uint64_t)get_bits(get, CODEC_RAW / 2) << (CODEC_RAW / 2);
+				u |= get_bits(get, CODEC_RAW / 2);
+			}
+
+			x[q] = (int64_t)((u >> 1) ^ -(u & 1)) + chan_pred(x, q, order);
+		}
+
+		if(get->err)
+			return false;
+	}
+
+	return !get->err;
+}
+
+/**
+ * Compute the fixed polynomial prediction for a sample.
+ *   @x: The samples.
+ *   @i: The sample index, at least 'order'.
+ *   @order: The predictor order.
+ *   &returns: The prediction.
+ */
+
+static inline int64_t chan_pred(const int32_t *x, unsigned int i, unsigned int order)
+{
+	switch(order) {
+	case 1: return x[i-1];
+	case 2: return 2 * (int64_t)x[i-1] - x[i-2];
+	case 3: return 3 * ((int64_t)x[i-1] - x[i-2]) + x[i-3];
+	case 4: return 4 * ((int64_t)x[i-1] + x[i-3]) - 6 * (int64_t)x[i-2] - x[i-4];
+	default: return 0;
+	}
+}
+
+
+/**
+ * Write bits.
+ *   @put: The bit writer.
+ *   @val: The value.
+ *   @n: The number of bits, at most 32.
+ */
+
+static void put_bits(struct codec_put_t *put, uint32_t val, unsigned int n)
+{
+	if(n == 0)
+		return;
+
+	put->acc = (put->acc << n) | val;
+	put->cnt += n;
+
+	while(put->cnt >= 8) {
+		put->cnt -= 8;
+		put->buf[put->len++] = put->acc >> put->cnt;
+	}
+}
+
+/**
+ * Flush any pending bits, padding the final byte with zeros.
+ *   @put: The bit writer.
+ */
+
+static void put_flush(struct codec_put_t *put)
+{
+	if(put->cnt > 0)
+		put_bits(put, 0, 8 - put->cnt);
+}
+
+/**
+ * Read bits. Reading past the end sets the error flag and returns zeros.
+ *   @get: The bit reader.
+ *   @n: The number of bits, at most 32.
+ *   &returns: The value.
+ */
+
+static uint32_t get_bits(struct codec_get_t *get, unsigned int n)
+{
+	if(n == 0)
+		return 0;
+
+	while(get->cnt < n) {
+		get->acc <<= 8;
+		get->cnt += 8;
+
+		if(get->idx < get->len)
+			get->acc |= get->buf[get->idx++];
+		else
+			get->err = true;
+	}
+
+	get->cnt -= n;
+
+	return (get->acc >> get->cnt) & (UINT32_MAX >> (32 - n));
+}
+
+/**
+ * Read a unary coded value, a run of zeros terminated by a one. A run of
+ * 'CODEC_ESCAPE' zeros has no terminator and marks a raw value.
+ *   @get: The bit reader.
+ *   &returns: The value.
+ */
+
+static unsigned int get_unary(struct codec_get_t *get)
+{
+	uint64_t win;
+	unsigned int z, q = 0;
+
+	while(q < CODEC_ESCAPE) {
+		if(get->cnt == 0) {
+			if(get->idx >= get->len) {
+				get->err = true;
+				break;
+			}
+
+			get->acc = (get->acc << 8) | get->buf[get->idx++];
+			get->cnt = 8;
+		}
+
+		win = get->acc & ((1 << get->cnt) - 1);
+		z = (win == 0) ? get->cnt : (get->cnt - (64 - __builtin_clzll(win)));
+
+		if(q + z >= CODEC_ESCAPE) {
+			get->cnt -= CODEC_ESCAPE - q;
+			break;
+		}
+		else if(win == 0) {
+			q += z;
+			get->cnt = 0;
+		}
+		else {
+			get->cnt -= z + 1;
+
+			return q + z;
+		}
+	}
+
+	return CODEC_ESCAPE;
+}
+
+
+/**
+ * Store a 32-bit little-endian value.
+ *   @data: The destination.
+ *   @val: The value.
+ */
+
+static void put_u32(uint8_t *data, uint32_t val)
+{
+	data[0] = val;
+	data[1] = val >> 8;
+	data[2] = val >> 16;
+	data[3] = val >> 24;
+}
+
+/**
+ * Load a 32-bit little-endian value.
+ *   @data: The source.
+ *   &returns: The value.
+ */
+
+static uint32_t get_u32(const uint8_t *data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
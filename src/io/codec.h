@@ -0,0 +1,58 @@
+#ifndef IO_CODEC_H
+#define IO_CODEC_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * codec definitions
+ */
+
+#define DSP_CODEC_MAGIC "DSPL"
+#define DSP_CODEC_HDRLEN 12
+#define DSP_CODEC_PART 256
+#define DSP_CODEC_MAXLEN (1u << 20)
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_enc_t;
+struct dsp_dec_t;
+
+/*
+ * encoder function declarations
+ */
+
+struct dsp_enc_t *dsp_enc_new(const char *path, unsigned int nchan, unsigned int rate, unsigned int bits, unsigned int nthread);
+void dsp_enc_delete(struct dsp_enc_t *enc);
+
+void dsp_enc_proc(struct dsp_enc_t *enc, double **buf, unsigned int len);
+void dsp_enc_rec(double **buf, unsigned int len, void *arg);
+uint64_t dsp_enc_size(struct dsp_enc_t *enc);
+
+/*
+ * decoder function declarations
+ */
+
+struct dsp_dec_t *dsp_dec_new(const char *path);
+void dsp_dec_delete(struct dsp_dec_t *dec);
+
+unsigned int dsp_dec_nchan(struct dsp_dec_t *dec);
+unsigned int dsp_dec_rate(struct dsp_dec_t *dec);
+unsigned int dsp_dec_bits(struct dsp_dec_t *dec);
+
+unsigned int dsp_dec_read(struct dsp_dec_t *dec, double **buf, unsigned int len);
+void dsp_dec_play(double **buf, unsigned int len, void *arg);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -0,0 +1,398 @@
+#include "../common.h"
+#include "loop.h"
+#include "play.h"
+#include "rec.h"
+#include "../buf.h"
+#include <errno.h>
+#include <time.h>
+
+
+/**
+ * Loopback device structure.
+ *   @nchan, rate, period: The channel count, sample rate, and period length.
+ *   @rec, play: The recorder and playback helpers.
+ *   @thread: The device thread.
+ *   @run, feed: The running and output feedback flags.
+ *   @err: The clock error that stopped the device thread, if any.
+ *   @jitter: The maximum wake-up jitter in nanoseconds.
+ *   @seed: The jitter random state.
+ *   @interval, thresh: The probe interval and detection threshold.
+ *   @frame, sent: The current frame and the frame of the pending probe.
+ *   @total: The sum of all measured latencies.
+ *   @lock: The statistics lock.
+ *   @stat: The statistics.
+ *   @in, out: The input and output period buffers.
+ */
+
+struct dsp_loop_t {
+	unsigned int nchan, rate, period;
+	struct dsp_rec_t *rec;
+	struct dsp_play_t *play;
+
+	struct thread_t *thread;
+	bool run;
+	bool feed;
+	int err;
+
+	uint64_t jitter;
+	uint32_t seed;
+
+	unsigned int interval;
+	double thresh;
+	uint64_t frame, sent;
+	uint64_t total;
+
+	struct thread_mutex_t lock;
+	struct dsp_loop_stat_t stat;
+
+	double **in, **out;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void *loop_proc(void *arg);
+static void loop_period(struct dsp_loop_t *loop);
+
+static void time_add(struct timespec *ts, uint64_t nsec);
+static int64_t time_diff(const struct timespec *a, const struct timespec *b);
+
+
+/**
+ * Create a new loopback device. The device calls the recorder and playback
+ * helpers once per period, paced by the monotonic clock.
+ *   @nchan: The number of channels.
+ *   @rate: The sample rate.
+ *   @period: The period length in frames.
+ *   &returns: The loopback device.
+ */
+
+_export
+struct dsp_loop_t *dsp_loop_new(unsigned int nchan, unsigned int rate, unsigned int period)
+{
+	unsigned int i;
+	struct dsp_loop_t *loop;
+
+	if((nchan == 0) || (rate == 0) || (period == 0))
+		throw("Invalid loopback configuration.");
+
+	loop = mem_alloc(sizeof(struct dsp_loop_t) + 2 * nchan * (sizeof(double *) + period * sizeof(double)));
+	loop->nchan = nchan;
+	loop->rate = rate;
+	loop->period = period;
+	loop->rec = NULL;
+	loop->play = NULL;
+	loop->thread = NULL;
+	loop->run = false;
+	loop->feed = false;
+	loop->err = 0;
+	loop->jitter = 0;
+	loop->seed = 0x9e3779b9;
+	loop->interval = rate / 2;
+	loop->thresh = 0.5;
+	loop->lock = thread_mutex_new(NULL);
+	loop->in = (void *)loop + sizeof(struct dsp_loop_t);
+	loop->out = loop->in + nchan;
+
+	for(i = 0; i < 2 * nchan; i++)
+		loop->in[i] = (double *)(loop->in + 2 * nchan) + i * period;
+
+	return loop;
+}
+
+/**
+ * Delete a loopback device, stopping it if running.
+ *   @loop: The loopback device.
+ */
+
+_export
+void dsp_loop_delete(struct dsp_loop_t *loop)
+{
+	dsp_loop_stop(loop);
+	thread_mutex_delete(&loop->lock);
+	mem_free(loop);
+}
+
+
+/**
+ * Configure the recorder and playback helpers. Either may be null. The
+ * device must be stopped.
+ *   @loop: The loopback device.
+ *   @rec: Optional. The recorder fed with the device input.
+ *   @play: Optional. The playback helper drained into the device output.
+ */
+
+_export
+void dsp_loop_conf(struct dsp_loop_t *loop, struct dsp_rec_t *rec, struct dsp_play_t *play)
+{
+	loop->rec = rec;
+	loop->play = play;
+}
+
+/**
+ * Enable or disable feeding the output of each period back into the input
+ * of the next, as with a physical loopback cable.
+ *   @loop: The loopback device.
+ *   @feed: The feedback flag.
+ */
+
+_export
+void dsp_loop_feed(struct dsp_loop_t *loop, bool feed)
+{
+	loop->feed = feed;
+}
+
+/**
+ * Set the maximum wake-up jitter. Each period is delayed by a uniformly
+ * random amount up to the jitter.
+ *   @loop: The loopback device.
+ *   @usec: The jitter in microseconds, zero to disable.
+ */
+
+_export
+void dsp_loop_jitter(struct dsp_loop_t *loop, unsigned int usec)
+{
+	loop->jitter = (uint64_t)usec * 1000;
+}
+
+/**
+ * Configure the latency probe. An impulse is injected on the first input
+ * channel every interval and the latency is measured when the first output
+ * channel crosses the threshold.
+ *   @loop: The loopback device.
+ *   @interval: The probe interval in frames, zero to disable.
+ *   @thresh: The detection threshold.
+ */
+
+_export
+void dsp_loop_probe(struct dsp_loop_t *loop, unsigned int interval, double thresh)
+{
+	loop->interval = interval;
+	loop->thresh = thresh;
+}
+
+
+/**
+ * Start the loopback device, resetting the statistics. The playback helper
+ * should be prepared before starting.
+ *   @loop: The loopback device.
+ */
+
+_export
+void dsp_loop_start(struct dsp_loop_t *loop)
+{
+	unsigned int i;
+
+	if(loop->thread != NULL)
+		return;
+
+	for(i = 0; i < 2 * loop->nchan; i++)
+		dsp_buf_zero(loop->in[i], loop->period);
+
+	loop->frame = 0;
+	loop->sent = UINT64_MAX;
+	loop->total = 0;
+	loop->stat = (struct dsp_loop_stat_t){ 0, 0, 0, 0, 0, UINT_MAX, 0, 0.0 };
+
+	__atomic_store_n(&loop->run, true, __ATOMIC_RELAXED);
+	loop->thread = thread_new(loop_proc, loop, NULL);
+}
+
+/**
+ * Stop the loopback device, waiting for the current period to finish. A
+ * clock failure that stopped the device thread is reported here.
+ *   @loop: The loopback device.
+ */
+
+_export
+void dsp_loop_stop(struct dsp_loop_t *loop)
+{
+	int err;
+
+	if(loop->thread == NULL)
+		return;
+
+	__atomic_store_n(&loop->run, false, __ATOMIC_RELAXED);
+	thread_join(loop->thread);
+	loop->thread = NULL;
+
+	err = loop->err;
+	loop->err = 0;
+
+	if(err != 0)
+		throw("Loopback clock failed. %s.", strerror(err));
+}
+
+
+/**
+ * Retrieve a snapshot of the loopback statistics.
+ *   @loop: The loopback device.
+ *   @stat: The statistics output.
+ */
+
+_export
+void dsp_loop_stat(struct dsp_loop_t *loop, struct dsp_loop_stat_t *stat)
+{
+	thread_mutex_lock(&loop->lock);
+	*stat = loop->stat;
+	thread_mutex_unlock(&loop->lock);
+}
+
+
+/**
+ * Device thread. Periods that start more than a full period late are
+ * counted as missed and skipped, the same way a hardware device overruns.
+ * Sleeps interrupted by signals are resumed; any other clock error stops
+ * the thread.
+ *   @arg: The loopback device.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *loop_proc(void *arg)
+{
+	int err;
+	int64_t late;
+	uint64_t skip, nsec;
+	struct timespec next, wake, now;
+	struct dsp_loop_t *loop = arg;
+
+	nsec = (uint64_t)loop->period * 1000000000 / loop->rate;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while(__atomic_load_n(&loop->run, __ATOMIC_RELAXED)) {
+		time_add(&next, nsec);
+
+		wake = next;
+		if(loop->jitter > 0) {
+			loop->seed ^= loop->seed << 13;
+			loop->seed ^= loop->seed >> 17;
+			loop->seed ^= loop->seed << 5;
+			time_add(&wake, loop->seed % loop->jitter);
+		}
+
+		while((err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL)) == EINTR)
+			;
+
+		if(err != 0) {
+			loop->err = err;
+			break;
+		}
+
+		loop_period(loop);
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		late = time_diff(&now, &next);
+		if(late > (int64_t)nsec) {
+			skip = late / nsec;
+			time_add(&next, skip * nsec);
+			loop->frame += skip * loop->period;
+
+			thread_mutex_lock(&loop->lock);
+			loop->stat.missed += skip;
+			thread_mutex_unlock(&loop->lock);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Process a single period: build the input, run the recorder and playback
+ * helpers, and scan the output for the pending probe.
+ *   @loop: The loopback device.
+ */
+
+static void loop_period(struct dsp_loop_t *loop)
+{
+	unsigned int i, off;
+	uint64_t frame = loop->frame;
+	unsigned int nchan = loop->nchan, period = loop->period;
+
+	for(i = 0; i < nchan; i++) {
+		if(loop->feed)
+			dsp_buf_copy(loop->in[i], loop->out[i], period);
+		else
+			dsp_buf_zero(loop->in[i], period);
+
+		dsp_buf_zero(loop->out[i], period);
+	}
+
+	if((loop->interval > 0) && (loop->sent == UINT64_MAX)) {
+		off = (frame % loop->interval == 0) ? 0 : (loop->interval - frame % loop->interval);
+		if(off < period) {
+			loop->in[0][off] += 1.0;
+			loop->sent = frame + off;
+
+			thread_mutex_lock(&loop->lock);
+			loop->stat.probes++;
+			thread_mutex_unlock(&loop->lock);
+		}
+	}
+
+	if(loop->rec != NULL)
+		dsp_rec_proc(loop->rec, loop->in, period);
+
+	if(loop->play != NULL)
+		dsp_play_proc(loop->play, loop->out, period);
+
+	thread_mutex_lock(&loop->lock);
+
+	loop->stat.periods++;
+
+	if(loop->sent != UINT64_MAX) {
+		for(i = 0; i < period; i++) {
+			if(fabs(loop->out[0][i]) >= loop->thresh)
+				break;
+		}
+
+		if((i < period) && (frame + i >= loop->sent)) {
+			loop->stat.lat = frame + i - loop->sent;
+			loop->total += loop->stat.lat;
+
+			if(loop->stat.lat < loop->stat.latmin)
+				loop->stat.latmin = loop->stat.lat;
+
+			if(loop->stat.lat > loop->stat.latmax)
+				loop->stat.latmax = loop->stat.lat;
+
+			loop->stat.latavg = (double)loop->total / (loop->stat.probes - loop->stat.lost);
+			loop->sent = UINT64_MAX;
+		}
+		else if(frame + period - loop->sent > loop->rate) {
+			loop->stat.lost++;
+			loop->sent = UINT64_MAX;
+		}
+	}
+
+	thread_mutex_unlock(&loop->lock);
+
+	loop->frame = frame + period;
+}
+
+
+/**
+ * Add nanoseconds to a time.
+ *   @ts: The time.
+ *   @nsec: The nanoseconds.
+ */
+
+static void time_add(struct timespec *ts, uint64_t nsec)
+{
+	nsec += ts->tv_nsec;
+	ts->tv_sec += nsec / 1000000000;
+	ts->tv_nsec = nsec % 1000000000;
+}
+
+/**
+ * Compute the difference between two times.
+ *   @a: The first time.
+ *   @b: The second time.
+ *   &returns: The difference 'a - b' in nanoseconds.
+ */
+
+static int64_t time_diff(const struct timespec *a, const struct timespec *b)
+{
+	return (int64_t)(a->tv_sec - b->tv_sec) * 1000000000 + (a->tv_nsec - b->tv_nsec);
+}
@@ -0,0 +1,57 @@
+#ifndef IO_LOOP_H
+#define IO_LOOP_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/**
+ * Loopback statistics structure.
+ *   @periods, missed: The number of processed and missed periods.
+ *   @probes, lost: The number of probes sent and lost.
+ *   @lat, latmin, latmax: The last, minimum, and maximum round-trip latency in frames.
+ *   @latavg: The average round-trip latency in frames.
+ */
+
+struct dsp_loop_stat_t {
+	uint64_t periods, missed;
+	unsigned int probes, lost;
+	unsigned int lat, latmin, latmax;
+	double latavg;
+};
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_loop_t;
+struct dsp_play_t;
+struct dsp_rec_t;
+
+/*
+ * loopback function declarations
+ */
+
+struct dsp_loop_t *dsp_loop_new(unsigned int nchan, unsigned int rate, unsigned int period);
+void dsp_loop_delete(struct dsp_loop_t *loop);
+
+void dsp_loop_conf(struct dsp_loop_t *loop, struct dsp_rec_t *rec, struct dsp_play_t *play);
+void dsp_loop_feed(struct dsp_loop_t *loop, bool feed);
+void dsp_loop_jitter(struct dsp_loop_t *loop, unsigned int usec);
+void dsp_loop_probe(struct dsp_loop_t *loop, unsigned int interval, double thresh);
+
+void dsp_loop_start(struct dsp_loop_t *loop);
+void dsp_loop_stop(struct dsp_loop_t *loop);
+
+void dsp_loop_stat(struct dsp_loop_t *loop, struct dsp_loop_stat_t *stat);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
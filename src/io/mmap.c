@@ -0,0 +1,309 @@
+#include "../common.h"
+#include "mmap.h"
+#include "wav.h"
+#include "../buf.h"
+#include "../conv.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/**
+ * Memory-mapped file structure.
+ *   @fd: The file descriptor.
+ *   @map, size: The mapping and its size.
+ *   @fmt: The sample format.
+ *   @nchan, rate: The channel count and sample rate.
+ *   @off, len: The data offset in bytes and length in frames.
+ *   @idx, hint, ahead: The read index, advised limit, and read-ahead in frames.
+ */
+
+struct dsp_mmap_t {
+	int fd;
+	uint8_t *map;
+	size_t size;
+
+	enum dsp_fmt_e fmt;
+	unsigned int nchan, rate;
+	size_t off, len;
+
+	size_t idx, hint, ahead;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static struct dsp_mmap_t *file_open(const char *path);
+static void file_advise(struct dsp_mmap_t *file, size_t idx, size_t len);
+
+/*
+ * global variables
+ */
+
+static size_t page_size = 0;
+
+
+/**
+ * Map a WAV file for playback. Only the header is touched, so the cost of
+ * opening is independent of the file size.
+ *   @path: The path.
+ *   &returns: The mapped file.
+ */
+
+_export
+struct dsp_mmap_t *dsp_mmap_new(const char *path)
+{
+	struct dsp_wav_t wav;
+	struct dsp_mmap_t *file;
+
+	file = file_open(path);
+	if(!dsp_wav_parse(&wav, file->map, file->size)) {
+		dsp_mmap_delete(file);
+		throw("Unsupported WAV file '%s'.", path);
+	}
+
+	file->fmt = wav.fmt;
+	file->nchan = wav.nchan;
+	file->rate = wav.rate;
+	file->off = wav.off;
+	file->len = wav.len;
+	file_advise(file, 0, file->ahead);
+	file->hint = file->ahead;
+
+	return file;
+}
+
+/**
+ * Map a raw, headerless file for playback.
+ *   @path: The path.
+ *   @fmt: The sample format.
+ *   @nchan: The number of interleaved channels.
+ *   @rate: The sample rate.
+ *   &returns: The mapped file.
+ */
+
+_export
+struct dsp_mmap_t *dsp_mmap_raw(const char *path, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int rate)
+{
+	struct dsp_mmap_t *file;
+
+	if(nchan == 0)
+		throw("Invalid channel count.");
+
+	file = file_open(path);
+	file->fmt = fmt;
+	file->nchan = nchan;
+	file->rate = rate;
+	file->off = 0;
+	file->len = file->size / (nchan * dsp_fmt_size(fmt));
+	file_advise(file, 0, file->ahead);
+	file->hint = file->ahead;
+
+	return file;
+}
+
+/**
+ * Delete a mapped file.
+ *   @file: The mapped file.
+ */
+
+_export
+void dsp_mmap_delete(struct dsp_mmap_t *file)
+{
+	if(file->map != NULL)
+		munmap(file->map, file->size);
+
+	close(file->fd);
+	mem_free(file);
+}
+
+
+/**
+ * Retrieve the number of channels.
+ *   @file: The mapped file.
+ *   &returns: The channel count.
+ */
+
+_export
+unsigned int dsp_mmap_nchan(struct dsp_mmap_t *file)
+{
+	return file->nchan;
+}
+
+/**
+ * Retrieve the sample rate.
+ *   @file: The mapped file.
+ *   &returns: The sample rate.
+ */
+
+_export
+unsigned int dsp_mmap_rate(struct dsp_mmap_t *file)
+{
+	return file->rate;
+}
+
+/**
+ * Retrieve the length.
+ *   @file: The mapped file.
+ *   &returns: The length in frames.
+ */
+
+_export
+size_t dsp_mmap_len(struct dsp_mmap_t *file)
+{
+	return file->len;
+}
+
+
+/**
+ * Set the read-ahead distance.
+ *   @file: The mapped file.
+ *   @ahead: The read-ahead in frames.
+ */
+
+_export
+void dsp_mmap_ahead(struct dsp_mmap_t *file, size_t ahead)
+{
+	file->ahead = ahead;
+}
+
+/**
+ * Seek to a position in the file, advising the kernel to start reading the
+ * new region immediately.
+ *   @file: The mapped file.
+ *   @idx: The frame index.
+ */
+
+_export
+void dsp_mmap_seek(struct dsp_mmap_t *file, size_t idx)
+{
+	if(idx > file->len)
+		idx = file->len;
+
+	file->idx = idx;
+	file->hint = idx + file->ahead;
+	file_advise(file, idx, file->ahead);
+}
+
+/**
+ * Read and convert frames from the file. Any frames past the end of the file
+ * are zero filled. Advice restarts from the read index when reads longer
+ * than the read-ahead overtake the advised limit.
+ *   @file: The mapped file.
+ *   @buf: The output buffers, one per channel.
+ *   @len: The number of frames.
+ *   &returns: The number of frames read from the file.
+ */
+
+_export
+unsigned int dsp_mmap_read(struct dsp_mmap_t *file, double **buf, unsigned int len)
+{
+	unsigned int i, n;
+	size_t idx;
+
+	n = (file->len - file->idx < len) ? (file->len - file->idx) : len;
+	dsp_fmt2arr(buf, file->map + file->off + file->idx * file->nchan * dsp_fmt_size(file->fmt), file->fmt, file->nchan, n);
+
+	for(i = 0; i < file->nchan; i++)
+		dsp_buf_zero(buf[i] + n, len - n);
+
+	file->idx += n;
+	if(file->idx + file->ahead / 2 > file->hint) {
+		idx = (file->hint > file->idx) ? file->hint : file->idx;
+		file_advise(file, idx, file->ahead);
+		file->hint = idx + file->ahead;
+	}
+
+	return n;
+}
+
+
+/**
+ * Playback callback for a mapped file. The conversion and any page faults
+ * occur on the playback helper thread, leaving the audio thread to copy
+ * already converted data.
+ *   @buf: The buffer array.
+ *   @len: The buffer length.
+ *   @arg: The mapped file.
+ */
+
+_export
+void dsp_mmap_play(double **buf, unsigned int len, void *arg)
+{
+	dsp_mmap_read(arg, buf, len);
+}
+
+
+/**
+ * Open and map a file.
+ *   @path: The path.
+ *   &returns: The mapped file.
+ */
+
+static struct dsp_mmap_t *file_open(const char *path)
+{
+	int fd;
+	struct stat info;
+	struct dsp_mmap_t *file;
+
+	if(page_size == 0)
+		page_size = sysconf(_SC_PAGESIZE);
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0)
+		throw("Failed to open '%s'. %s.", path, strerror(errno));
+
+	if(fstat(fd, &info) < 0) {
+		close(fd);
+		throw("Failed to stat '%s'. %s.", path, strerror(errno));
+	}
+
+	file = mem_alloc(sizeof(struct dsp_mmap_t));
+	file->fd = fd;
+	file->size = info.st_size;
+	file->map = NULL;
+	file->idx = 0;
+	file->hint = 0;
+	file->ahead = 65536;
+
+	if(file->size > 0) {
+		file->map = mmap(NULL, file->size, PROT_READ, MAP_SHARED, fd, 0);
+		if(file->map == MAP_FAILED) {
+			file->map = NULL;
+			dsp_mmap_delete(file);
+			throw("Failed to map '%s'. %s.", path, strerror(errno));
+		}
+
+		madvise(file->map, file->size, MADV_SEQUENTIAL);
+	}
+
+	return file;
+}
+
+/**
+ * Advise the kernel to read ahead a region of frames.
+ *   @file: The mapped file.
+ *   @idx: The starting frame.
+ *   @len: The number of frames.
+ */
+
+static void file_advise(struct dsp_mmap_t *file, size_t idx, size_t len)
+{
+	size_t begin, end, frame;
+
+	if(idx >= file->len)
+		return;
+
+	if(len > file->len - idx)
+		len = file->len - idx;
+
+	frame = file->nchan * dsp_fmt_size(file->fmt);
+	begin = (file->off + idx * frame) & ~(page_size - 1);
+	end = file->off + (idx + len) * frame;
+
+	madvise(file->map + begin, end - begin, MADV_WILLNEED);
+}
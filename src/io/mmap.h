@@ -0,0 +1,40 @@
+#ifndef IO_MMAP_H
+#define IO_MMAP_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_mmap_t;
+
+/*
+ * memory-mapped file function declarations
+ */
+
+struct dsp_mmap_t *dsp_mmap_new(const char *path);
+struct dsp_mmap_t *dsp_mmap_raw(const char *path, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int rate);
+void dsp_mmap_delete(struct dsp_mmap_t *file);
+
+unsigned int dsp_mmap_nchan(struct dsp_mmap_t *file);
+unsigned int dsp_mmap_rate(struct dsp_mmap_t *file);
+size_t dsp_mmap_len(struct dsp_mmap_t *file);
+
+void dsp_mmap_ahead(struct dsp_mmap_t *file, size_t ahead);
+void dsp_mmap_seek(struct dsp_mmap_t *file, size_t idx);
+unsigned int dsp_mmap_read(struct dsp_mmap_t *file, double **buf, unsigned int len);
+
+void dsp_mmap_play(double **buf, unsigned int len, void *arg);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
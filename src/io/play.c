@@ -39,7 +39,8 @@ static void *thread_proc(void *arg);
 
 
 /**
- * Create a new playback helper.
+ * Create a new playback helper. The helper thread is waiting on the
+ * playback lock before this returns, so the first signal is never lost.
  *   @outcnt: The number of output channels.
  *   @buflen: The length of the internal buffer.
  */
@@ -57,7 +58,11 @@ struct dsp_play_t *dsp_play_new(unsigned int outcnt, unsigned int buflen)
 	play->arg = NULL;
 	play->sync = thread_cond_new(NULL);
 	play->lock = thread_mutex_new(NULL);
+
+	thread_mutex_lock(&play->lock);
 	play->thread = thread_new(thread_proc, play, NULL);
+	thread_cond_wait(&play->sync, &play->lock);
+	thread_mutex_unlock(&play->lock);
 
 	return play;
 }
@@ -70,9 +75,8 @@ struct dsp_play_t *dsp_play_new(unsigned int outcnt, unsigned int buflen)
 _export
 void dsp_play_delete(struct dsp_play_t *play)
 {
-	play->buflen = 0;
-
 	thread_mutex_lock(&play->lock);
+	play->buflen = 0;
 	thread_cond_signal(&play->sync);
 	thread_mutex_unlock(&play->lock);
 
@@ -174,6 +178,7 @@ static void *thread_proc(void *arg)
 	}
 
 	thread_mutex_lock(&play->lock);
+	thread_cond_signal(&play->sync);
 
 	while(play->buflen > 0) {
 		thread_cond_wait(&play->sync, &play->lock);
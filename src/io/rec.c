@@ -39,7 +39,8 @@ static void *thread_proc(void *arg);
 
 
 /**
- * Create a new recorder.
+ * Create a new recorder. The helper thread is waiting on the recorder
+ * lock before this returns, so the first signal is never lost.
  *   @cnt: The number of channels to record.
  *   @len: The buffer length.
  *   &returns: The recorder.
@@ -58,7 +59,11 @@ struct dsp_rec_t *dsp_rec_new(unsigned int cnt, unsigned int len)
 	rec->arg = NULL;
 	rec->sync = thread_cond_new(NULL);
 	rec->lock = thread_mutex_new(NULL);
+
+	thread_mutex_lock(&rec->lock);
 	rec->thread = thread_new(thread_proc, rec, NULL);
+	thread_cond_wait(&rec->sync, &rec->lock);
+	thread_mutex_unlock(&rec->lock);
 
 	return rec;
 }
@@ -71,9 +76,8 @@ struct dsp_rec_t *dsp_rec_new(unsigned int cnt, unsigned int len)
 _export
 void dsp_rec_delete(struct dsp_rec_t *rec)
 {
-	rec->buflen = 0;
-
 	thread_mutex_lock(&rec->lock);
+	rec->buflen = 0;
 	thread_cond_signal(&rec->sync);
 	thread_mutex_unlock(&rec->lock);
 
@@ -178,6 +182,7 @@ static void *thread_proc(void *arg)
 	}
 
 	thread_mutex_lock(&rec->lock);
+	thread_cond_signal(&rec->sync);
 
 	while(rec->buflen > 0) {
 		thread_cond_wait(&rec->sync, &rec->lock);
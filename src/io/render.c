@@ -0,0 +1,481 @@
+#include "../common.h"
+#include "render.h"
+#include "mmap.h"
+#include "wav.h"
+#include "../buf.h"
+#include "../conv.h"
+#include "../flow/flow.h"
+#include "../flow/node.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/**
+ * Render source structure.
+ *   @next: The next source.
+ *   @render: The parent renderer.
+ *   @file: The mapped file.
+ *   @node: The flow node.
+ *   @nchan: The number of channels.
+ *   @buf: The double-buffered input, 'nchan' arrays per block.
+ */
+
+struct render_src_t {
+	struct render_src_t *next;
+	struct dsp_render_t *render;
+
+	struct dsp_mmap_t *file;
+	struct dsp_node_t *node;
+
+	unsigned int nchan;
+	double **buf[2];
+};
+
+/**
+ * Render sink structure.
+ *   @next: The next sink.
+ *   @render: The parent renderer.
+ *   @fd: The file descriptor.
+ *   @fmt: The output format.
+ *   @nchan, rate: The channel count and rate.
+ *   @node: The flow node.
+ *   @dither: The dither state.
+ *   @buf: The double-buffered output, 'nchan' arrays per block.
+ *   @pack: The packed output buffer.
+ */
+
+struct render_sink_t {
+	struct render_sink_t *next;
+	struct dsp_render_t *render;
+
+	int fd;
+	enum dsp_fmt_e fmt;
+	unsigned int nchan, rate;
+
+	struct dsp_node_t *node;
+	struct dsp_dither_t *dither;
+
+	double **buf[2];
+	uint8_t *pack;
+};
+
+/**
+ * Offline renderer structure.
+ *   @flow: The flow.
+ *   @blklen: The block length.
+ *   @src: The source list.
+ *   @sink: The sink list.
+ *   @lock: The pipeline lock.
+ *   @rdsync, cursync, wrsync: The read, compute, and write conditions.
+ *   @len, nblk: The total length and number of blocks.
+ *   @rd, cur, wr: The number of blocks read, computed, and written.
+ *   @err: The I/O error, if any.
+ */
+
+struct dsp_render_t {
+	struct dsp_flow_t *flow;
+	unsigned int blklen;
+
+	struct render_src_t *src;
+	struct render_sink_t *sink;
+
+	struct thread_mutex_t lock;
+	struct thread_cond_t rdsync, cursync, wrsync;
+
+	size_t len, nblk;
+	size_t rd, cur, wr;
+	int err;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void *read_proc(void *arg);
+static void *write_proc(void *arg);
+
+static void src_proc(double **buf, unsigned int len, void *arg);
+static void sink_proc(double **buf, unsigned int len, void *arg);
+static bool sink_write(struct render_sink_t *sink, const void *data, size_t size);
+
+static double **buf_new(unsigned int nchan, unsigned int len);
+
+
+/**
+ * Create a new offline renderer. The flow must be configured with buffers
+ * of at least the block length.
+ *   @flow: The flow.
+ *   @blklen: The block length.
+ *   &returns: The renderer.
+ */
+
+_export
+struct dsp_render_t *dsp_render_new(struct dsp_flow_t *flow, unsigned int blklen)
+{
+	struct dsp_render_t *render;
+
+	if(blklen == 0)
+		throw("Invalid block length.");
+
+	render = mem_alloc(sizeof(struct dsp_render_t));
+	render->flow = flow;
+	render->blklen = blklen;
+	render->src = NULL;
+	render->sink = NULL;
+	render->lock = thread_mutex_new(NULL);
+	render->rdsync = thread_cond_new(NULL);
+	render->cursync = thread_cond_new(NULL);
+	render->wrsync = thread_cond_new(NULL);
+
+	return render;
+}
+
+/**
+ * Delete an offline renderer, detaching and removing all of its nodes from
+ * the flow.
+ *   @render: The renderer.
+ */
+
+_export
+void dsp_render_delete(struct dsp_render_t *render)
+{
+	struct render_src_t *src;
+	struct render_sink_t *sink;
+
+	while((src = render->src) != NULL) {
+		render->src = src->next;
+
+		dsp_node_reset(src->node);
+		dsp_flow_desync(render->flow, src->node, NULL);
+		dsp_node_delete(src->node);
+		dsp_mmap_delete(src->file);
+		mem_free(src->buf[0]);
+		mem_free(src->buf[1]);
+		mem_free(src);
+	}
+
+	while((sink = render->sink) != NULL) {
+		render->sink = sink->next;
+
+		dsp_node_reset(sink->node);
+		dsp_flow_desync(render->flow, sink->node, NULL);
+		dsp_node_delete(sink->node);
+		dsp_dither_delete(sink->dither);
+		close(sink->fd);
+		mem_free(sink->buf[0]);
+		mem_free(sink->buf[1]);
+		mem_free(sink->pack);
+		mem_free(sink);
+	}
+
+	thread_cond_delete(&render->rdsync);
+	thread_cond_delete(&render->cursync);
+	thread_cond_delete(&render->wrsync);
+	thread_mutex_delete(&render->lock);
+	mem_free(render);
+}
+
+
+/**
+ * Add a file-backed source to the renderer. The returned node has no inputs
+ * and one output per file channel, and is already synchronized to the flow.
+ *   @render: The renderer.
+ *   @path: The WAV file path.
+ *   &returns: The source node.
+ */
+
+_export
+struct dsp_node_t *dsp_render_source(struct dsp_render_t *render, const char *path)
+{
+	struct render_src_t *src;
+
+	src = mem_alloc(sizeof(struct render_src_t));
+	src->render = render;
+	src->file = dsp_mmap_new(path);
+	src->nchan = dsp_mmap_nchan(src->file);
+	src->buf[0] = buf_new(src->nchan, render->blklen);
+	src->buf[1] = buf_new(src->nchan, render->blklen);
+	src->node = dsp_node_new(0, src->nchan, src_proc, src);
+	dsp_flow_sync(render->flow, src->node, NULL);
+
+	src->next = render->src;
+	render->src = src;
+
+	return src->node;
+}
+
+/**
+ * Add a file-backed sink to the renderer. The returned node has one input
+ * per channel and no outputs, and is already synchronized to the flow. The
+ * 16-bit format is written with TPDF dither.
+ *   @render: The renderer.
+ *   @path: The output WAV file path.
+ *   @fmt: The sample format.
+ *   @nchan: The number of channels.
+ *   @rate: The sample rate.
+ *   &returns: The sink node.
+ */
+
+_export
+struct dsp_node_t *dsp_render_sink(struct dsp_render_t *render, const char *path, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int rate)
+{
+	int fd;
+	struct render_sink_t *sink;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0)
+		throw("Failed to open '%s'. %s.", path, strerror(errno));
+
+	sink = mem_alloc(sizeof(struct render_sink_t));
+	sink->render = render;
+	sink->fd = fd;
+	sink->fmt = fmt;
+	sink->nchan = nchan;
+	sink->rate = rate;
+	sink->dither = dsp_dither_new(nchan, 0);
+	sink->buf[0] = buf_new(nchan, render->blklen);
+	sink->buf[1] = buf_new(nchan, render->blklen);
+	sink->pack = mem_alloc(render->blklen * nchan * dsp_fmt_size(fmt));
+	sink->node = dsp_node_new(nchan, 0, sink_proc, sink);
+	dsp_flow_sync(render->flow, sink->node, NULL);
+
+	sink->next = render->sink;
+	render->sink = sink;
+
+	return sink->node;
+}
+
+
+/**
+ * Render the flow until all sources are exhausted. File reads and writes
+ * run on separate threads, one block ahead and behind the flow, so that
+ * processing never waits on I/O unless the disks cannot keep up.
+ *   @render: The renderer.
+ *   @tail: The number of extra frames to render after the sources end.
+ *   &returns: The number of frames rendered.
+ */
+
+_export
+size_t dsp_render_exec(struct dsp_render_t *render, size_t tail)
+{
+	size_t k;
+	struct thread_t *rd, *wr;
+	struct render_src_t *src;
+	struct render_sink_t *sink;
+	uint8_t hdr[DSP_WAV_HDRLEN];
+
+	if(dsp_flow_buflen_get(render->flow) < render->blklen)
+		throw("Flow buffers shorter than the block length.");
+
+	render->len = 0;
+	for(src = render->src; src != NULL; src = src->next) {
+		dsp_mmap_seek(src->file, 0);
+		if(dsp_mmap_len(src->file) > render->len)
+			render->len = dsp_mmap_len(src->file);
+	}
+
+	render->len += tail;
+	render->nblk = (render->len + render->blklen - 1) / render->blklen;
+	render->rd = render->cur = render->wr = 0;
+	render->err = 0;
+
+	for(sink = render->sink; sink != NULL; sink = sink->next) {
+		dsp_wav_header(hdr, sink->fmt, sink->nchan, sink->rate, 0);
+		lseek(sink->fd, 0, SEEK_SET);
+		if(ftruncate(sink->fd, 0) < 0 || !sink_write(sink, hdr, DSP_WAV_HDRLEN))
+			throw("Failed to write output. %s.", strerror(errno));
+	}
+
+	rd = thread_new(read_proc, render, NULL);
+	wr = thread_new(write_proc, render, NULL);
+
+	for(k = 0; k < render->nblk; k++) {
+		thread_mutex_lock(&render->lock);
+
+		while((render->rd <= k) || (render->wr + 2 <= k))
+			thread_cond_wait(&render->cursync, &render->lock);
+
+		thread_mutex_unlock(&render->lock);
+
+		dsp_flow_proc(render->flow, render->blklen);
+
+		thread_mutex_lock(&render->lock);
+		render->cur = k + 1;
+		thread_cond_signal(&render->rdsync);
+		thread_cond_signal(&render->wrsync);
+		thread_mutex_unlock(&render->lock);
+	}
+
+	thread_join(rd);
+	thread_join(wr);
+
+	for(sink = render->sink; sink != NULL; sink = sink->next) {
+		dsp_wav_header(hdr, sink->fmt, sink->nchan, sink->rate, render->len);
+		if(pwrite(sink->fd, hdr, DSP_WAV_HDRLEN, 0) != DSP_WAV_HDRLEN)
+			render->err = errno;
+	}
+
+	if(render->err != 0)
+		throw("Failed to write output. %s.", strerror(render->err));
+
+	return render->len;
+}
+
+
+/**
+ * Reader thread, filling input blocks ahead of the flow.
+ *   @arg: The renderer.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *read_proc(void *arg)
+{
+	size_t k;
+	struct render_src_t *src;
+	struct dsp_render_t *render = arg;
+
+	for(k = 0; k < render->nblk; k++) {
+		thread_mutex_lock(&render->lock);
+
+		while(render->cur + 2 <= k)
+			thread_cond_wait(&render->rdsync, &render->lock);
+
+		thread_mutex_unlock(&render->lock);
+
+		for(src = render->src; src != NULL; src = src->next)
+			dsp_mmap_read(src->file, src->buf[k % 2], render->blklen);
+
+		thread_mutex_lock(&render->lock);
+		render->rd = k + 1;
+		thread_cond_signal(&render->cursync);
+		thread_mutex_unlock(&render->lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * Writer thread, converting and writing output blocks behind the flow.
+ *   @arg: The renderer.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *write_proc(void *arg)
+{
+	size_t k, len;
+	struct render_sink_t *sink;
+	struct dsp_render_t *render = arg;
+
+	for(k = 0; k < render->nblk; k++) {
+		thread_mutex_lock(&render->lock);
+
+		while(render->cur <= k)
+			thread_cond_wait(&render->wrsync, &render->lock);
+
+		thread_mutex_unlock(&render->lock);
+
+		len = render->len - k * render->blklen;
+		if(len > render->blklen)
+			len = render->blklen;
+
+		for(sink = render->sink; sink != NULL; sink = sink->next) {
+			dsp_arr2fmt(sink->pack, sink->buf[k % 2], sink->fmt, sink->nchan, len, (sink->fmt == dsp_fmt_s16) ? sink->dither : NULL);
+			if(!sink_write(sink, sink->pack, len * sink->nchan * dsp_fmt_size(sink->fmt)))
+				render->err = errno;
+		}
+
+		thread_mutex_lock(&render->lock);
+		render->wr = k + 1;
+		thread_cond_signal(&render->cursync);
+		thread_mutex_unlock(&render->lock);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Source node callback, copying the current input block.
+ *   @buf: The output buffers.
+ *   @len: The length.
+ *   @arg: The source.
+ */
+
+static void src_proc(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i;
+	struct render_src_t *src = arg;
+	double **in = src->buf[src->render->cur % 2];
+
+	for(i = 0; i < src->nchan; i++)
+		dsp_buf_copy(buf[i], in[i], len);
+}
+
+/**
+ * Sink node callback, capturing the current output block.
+ *   @buf: The input buffers.
+ *   @len: The length.
+ *   @arg: The sink.
+ */
+
+static void sink_proc(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i;
+	struct render_sink_t *sink = arg;
+	double **out = sink->buf[sink->render->cur % 2];
+
+	for(i = 0; i < sink->nchan; i++)
+		dsp_buf_copy(out[i], buf[i], len);
+}
+
+/**
+ * Write data to a sink file.
+ *   @sink: The sink.
+ *   @data: The data.
+ *   @size: The size in bytes.
+ *   &returns: True on success, false on error.
+ */
+
+static bool sink_write(struct render_sink_t *sink, const void *data, size_t size)
+{
+	ssize_t ret;
+
+	while(size > 0) {
+		ret = write(sink->fd, data, size);
+		if(ret < 0) {
+			if(errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		data += ret;
+		size -= ret;
+	}
+
+	return true;
+}
+
+
+/**
+ * Allocate a set of channel buffers in a single allocation.
+ *   @nchan: The number of channels.
+ *   @len: The length of each buffer.
+ *   &returns: The buffer array.
+ */
+
+static double **buf_new(unsigned int nchan, unsigned int len)
+{
+	unsigned int i;
+	double **buf;
+
+	buf = mem_alloc(nchan * (sizeof(double *) + len * sizeof(double)));
+	for(i = 0; i < nchan; i++) {
+		buf[i] = (double *)(buf + nchan) + i * len;
+		dsp_buf_zero(buf[i], len);
+	}
+
+	return buf;
+}
@@ -0,0 +1,36 @@
+#ifndef IO_RENDER_H
+#define IO_RENDER_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_flow_t;
+struct dsp_node_t;
+struct dsp_render_t;
+
+/*
+ * render function declarations
+ */
+
+struct dsp_render_t *dsp_render_new(struct dsp_flow_t *flow, unsigned int blklen);
+void dsp_render_delete(struct dsp_render_t *render);
+
+struct dsp_node_t *dsp_render_source(struct dsp_render_t *render, const char *path);
+struct dsp_node_t *dsp_render_sink(struct dsp_render_t *render, const char *path, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int rate);
+
+size_t dsp_render_exec(struct dsp_render_t *render, size_t tail);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -0,0 +1,167 @@
+#include "../common.h"
+#include "wav.h"
+
+
+/*
+ * local function declarations
+ */
+
+static uint16_t get16(const uint8_t *ptr);
+static uint32_t get32(const uint8_t *ptr);
+static void put16(uint8_t *ptr, uint16_t val);
+static void put32(uint8_t *ptr, uint32_t val);
+
+
+/**
+ * Parse a WAV header from memory. Only the header is inspected, so the data
+ * chunk does not need to be resident.
+ *   @wav: The output header information.
+ *   @data: The file data.
+ *   @size: The file size.
+ *   &returns: True if parsed, false if not a supported WAV file.
+ */
+
+_export
+bool dsp_wav_parse(struct dsp_wav_t *wav, const uint8_t *data, size_t size)
+{
+	size_t i, len;
+	uint16_t tag, bits, align = 0;
+	bool fmt = false;
+
+	if((size < 12) || !mem_isequal(data, "RIFF", 4) || !mem_isequal(data + 8, "WAVE", 4))
+		return false;
+
+	for(i = 12; i + 8 <= size; i += 8 + len + (len & 1)) {
+		len = get32(data + i + 4);
+
+		if(mem_isequal(data + i, "fmt ", 4)) {
+			if((len < 16) || (i + 8 + len > size))
+				return false;
+
+			tag = get16(data + i + 8);
+			wav->nchan = get16(data + i + 10);
+			wav->rate = get32(data + i + 12);
+			align = get16(data + i + 20);
+			bits = get16(data + i + 22);
+
+			if((tag == 0xFFFE) && (len >= 26))
+				tag = get16(data + i + 32);
+
+			if((tag == 1) && (bits == 16))
+				wav->fmt = dsp_fmt_s16;
+			else if((tag == 1) && (bits == 24))
+				wav->fmt = dsp_fmt_s24;
+			else if((tag == 1) && (bits == 32))
+				wav->fmt = dsp_fmt_s32;
+			else if((tag == 3) && (bits == 32))
+				wav->fmt = dsp_fmt_f32;
+			else if((tag == 3) && (bits == 64))
+				wav->fmt = dsp_fmt_f64;
+			else
+				return false;
+
+			if((wav->nchan == 0) || (align != wav->nchan * dsp_fmt_size(wav->fmt)))
+				return false;
+
+			fmt = true;
+		}
+		else if(mem_isequal(data + i, "data", 4)) {
+			if(!fmt)
+				return false;
+
+			if(i + 8 + len > size)
+				len = size - i - 8;
+
+			wav->off = i + 8;
+			wav->len = len / align;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Write a canonical WAV header.
+ *   @data: The output buffer of 'DSP_WAV_HDRLEN' bytes.
+ *   @fmt: The sample format.
+ *   @nchan: The number of channels.
+ *   @rate: The sample rate.
+ *   @len: The length in frames.
+ */
+
+_export
+void dsp_wav_header(uint8_t *data, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int rate, size_t len)
+{
+	unsigned int align = nchan * dsp_fmt_size(fmt);
+	size_t size = len * align;
+
+	if(size > UINT32_MAX - DSP_WAV_HDRLEN)
+		size = UINT32_MAX - DSP_WAV_HDRLEN;
+
+	mem_copy(data + 0, "RIFF", 4);
+	put32(data + 4, size + DSP_WAV_HDRLEN - 8);
+	mem_copy(data + 8, "WAVE", 4);
+
+	mem_copy(data + 12, "fmt ", 4);
+	put32(data + 16, 16);
+	put16(data + 20, ((fmt == dsp_fmt_f32) || (fmt == dsp_fmt_f64)) ? 3 : 1);
+	put16(data + 22, nchan);
+	put32(data + 24, rate);
+	put32(data + 28, rate * align);
+	put16(data + 32, align);
+	put16(data + 34, 8 * dsp_fmt_size(fmt));
+
+	mem_copy(data + 36, "data", 4);
+	put32(data + 40, size);
+}
+
+
+/**
+ * Read a little-endian 16-bit value.
+ *   @ptr: The pointer.
+ *   &returns: The value.
+ */
+
+static uint16_t get16(const uint8_t *ptr)
+{
+	return (uint16_t)ptr[0] | ((uint16_t)ptr[1] << 8);
+}
+
+/**
+ * Read a little-endian 32-bit value.
+ *   @ptr: The pointer.
+ *   &returns: The value.
+ */
+
+static uint32_t get32(const uint8_t *ptr)
+{
+	return (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+}
+
+/**
+ * Write a little-endian 16-bit value.
+ *   @ptr: The pointer.
+ *   @val: The value.
+ */
+
+static void put16(uint8_t *ptr, uint16_t val)
+{
+	ptr[0] = val;
+	ptr[1] = val >> 8;
+}
+
+/**
+ * Write a little-endian 32-bit value.
+ *   @ptr: The pointer.
+ *   @val: The value.
+ */
+
+static void put32(uint8_t *ptr, uint32_t val)
+{
+	ptr[0] = val;
+	ptr[1] = val >> 8;
+	ptr[2] = val >> 16;
+	ptr[3] = val >> 24;
+}
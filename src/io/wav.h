@@ -0,0 +1,44 @@
+#ifndef IO_WAV_H
+#define IO_WAV_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/**
+ * WAV header information structure.
+ *   @fmt: The sample format.
+ *   @nchan, rate: The channel count and sample rate.
+ *   @off, len: The data offset in bytes and length in frames.
+ */
+
+struct dsp_wav_t {
+	enum dsp_fmt_e fmt;
+	unsigned int nchan, rate;
+
+	size_t off, len;
+};
+
+
+/*
+ * wav definitions
+ */
+
+#define DSP_WAV_HDRLEN	44
+
+/*
+ * wav function declarations
+ */
+
+bool dsp_wav_parse(struct dsp_wav_t *wav, const uint8_t *data, size_t size);
+void dsp_wav_header(uint8_t *data, enum dsp_fmt_e fmt, unsigned int nchan, unsigned int rate, size_t len);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -0,0 +1,522 @@
+#include "common.h"
+#include "poly.h"
+#include "osc.h"
+#include "shape.h"
+#include "simd.h"
+#include "filter/moog.h"
+
+
+/*
+ * polyphonic definitions
+ */
+
+#define POLY_CTRL 32
+#define POLY_HELD (UINT_MAX / 2)
+#define POLY_ON 0x1
+#define POLY_OFF 0x2
+
+/**
+ * Lane mask type, the result of comparing two vectors.
+ */
+
+typedef int64_t poly_mask_t __attribute__((vector_size(4 * sizeof(int64_t))));
+
+
+/**
+ * Voice control structure, holding the scalar per-voice state.
+ *   @next: The next free voice plus one, zero for none.
+ *   @claim: Set while the voice is on the free list or being started.
+ *   @cmd: The pending command flags.
+ *   @gen: The generation, advanced on each start.
+ *   @active: The active flag.
+ *   @t, sus: The envelope time and release time in samples.
+ *   @amp: The linear amplitude.
+ *   @adsr: The envelope.
+ *   @note: The pending note.
+ */
+
+struct poly_ctl_t {
+	uint32_t next;
+	uint8_t claim;
+	uint32_t cmd;
+	uint16_t gen;
+
+	bool active;
+	unsigned int t, sus;
+	double amp;
+	struct dsp_adsr_t adsr;
+
+	struct dsp_poly_note_t note;
+};
+
+/**
+ * Polyphonic voice pool structure. The per-sample state is stored as
+ * structure of arrays padded to a multiple of four voices, so that each
+ * group of four voices is rendered in one vector.
+ *   @nvoice, ngrp, rate: The voice count, group count, and sample rate.
+ *   @head: The free list head, tagged with a counter in the upper bits.
+ *   @nactive: The number of active voices.
+ *   @grp: The number of active voices per group.
+ *   @mem: The state allocation.
+ *   @phase, step: The oscillator phase and step.
+ *   @wsaw, wsq, wtri: The oscillator mix weights.
+ *   @gain, delta: The envelope gain and its per-sample increment.
+ *   @ca, cb, cw, cg: The filter constants.
+ *   @y: The filter output history.
+ *   @ctl: The voice controls.
+ */
+
+struct dsp_poly_t {
+	unsigned int nvoice, ngrp, rate;
+
+	uint64_t head;
+	unsigned int nactive;
+	uint8_t *grp;
+
+	void *mem;
+	double *phase, *step;
+	double *wsaw, *wsq, *wtri;
+	double *gain, *delta;
+	double *ca, *cb, *cw, *cg;
+	double *y[4];
+
+	struct poly_ctl_t ctl[];
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void voice_start(struct dsp_poly_t *poly, unsigned int v);
+static void voice_finish(struct dsp_poly_t *poly, unsigned int v);
+static double voice_env(struct dsp_poly_t *poly, unsigned int v, unsigned int t);
+static void group_proc(struct dsp_poly_t *poly, unsigned int g, dsp_vec_t *acc, unsigned int len);
+
+static unsigned int list_pop(struct dsp_poly_t *poly);
+static void list_push(struct dsp_poly_t *poly, unsigned int v);
+static unsigned int steal(struct dsp_poly_t *poly);
+
+
+/**
+ * Create a polyphonic voice pool. Each voice is a mix of sawtooth, square,
+ * and triangle oscillators, shaped by an ADSR envelope evaluated at control
+ * rate and filtered by a moog filter.
+ *   @nvoice: The number of voices, at most 65535.
+ *   @rate: The sample rate.
+ *   &returns: The voice pool.
+ */
+
+_export
+struct dsp_poly_t *dsp_poly_new(unsigned int nvoice, unsigned int rate)
+{
+	unsigned int i, n;
+	double **arr[15];
+	struct dsp_poly_t *poly;
+
+	if((nvoice == 0) || (nvoice > UINT16_MAX))
+		throw("Invalid voice count.");
+
+	poly = mem_alloc(sizeof(struct dsp_poly_t) + nvoice * sizeof(struct poly_ctl_t));
+	poly->nvoice = nvoice;
+	poly->ngrp = (nvoice + 3) / 4;
+	poly->rate = rate;
+	poly->head = 0;
+	poly->nactive = 0;
+	poly->grp = mem_alloc(poly->ngrp);
+	mem_set(poly->grp, 0x00, poly->ngrp);
+
+	arr[0] = &poly->phase;
+	arr[1] = &poly->step;
+	arr[2] = &poly->wsaw;
+	arr[3] = &poly->wsq;
+	arr[4] = &poly->wtri;
+	arr[5] = &poly->gain;
+	arr[6] = &poly->delta;
+	arr[7] = &poly->ca;
+	arr[8] = &poly->cb;
+	arr[9] = &poly->cw;
+	arr[10] = &poly->cg;
+
+	for(i = 0; i < 4; i++)
+		arr[11 + i] = &poly->y[i];
+
+	n = 4 * poly->ngrp;
+	poly->mem = mem_alloc(15 * n * sizeof(double) + sizeof(dsp_vec_t));
+	mem_set(poly->mem, 0x00, 15 * n * sizeof(double) + sizeof(dsp_vec_t));
+
+	for(i = 0; i < 15; i++)
+		*arr[i] = (double *)(((uintptr_t)poly->mem + sizeof(dsp_vec_t) - 1) & ~(uintptr_t)(sizeof(dsp_vec_t) - 1)) + i * n;
+
+	for(i = nvoice; i-- > 0; ) {
+		poly->ctl[i].claim = 1;
+		poly->ctl[i].cmd = 0;
+		poly->ctl[i].gen = 0;
+		poly->ctl[i].active = false;
+		list_push(poly, i);
+	}
+
+	return poly;
+}
+
+/**
+ * Delete a polyphonic voice pool.
+ *   @poly: The voice pool.
+ */
+
+_export
+void dsp_poly_delete(struct dsp_poly_t *poly)
+{
+	mem_free(poly->mem);
+	mem_free(poly->grp);
+	mem_free(poly);
+}
+
+
+/**
+ * Start a note. A free voice is taken from the lock-free free list or, if
+ * none are available, the oldest voice is stolen, preferring released
+ * voices. Safe to call from any thread; the note starts on the next
+ * processed block.
+ *   @poly: The voice pool.
+ *   @note: The note.
+ *   &returns: The voice identifier, or 'UINT_MAX' if no voice could be
+ *     claimed.
+ */
+
+_export
+unsigned int dsp_poly_on(struct dsp_poly_t *poly, const struct dsp_poly_note_t *note)
+{
+	unsigned int v;
+	uint16_t gen;
+
+	v = list_pop(poly);
+	if(v == UINT_MAX)
+		v = steal(poly);
+
+	if(v == UINT_MAX)
+		return UINT_MAX;
+
+	gen = __atomic_add_fetch(&poly->ctl[v].gen, 1, __ATOMIC_RELAXED);
+	poly->ctl[v].note = *note;
+	__atomic_store_n(&poly->ctl[v].cmd, POLY_ON, __ATOMIC_RELEASE);
+
+	return ((unsigned int)gen << 16) | v;
+}
+
+/**
+ * Release a note. Safe to call from any thread; stale identifiers of stolen
+ * voices are ignored.
+ *   @poly: The voice pool.
+ *   @id: The voice identifier.
+ */
+
+_export
+void dsp_poly_off(struct dsp_poly_t *poly, unsigned int id)
+{
+	unsigned int v = id & 0xffff;
+
+	if((v >= poly->nvoice) || (__atomic_load_n(&poly->ctl[v].gen, __ATOMIC_RELAXED) != (id >> 16)))
+		return;
+
+	__atomic_fetch_or(&poly->ctl[v].cmd, POLY_OFF, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * Render all active voices, adding the mix into a buffer. Only a single
+ * thread may process.
+ *   @poly: The voice pool.
+ *   @buf: The buffer.
+ *   @len: The length.
+ */
+
+_export
+void dsp_poly_proc(struct dsp_poly_t *poly, double *buf, unsigned int len)
+{
+	uint32_t cmd;
+	unsigned int i, v, g, n, off;
+	struct poly_ctl_t *ctl;
+	dsp_vec_t acc[POLY_CTRL];
+
+	for(v = 0; v < poly->nvoice; v++) {
+		ctl = &poly->ctl[v];
+		if(__atomic_load_n(&ctl->cmd, __ATOMIC_RELAXED) == 0)
+			continue;
+
+		cmd = __atomic_exchange_n(&ctl->cmd, 0, __ATOMIC_ACQUIRE);
+
+		if(cmd & POLY_ON)
+			voice_start(poly, v);
+
+		if((cmd & POLY_OFF) && ctl->active && (ctl->sus == POLY_HELD))
+			__atomic_store_n(&ctl->sus, ctl->t, __ATOMIC_RELAXED);
+	}
+
+	for(off = 0; off < len; off += n) {
+		n = (len - off < POLY_CTRL) ? (len - off) : POLY_CTRL;
+
+		for(v = 0; v < poly->nvoice; v++) {
+			ctl = &poly->ctl[v];
+			if(!ctl->active)
+				continue;
+
+			if(!dsp_adsr_active(ctl->adsr, ctl->t, ctl->sus)) {
+				voice_finish(poly, v);
+				continue;
+			}
+
+			__atomic_store_n(&ctl->t, ctl->t + n, __ATOMIC_RELAXED);
+			poly->delta[v] = (voice_env(poly, v, ctl->t) - poly->gain[v]) / n;
+		}
+
+		if(poly->nactive == 0)
+			break;
+
+		for(i = 0; i < n; i++)
+			acc[i] = (dsp_vec_t){ 0.0, 0.0, 0.0, 0.0 };
+
+		for(g = 0; g < poly->ngrp; g++) {
+			if(poly->grp[g] > 0)
+				group_proc(poly, g, acc, n);
+		}
+
+		for(i = 0; i < n; i++)
+			buf[off + i] += dsp_vec_sum(&acc[i]);
+	}
+}
+
+/**
+ * Retrieve the number of active voices.
+ *   @poly: The voice pool.
+ *   &returns: The number of active voices.
+ */
+
+_export
+unsigned int dsp_poly_active(struct dsp_poly_t *poly)
+{
+	return poly->nactive;
+}
+
+
+/**
+ * Start a voice from its pending note.
+ *   @poly: The voice pool.
+ *   @v: The voice index.
+ */
+
+static void voice_start(struct dsp_poly_t *poly, unsigned int v)
+{
+	struct dsp_moog_t moog;
+	struct poly_ctl_t *ctl = &poly->ctl[v];
+	const struct dsp_poly_note_t *note = &ctl->note;
+
+	ctl->adsr = dsp_adsr_init(note->attack, note->decay, note->sustain, note->release, poly->rate);
+	ctl->amp = note->amp;
+	__atomic_store_n(&ctl->t, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&ctl->sus, POLY_HELD, __ATOMIC_RELAXED);
+
+	moog = dsp_moog_init(poly->rate, note->cutoff, note->res);
+	poly->phase[v] = 0.0;
+	poly->step[v] = dsp_osc_step(note->freq, poly->rate);
+	poly->wsaw[v] = note->saw;
+	poly->wsq[v] = note->square;
+	poly->wtri[v] = note->tri;
+	poly->gain[v] = 0.0;
+	poly->delta[v] = 0.0;
+	poly->ca[v] = moog.a;
+	poly->cb[v] = moog.b;
+	poly->cw[v] = moog.w;
+	poly->cg[v] = moog.g;
+	poly->y[0][v] = poly->y[1][v] = poly->y[2][v] = poly->y[3][v] = 0.0;
+
+	if(!ctl->active) {
+		ctl->active = true;
+		poly->grp[v / 4]++;
+		poly->nactive++;
+	}
+
+	__atomic_store_n(&ctl->claim, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Finish a voice whose envelope has ended, returning it to the free list
+ * unless it has just been stolen.
+ *   @poly: The voice pool.
+ *   @v: The voice index.
+ */
+
+static void voice_finish(struct dsp_poly_t *poly, unsigned int v)
+{
+	struct poly_ctl_t *ctl = &poly->ctl[v];
+
+	ctl->active = false;
+	poly->grp[v / 4]--;
+	poly->nactive--;
+	poly->gain[v] = poly->delta[v] = 0.0;
+	poly->y[0][v] = poly->y[1][v] = poly->y[2][v] = poly->y[3][v] = 0.0;
+
+	if(__atomic_exchange_n(&ctl->claim, 1, __ATOMIC_ACQ_REL) == 0)
+		list_push(poly, v);
+}
+
+/**
+ * Compute the linear envelope gain of a voice.
+ *   @poly: The voice pool.
+ *   @v: The voice index.
+ *   @t: The time.
+ *   &returns: The gain.
+ */
+
+static double voice_env(struct dsp_poly_t *poly, unsigned int v, unsigned int t)
+{
+	double db;
+	struct poly_ctl_t *ctl = &poly->ctl[v];
+
+	db = dsp_adsr_proc(ctl->adsr, t, ctl->sus);
+
+	return isinf(db) ? 0.0 : ctl->amp * pow(10.0, db / 20.0);
+}
+
+/**
+ * Render a group of four voices, accumulating into vector lanes.
+ *   @poly: The voice pool.
+ *   @g: The group index.
+ *   @acc: The accumulator, 'len' vectors long.
+ *   @len: The length, at most 'POLY_CTRL'.
+ */
+
+static void group_proc(struct dsp_poly_t *poly, unsigned int g, dsp_vec_t *acc, unsigned int len)
+{
+	unsigned int i, k = 4 * g;
+	dsp_vec_t ph, st, ws, wq, wt, gn, dt, ca, cb, cw, cg, y0, y1, y2, y3;
+	dsp_vec_t saw, sq, tri, x, y;
+	const dsp_vec_t one = { 1.0, 1.0, 1.0, 1.0 }, half = { 0.5, 0.5, 0.5, 0.5 }, two = { 2.0, 2.0, 2.0, 2.0 };
+	const poly_mask_t abs = { INT64_MAX, INT64_MAX, INT64_MAX, INT64_MAX };
+
+	dsp_vec_load(&ph, poly->phase + k);
+	dsp_vec_load(&st, poly->step + k);
+	dsp_vec_load(&ws, poly->wsaw + k);
+	dsp_vec_load(&wq, poly->wsq + k);
+	dsp_vec_load(&wt, poly->wtri + k);
+	dsp_vec_load(&gn, poly->gain + k);
+	dsp_vec_load(&dt, poly->delta + k);
+	dsp_vec_load(&ca, poly->ca + k);
+	dsp_vec_load(&cb, poly->cb + k);
+	dsp_vec_load(&cw, poly->cw + k);
+	dsp_vec_load(&cg, poly->cg + k);
+	dsp_vec_load(&y0, poly->y[0] + k);
+	dsp_vec_load(&y1, poly->y[1] + k);
+	dsp_vec_load(&y2, poly->y[2] + k);
+	dsp_vec_load(&y3, poly->y[3] + k);
+
+	for(i = 0; i < len; i++) {
+		ph += st;
+		ph -= (dsp_vec_t)((poly_mask_t)(ph >= one) & (poly_mask_t)one);
+
+		x = (dsp_vec_t)((poly_mask_t)(ph >= half) & (poly_mask_t)two);
+		saw = ph + ph - x;
+		sq = one - x;
+		tri = two * (dsp_vec_t)((poly_mask_t)(ph + ph - one) & abs) - one;
+
+		x = (ws * saw + wq * sq + wt * tri) * gn;
+		gn += dt;
+
+		y = cg * x + cw * (ca * y0 - cw * (cb * y1 - cw * (ca * y2 - cw * y3)));
+		y3 = y2;
+		y2 = y1;
+		y1 = y0;
+		y0 = y;
+
+		acc[i] += y;
+	}
+
+	dsp_vec_store(poly->phase + k, &ph);
+	dsp_vec_store(poly->gain + k, &gn);
+	dsp_vec_store(poly->y[0] + k, &y0);
+	dsp_vec_store(poly->y[1] + k, &y1);
+	dsp_vec_store(poly->y[2] + k, &y2);
+	dsp_vec_store(poly->y[3] + k, &y3);
+}
+
+
+/**
+ * Pop a voice from the free list.
+ *   @poly: The voice pool.
+ *   &returns: The voice index, or 'UINT_MAX' if empty.
+ */
+
+static unsigned int list_pop(struct dsp_poly_t *poly)
+{
+	uint64_t head, next;
+
+	head = __atomic_load_n(&poly->head, __ATOMIC_ACQUIRE);
+
+	do {
+		if((uint32_t)head == 0)
+			return UINT_MAX;
+
+		next = ((head >> 32) + 1) << 32 | __atomic_load_n(&poly->ctl[(uint32_t)head - 1].next, __ATOMIC_RELAXED);
+	} while(!__atomic_compare_exchange_n(&poly->head, &head, next, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+	return (uint32_t)head - 1;
+}
+
+/**
+ * Push a voice onto the free list.
+ *   @poly: The voice pool.
+ *   @v: The voice index.
+ */
+
+static void list_push(struct dsp_poly_t *poly, unsigned int v)
+{
+	uint64_t head, next;
+
+	head = __atomic_load_n(&poly->head, __ATOMIC_RELAXED);
+
+	do {
+		__atomic_store_n(&poly->ctl[v].next, (uint32_t)head, __ATOMIC_RELAXED);
+		next = ((head >> 32) + 1) << 32 | (v + 1);
+	} while(!__atomic_compare_exchange_n(&poly->head, &head, next, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * Steal the oldest unclaimed voice, preferring voices already released.
+ *   @poly: The voice pool.
+ *   &returns: The voice index, or 'UINT_MAX' if none could be claimed.
+ */
+
+static unsigned int steal(struct dsp_poly_t *poly)
+{
+	unsigned int v, try, best;
+	uint64_t age, max;
+	struct poly_ctl_t *ctl;
+
+	for(try = 0; try < 4; try++) {
+		best = UINT_MAX;
+		max = 0;
+
+		for(v = 0; v < poly->nvoice; v++) {
+			ctl = &poly->ctl[v];
+			if(__atomic_load_n(&ctl->claim, __ATOMIC_RELAXED) != 0)
+				continue;
+
+			age = __atomic_load_n(&ctl->t, __ATOMIC_RELAXED) + 1;
+			if(__atomic_load_n(&ctl->sus, __ATOMIC_RELAXED) != POLY_HELD)
+				age += (uint64_t)1 << 32;
+
+			if(age > max) {
+				max = age;
+				best = v;
+			}
+		}
+
+		if(best == UINT_MAX)
+			return UINT_MAX;
+
+		if(__atomic_exchange_n(&poly->ctl[best].claim, 1, __ATOMIC_ACQ_REL) == 0)
+			return best;
+	}
+
+	return UINT_MAX;
+}
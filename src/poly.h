@@ -0,0 +1,53 @@
+#ifndef POLY_H
+#define POLY_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/**
+ * Polyphonic note structure.
+ *   @freq, amp: The frequency and linear amplitude.
+ *   @saw, square, tri: The oscillator mix weights.
+ *   @cutoff, res: The filter cutoff frequency and resonance.
+ *   @attack, decay, release: The envelope times in seconds.
+ *   @sustain: The envelope sustain level in decibels.
+ */
+
+struct dsp_poly_note_t {
+	double freq, amp;
+	double saw, square, tri;
+	double cutoff, res;
+	double attack, decay, release;
+	double sustain;
+};
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_poly_t;
+
+/*
+ * polyphonic voice pool function declarations
+ */
+
+struct dsp_poly_t *dsp_poly_new(unsigned int nvoice, unsigned int rate);
+void dsp_poly_delete(struct dsp_poly_t *poly);
+
+unsigned int dsp_poly_on(struct dsp_poly_t *poly, const struct dsp_poly_note_t *note);
+void dsp_poly_off(struct dsp_poly_t *poly, unsigned int id);
+
+void dsp_poly_proc(struct dsp_poly_t *poly, double *buf, unsigned int len);
+unsigned int dsp_poly_active(struct dsp_poly_t *poly);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
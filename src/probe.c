@@ -0,0 +1,117 @@
+#include "common.h"
+#include "probe.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void probe_lock(void);
+
+/*
+ * global variables
+ */
+
+_export __thread struct dsp_probe_buf_t *dsp_probe_local = NULL;
+
+static struct dsp_probe_buf_t *probe_list = NULL;
+static int probe_init = 0;
+static struct thread_mutex_t probe_mutex;
+
+
+/**
+ * Attach a probe buffer to the calling thread. Buffers are never freed so
+ * that entries recorded by exited threads can still be drained.
+ *   &returns: The buffer.
+ */
+
+_export
+struct dsp_probe_buf_t *dsp_probe_attach(void)
+{
+	struct dsp_probe_buf_t *buf;
+
+	if(dsp_probe_local != NULL)
+		return dsp_probe_local;
+
+	buf = mem_alloc(sizeof(struct dsp_probe_buf_t));
+	buf->wr = buf->rd = buf->lost = 0;
+
+	do
+		buf->next = __atomic_load_n(&probe_list, __ATOMIC_ACQUIRE);
+	while(!__sync_bool_compare_and_swap(&probe_list, buf->next, buf));
+
+	dsp_probe_local = buf;
+
+	return buf;
+}
+
+/**
+ * Drain all recorded probe entries. Entries from each thread are delivered
+ * in order. Drains are serialized by a mutex, so any thread may call this,
+ * but not from within the callback.
+ *   @func: The callback.
+ *   @arg: The callback argument.
+ *   &returns: The number of entries drained.
+ */
+
+_export
+unsigned int dsp_probe_drain(dsp_probe_f func, void *arg)
+{
+	unsigned int rd, wr, cnt = 0;
+	struct dsp_probe_buf_t *buf;
+
+	probe_lock();
+
+	for(buf = __atomic_load_n(&probe_list, __ATOMIC_ACQUIRE); buf != NULL; buf = buf->next) {
+		wr = __atomic_load_n(&buf->wr, __ATOMIC_ACQUIRE);
+
+		for(rd = buf->rd; rd != wr; rd++, cnt++)
+			func(buf->ent[rd % DSP_PROBE_LEN].name, buf->ent[rd % DSP_PROBE_LEN].val, arg);
+
+		__atomic_store_n(&buf->rd, rd, __ATOMIC_RELEASE);
+	}
+
+	thread_mutex_unlock(&probe_mutex);
+
+	return cnt;
+}
+
+/**
+ * Retrieve the number of entries dropped because a buffer was full.
+ *   &returns: The total across all threads.
+ */
+
+_export
+unsigned int dsp_probe_lost(void)
+{
+	unsigned int cnt = 0;
+	struct dsp_probe_buf_t *buf;
+
+	for(buf = __atomic_load_n(&probe_list, __ATOMIC_ACQUIRE); buf != NULL; buf = buf->next)
+		cnt += __atomic_load_n(&buf->lost, __ATOMIC_RELAXED);
+
+	return cnt;
+}
+
+
+/**
+ * Lock the drain mutex, creating it on first use.
+ */
+
+static void probe_lock(void)
+{
+	int state = 0;
+
+	if(__atomic_load_n(&probe_init, __ATOMIC_ACQUIRE) != 2) {
+		if(__atomic_compare_exchange_n(&probe_init, &state, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+			probe_mutex = thread_mutex_new(NULL);
+			__atomic_store_n(&probe_init, 2, __ATOMIC_RELEASE);
+		}
+		else {
+			while(__atomic_load_n(&probe_init, __ATOMIC_ACQUIRE) != 2)
+				sched_yield();
+		}
+	}
+
+	thread_mutex_lock(&probe_mutex);
+}
@@ -0,0 +1,113 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * probe definitions
+ */
+
+#define DSP_PROBE_LEN 4096
+
+
+/**
+ * Probe entry.
+ *   @name: The probe name, a string with static storage.
+ *   @val: The recorded value.
+ */
+
+struct dsp_probe_ent_t {
+	const char *name;
+	double val;
+};
+
+/**
+ * Per-thread probe buffer, a single-producer single-consumer ring. Entries
+ * are dropped and counted when the ring is full.
+ *   @next: The next buffer.
+ *   @wr, rd: The write and read counts.
+ *   @lost: The number of dropped entries.
+ *   @ent: The entries.
+ */
+
+struct dsp_probe_buf_t {
+	struct dsp_probe_buf_t *next;
+
+	unsigned int wr, rd, lost;
+	struct dsp_probe_ent_t ent[DSP_PROBE_LEN];
+};
+
+/**
+ * Probe drain callback.
+ *   @name: The probe name.
+ *   @val: The recorded value.
+ *   @arg: The argument.
+ */
+
+typedef void (*dsp_probe_f)(const char *name, double val, void *arg);
+
+
+/*
+ * probe function declarations
+ */
+
+struct dsp_probe_buf_t *dsp_probe_attach(void);
+unsigned int dsp_probe_drain(dsp_probe_f func, void *arg);
+unsigned int dsp_probe_lost(void);
+
+/*
+ * probe variables
+ */
+
+extern __thread struct dsp_probe_buf_t *dsp_probe_local;
+
+
+/**
+ * Record a probe value into the calling thread's buffer. The buffer is
+ * allocated on first use; call 'dsp_probe_attach' when a real-time thread
+ * starts to avoid allocating from it.
+ *   @name: The probe name, a string with static storage.
+ *   @val: The value.
+ */
+
+static inline void dsp_probe_rec(const char *name, double val)
+{
+	unsigned int wr;
+	struct dsp_probe_buf_t *buf = dsp_probe_local;
+
+	if(buf == NULL)
+		buf = dsp_probe_attach();
+
+	wr = buf->wr;
+	if((wr - __atomic_load_n(&buf->rd, __ATOMIC_ACQUIRE)) >= DSP_PROBE_LEN) {
+		buf->lost++;
+		return;
+	}
+
+	buf->ent[wr % DSP_PROBE_LEN] = (struct dsp_probe_ent_t){ name, val };
+	__atomic_store_n(&buf->wr, wr + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Probes are compiled only when 'DSP_INSTRUMENT' is defined before including
+ * the header; otherwise they expand to nothing and the arguments are not
+ * evaluated.
+ */
+
+#ifdef DSP_INSTRUMENT
+#	define DSP_PROBE(name, val) dsp_probe_rec(name, val)
+#else
+#	define DSP_PROBE(name, val) ((void)0)
+#endif
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
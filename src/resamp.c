@@ -0,0 +1,451 @@
+#include "common.h"
+#include "resamp.h"
+#include "buf.h"
+#include "cache.h"
+#include "simd.h"
+#include "filter/multirate.h"
+
+
+/*
+ * resampler definitions
+ */
+
+#define MAXPHASE	512
+#define INTERP		256
+#define HALFTAPS	16
+#define BLKLEN		1024
+#define ROLLOFF		0.91
+#define BETA		8.0
+
+
+/**
+ * Coefficient table key.
+ *   @l, m: The output and input steps.
+ */
+
+struct tab_key_t {
+	uint64_t l, m;
+};
+
+/**
+ * Coefficient table structure. Tables are shared between all resamplers
+ * with the same ratio, through the shared cache.
+ *   @l, m: The output and input steps, where each output advances the
+ *     input by 'm / l' samples.
+ *   @nphase, ntaps: The number of phases and taps per phase.
+ *   @coef: The coefficients, 'nphase + 1' rows of 'ntaps' each.
+ */
+
+struct dsp_resamp_tab_t {
+	uint64_t l, m;
+	unsigned int nphase, ntaps;
+
+	double coef[];
+};
+
+/**
+ * Resampler structure.
+ *   @tab: The coefficient table.
+ *   @nchan: The number of channels.
+ *   @ph: The phase in units of '1 / l' input samples.
+ *   @pos, fill, cap: The window start, filled length, and capacity.
+ *   @func: The source callback.
+ *   @arg: The source argument.
+ *   @buf: The input history, 'cap' samples per channel.
+ *   @tmp: The source buffer, 'BLKLEN' samples per channel.
+ */
+
+struct dsp_resamp_t {
+	struct dsp_resamp_tab_t *tab;
+	unsigned int nchan;
+
+	uint64_t ph;
+	unsigned int pos, fill, cap;
+
+	dsp_flow_f func;
+	void *arg;
+
+	double *buf, *tmp;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static struct dsp_resamp_t *resamp_new(uint64_t l, uint64_t m, unsigned int nchan);
+static void resamp_compact(struct dsp_resamp_t *resamp);
+
+static struct dsp_resamp_tab_t *tab_get(uint64_t l, uint64_t m);
+static void tab_put(struct dsp_resamp_tab_t *tab);
+static void *tab_build(const void *key);
+
+/*
+ * global variables
+ */
+
+static struct dsp_cache_t cache = DSP_CACHE_INIT(sizeof(struct tab_key_t), false);
+
+
+/**
+ * Create a resampler between two integer rates. The ratio is reduced and
+ * handled exactly when the reduced output rate is small enough to use one
+ * filter phase per output position.
+ *   @inrate: The input rate.
+ *   @outrate: The output rate, within 'DSP_RESAMP_MAXRATIO' of the input
+ *     rate either way.
+ *   @nchan: The number of channels.
+ *   &returns: The resampler.
+ */
+
+_export
+struct dsp_resamp_t *dsp_resamp_new(unsigned int inrate, unsigned int outrate, unsigned int nchan)
+{
+	unsigned int gcd;
+
+	if((inrate == 0) || (outrate == 0) || (outrate > inrate * DSP_RESAMP_MAXRATIO) || (inrate > outrate * DSP_RESAMP_MAXRATIO))
+		throw("Invalid resampling rate.");
+
+	gcd = m_gcd(inrate, outrate);
+
+	return resamp_new(outrate / gcd, inrate / gcd, nchan);
+}
+
+/**
+ * Create a resampler with an arbitrary ratio. The ratio is bounded so that
+ * the filter length and the coefficient table stay bounded.
+ *   @ratio: The ratio of output rate to input rate, from the inverse of
+ *     'DSP_RESAMP_MAXRATIO' to 'DSP_RESAMP_MAXRATIO'.
+ *   @nchan: The number of channels.
+ *   &returns: The resampler.
+ */
+
+_export
+struct dsp_resamp_t *dsp_resamp_ratio(double ratio, unsigned int nchan)
+{
+	if(!(ratio >= 1.0 / DSP_RESAMP_MAXRATIO) || !(ratio <= DSP_RESAMP_MAXRATIO))
+		throw("Invalid resampling ratio.");
+
+	return resamp_new((uint64_t)1 << 32, (uint64_t)llround(4294967296.0 / ratio), nchan);
+}
+
+/**
+ * Delete a resampler.
+ *   @resamp: The resampler.
+ */
+
+_export
+void dsp_resamp_delete(struct dsp_resamp_t *resamp)
+{
+	tab_put(resamp->tab);
+	mem_free(resamp->buf);
+	mem_free(resamp->tmp);
+	mem_free(resamp);
+}
+
+
+/**
+ * Configure the source used when pulling from the resampler.
+ *   @resamp: The resampler.
+ *   @func: The source callback.
+ *   @arg: The source argument.
+ */
+
+_export
+void dsp_resamp_conf(struct dsp_resamp_t *resamp, dsp_flow_f func, void *arg)
+{
+	resamp->func = func;
+	resamp->arg = arg;
+}
+
+/**
+ * Reset the resampler, clearing all history.
+ *   @resamp: The resampler.
+ */
+
+_export
+void dsp_resamp_reset(struct dsp_resamp_t *resamp)
+{
+	unsigned int i;
+
+	resamp->ph = 0;
+	resamp->pos = 0;
+	resamp->fill = resamp->tab->ntaps / 2 - 1;
+
+	for(i = 0; i < resamp->nchan; i++)
+		dsp_buf_zero(resamp->buf + i * resamp->cap, resamp->fill);
+}
+
+/**
+ * Retrieve the lookahead of the resampler. Outputs are aligned with the
+ * input, but each output requires this many input samples past its
+ * position before it can be read.
+ *   @resamp: The resampler.
+ *   &returns: The lookahead in input samples.
+ */
+
+_export
+unsigned int dsp_resamp_delay(struct dsp_resamp_t *resamp)
+{
+	return resamp->tab->ntaps / 2;
+}
+
+
+/**
+ * Compute the number of input samples needed before a number of outputs
+ * can be read.
+ *   @resamp: The resampler.
+ *   @len: The number of outputs.
+ *   &returns: The number of input samples.
+ */
+
+_export
+unsigned int dsp_resamp_need(struct dsp_resamp_t *resamp, unsigned int len)
+{
+	uint64_t end;
+	struct dsp_resamp_tab_t *tab = resamp->tab;
+
+	if(len == 0)
+		return 0;
+
+	end = resamp->pos + (resamp->ph + (uint64_t)(len - 1) * tab->m) / tab->l + tab->ntaps;
+
+	return (end > resamp->fill) ? (end - resamp->fill) : 0;
+}
+
+/**
+ * Write input samples to the resampler.
+ *   @resamp: The resampler.
+ *   @buf: The input buffers, one per channel.
+ *   @len: The number of samples.
+ *   &returns: The number of samples accepted.
+ */
+
+_export
+unsigned int dsp_resamp_write(struct dsp_resamp_t *resamp, double **buf, unsigned int len)
+{
+	unsigned int i;
+
+	if(resamp->fill + len > resamp->cap)
+		resamp_compact(resamp);
+
+	if(len > resamp->cap - resamp->fill)
+		len = resamp->cap - resamp->fill;
+
+	for(i = 0; i < resamp->nchan; i++)
+		dsp_buf_copy(resamp->buf + i * resamp->cap + resamp->fill, buf[i], len);
+
+	resamp->fill += len;
+
+	return len;
+}
+
+/**
+ * Read output samples from the resampler.
+ *   @resamp: The resampler.
+ *   @buf: The output buffers, one per channel.
+ *   @len: The maximum number of samples.
+ *   &returns: The number of samples read.
+ */
+
+_export
+unsigned int dsp_resamp_read(struct dsp_resamp_t *resamp, double **buf, unsigned int len)
+{
+	unsigned int i, n, p;
+	uint64_t q;
+	double a, y;
+	const double *h;
+	struct dsp_resamp_tab_t *tab = resamp->tab;
+	unsigned int ntaps = tab->ntaps;
+
+	for(n = 0; (n < len) && (resamp->pos + ntaps <= resamp->fill); n++) {
+		if(tab->nphase == tab->l) {
+			p = resamp->ph;
+			a = 0.0;
+		}
+		else {
+			q = resamp->ph * tab->nphase;
+			p = q / tab->l;
+			a = (double)(q - p * tab->l) / (double)tab->l;
+		}
+
+		h = tab->coef + p * ntaps;
+
+		for(i = 0; i < resamp->nchan; i++) {
+			const double *x = resamp->buf + i * resamp->cap + resamp->pos;
+
+			y = dsp_vec_dot(h, x, ntaps);
+			if(a != 0.0)
+				y += a * (dsp_vec_dot(h + ntaps, x, ntaps) - y);
+
+			buf[i][n] = y;
+		}
+
+		resamp->ph += tab->m;
+		resamp->pos += resamp->ph / tab->l;
+		resamp->ph %= tab->l;
+	}
+
+	return n;
+}
+
+
+/**
+ * Pull resampled data, requesting input from the configured source as
+ * needed. This may be used directly as a flow node or playback callback.
+ *   @buf: The output buffers.
+ *   @len: The buffer length.
+ *   @arg: The resampler.
+ */
+
+_export
+void dsp_resamp_pull(double **buf, unsigned int len, void *arg)
+{
+	struct dsp_resamp_t *resamp = arg;
+	unsigned int i, n, off, cnt, nchan = resamp->nchan;
+	double *out[nchan], *in[nchan];
+
+	for(i = 0; i < nchan; i++)
+		in[i] = resamp->tmp + i * BLKLEN;
+
+	for(off = 0; off < len; off += n) {
+		for(i = 0; i < nchan; i++)
+			out[i] = buf[i] + off;
+
+		n = dsp_resamp_read(resamp, out, len - off);
+		if(n > 0)
+			continue;
+
+		resamp_compact(resamp);
+
+		cnt = dsp_resamp_need(resamp, len - off);
+		if(cnt > BLKLEN)
+			cnt = BLKLEN;
+
+		if(cnt > resamp->cap - resamp->fill)
+			cnt = resamp->cap - resamp->fill;
+
+		if(resamp->func != NULL)
+			resamp->func(in, cnt, resamp->arg);
+		else {
+			for(i = 0; i < nchan; i++)
+				dsp_buf_zero(in[i], cnt);
+		}
+
+		dsp_resamp_write(resamp, in, cnt);
+	}
+}
+
+
+/**
+ * Create a resampler from output and input steps.
+ *   @l: The output step.
+ *   @m: The input step.
+ *   @nchan: The number of channels.
+ *   &returns: The resampler.
+ */
+
+static struct dsp_resamp_t *resamp_new(uint64_t l, uint64_t m, unsigned int nchan)
+{
+	struct dsp_resamp_t *resamp;
+
+	resamp = mem_alloc(sizeof(struct dsp_resamp_t));
+	resamp->tab = tab_get(l, m);
+	resamp->nchan = nchan;
+	resamp->cap = resamp->tab->ntaps + BLKLEN;
+	resamp->buf = mem_alloc(nchan * resamp->cap * sizeof(double));
+	resamp->tmp = mem_alloc(nchan * BLKLEN * sizeof(double));
+	resamp->func = NULL;
+	resamp->arg = NULL;
+	dsp_resamp_reset(resamp);
+
+	return resamp;
+}
+
+/**
+ * Compact the resampler history, moving the window to the beginning.
+ *   @resamp: The resampler.
+ */
+
+static void resamp_compact(struct dsp_resamp_t *resamp)
+{
+	unsigned int i;
+	double *buf;
+
+	if(resamp->pos == 0)
+		return;
+
+	for(i = 0; i < resamp->nchan; i++) {
+		buf = resamp->buf + i * resamp->cap;
+		mem_move(buf, buf + resamp->pos, (resamp->fill - resamp->pos) * sizeof(double));
+	}
+
+	resamp->fill -= resamp->pos;
+	resamp->pos = 0;
+}
+
+
+/**
+ * Retrieve a coefficient table, building it if not already cached.
+ *   @l: The output step.
+ *   @m: The input step.
+ *   &returns: The table.
+ */
+
+static struct dsp_resamp_tab_t *tab_get(uint64_t l, uint64_t m)
+{
+	return dsp_cache_get(&cache, &(struct tab_key_t){ l, m }, tab_build);
+}
+
+/**
+ * Release a coefficient table, removing it from the cache once unused.
+ *   @tab: The table.
+ */
+
+static void tab_put(struct dsp_resamp_tab_t *tab)
+{
+	dsp_cache_put(&cache, tab);
+}
+
+/**
+ * Build a coefficient table. This runs without any lock held.
+ *   @key: The table key.
+ *   &returns: The table.
+ */
+
+static void *tab_build(const void *key)
+{
+	unsigned int p, k, nphase, ntaps;
+	uint64_t l = ((const struct tab_key_t *)key)->l, m = ((const struct tab_key_t *)key)->m;
+	double fc, u, sum, *row;
+	struct dsp_resamp_tab_t *tab;
+
+	fc = (l >= m) ? 1.0 : ((double)l / (double)m);
+	ntaps = ceil(2 * HALFTAPS / fc);
+	ntaps = (ntaps + 3) & ~3;
+	nphase = (l <= MAXPHASE) ? l : INTERP;
+
+	if(l != m)
+		fc *= ROLLOFF;
+
+	tab = dsp_cache_alloc(sizeof(struct dsp_resamp_tab_t) + (nphase + 1) * ntaps * sizeof(double));
+	tab->l = l;
+	tab->m = m;
+	tab->nphase = nphase;
+	tab->ntaps = ntaps;
+
+	for(p = 0; p <= nphase; p++) {
+		row = tab->coef + p * ntaps;
+
+		for(k = 0, sum = 0.0; k < ntaps; k++) {
+			u = (double)p / nphase + ntaps / 2 - 1 - (double)k;
+			row[k] = fc * ((u == 0.0) ? 1.0 : sin(M_PI * fc * u) / (M_PI * fc * u)) * dsp_multirate_kaiser(u / (ntaps / 2), BETA);
+			sum += row[k];
+		}
+
+		for(k = 0; k < ntaps; k++)
+			row[k] /= sum;
+	}
+
+	return tab;
+}
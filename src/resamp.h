@@ -0,0 +1,47 @@
+#ifndef RESAMP_H
+#define RESAMP_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * resampler definitions
+ */
+
+#define DSP_RESAMP_MAXRATIO 256.0
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_resamp_t;
+
+/*
+ * resampler function declarations
+ */
+
+struct dsp_resamp_t *dsp_resamp_new(unsigned int inrate, unsigned int outrate, unsigned int nchan);
+struct dsp_resamp_t *dsp_resamp_ratio(double ratio, unsigned int nchan);
+void dsp_resamp_delete(struct dsp_resamp_t *resamp);
+
+void dsp_resamp_conf(struct dsp_resamp_t *resamp, dsp_flow_f func, void *arg);
+void dsp_resamp_reset(struct dsp_resamp_t *resamp);
+unsigned int dsp_resamp_delay(struct dsp_resamp_t *resamp);
+
+unsigned int dsp_resamp_need(struct dsp_resamp_t *resamp, unsigned int len);
+unsigned int dsp_resamp_write(struct dsp_resamp_t *resamp, double **buf, unsigned int len);
+unsigned int dsp_resamp_read(struct dsp_resamp_t *resamp, double **buf, unsigned int len);
+
+void dsp_resamp_pull(double **buf, unsigned int len, void *arg);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -106,6 +106,64 @@ static inline double dsp_reverb_allpass_lpf(double x, struct dsp_ring_t *ring, s
 	return y;
 }
 
+/**
+ * Process an all-pass reverberator over a block. The read and write indices
+ * are stepped directly instead of being reduced modulo the ring length on
+ * every sample. The input and output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @ring: The ring buffer.
+ *   @allpass: The all-pass reverberator.
+ */
+
+static inline void dsp_reverb_allpass_block(const double *x, double *y, unsigned int len, struct dsp_ring_t *ring, struct dsp_reverb_allpass_t allpass)
+{
+	unsigned int i, wr = ring->idx, rd = dsp_mod(ring->idx - allpass.delay, ring->len);
+	double v, u;
+
+	for(i = 0; i < len; i++) {
+		v = ring->arr[rd];
+		u = x[i] - allpass.gain * v;
+		y[i] = v + allpass.gain * u;
+		ring->arr[wr] = u;
+
+		rd = (rd + 1 == ring->len) ? 0 : (rd + 1);
+		wr = (wr + 1 == ring->len) ? 0 : (wr + 1);
+	}
+
+	ring->idx = wr;
+}
+
+/**
+ * Process an all-pass reverberator with low-pass feedback over a block. The
+ * input and output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @ring: The ring buffer.
+ *   @allpass: The all-pass, low-pass feedback reverberator.
+ */
+
+static inline void dsp_reverb_allpass_lpf_block(const double *x, double *y, unsigned int len, struct dsp_ring_t *ring, struct dsp_reverb_allpass_lpf_t allpass)
+{
+	unsigned int i, wr = ring->idx, rd = dsp_mod(ring->idx - allpass.delay, ring->len);
+	double v, u, prev = dsp_ring_get(ring, -1);
+
+	for(i = 0; i < len; i++) {
+		v = ring->arr[rd];
+		u = x[i] - allpass.gain * v;
+		y[i] = v + allpass.gain * u;
+		u = (1.0 - allpass.mix) * u + allpass.mix * dsp_lpf_proc(u, prev, allpass.rc);
+		ring->arr[wr] = prev = u;
+
+		rd = (rd + 1 == ring->len) ? 0 : (rd + 1);
+		wr = (wr + 1 == ring->len) ? 0 : (wr + 1);
+	}
+
+	ring->idx = wr;
+}
+
 /* %~dsp.h% */
 
 /*
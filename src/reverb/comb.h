@@ -100,6 +100,58 @@ static inline double dsp_reverb_comb_lpf(struct dsp_ring_t *ring, double x, doub
 	return x;
 }
 
+/**
+ * Process a comb reverberator over a block, stepping the ring indices
+ * directly. The input and output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @ring: The ring buffer.
+ *   @comb: The comb reverberator.
+ */
+
+static inline void dsp_reverb_comb_block(const double *x, double *y, unsigned int len, struct dsp_ring_t *ring, struct dsp_reverb_comb_t comb)
+{
+	unsigned int i, wr = ring->idx, rd = dsp_mod(ring->idx - comb.delay, ring->len);
+
+	for(i = 0; i < len; i++) {
+		y[i] = x[i] + -comb.gain * ring->arr[rd];
+		ring->arr[wr] = y[i];
+
+		rd = (rd + 1 == ring->len) ? 0 : (rd + 1);
+		wr = (wr + 1 == ring->len) ? 0 : (wr + 1);
+	}
+
+	ring->idx = wr;
+}
+
+/**
+ * Process a comb reverberator with low-pass feedback over a block. The input
+ * and output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output.
+ *   @len: The length.
+ *   @ring: The ring buffer.
+ *   @comb: The comb, low-pass feedback reverberator.
+ */
+
+static inline void dsp_reverb_comb_lpf_block(const double *x, double *y, unsigned int len, struct dsp_ring_t *ring, struct dsp_reverb_comb_lpf_t comb)
+{
+	unsigned int i, wr = ring->idx, rd = dsp_mod(ring->idx - comb.delay, ring->len);
+	double u, prev = dsp_ring_get(ring, -1);
+
+	for(i = 0; i < len; i++) {
+		u = x[i] + -comb.gain * ring->arr[rd];
+		y[i] = u;
+		ring->arr[wr] = prev = (1.0 - comb.mix) * u + comb.mix * dsp_lpf_proc(u, prev, comb.rc);
+
+		rd = (rd + 1 == ring->len) ? 0 : (rd + 1);
+		wr = (wr + 1 == ring->len) ? 0 : (wr + 1);
+	}
+
+	ring->idx = wr;
+}
+
 /* %~dsp.h% */
 
 /*
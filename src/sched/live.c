@@ -12,27 +12,37 @@ static struct dsp_sched_inst_t *inst_get(struct dsp_sched_live_t *live, unsigned
 
 /**
  * Create a new live scheduler.
- *   @len: The list length.
+ *   @len: The list length, rounded up to a power of two, at most 2^31.
  *   @size: The element size.
  */
 
 _export
 struct dsp_sched_live_t *dsp_sched_live_new(unsigned int len, unsigned int size)
 {
-	unsigned int i;
+	unsigned int i, stride;
 	struct dsp_sched_live_t *live;
-	struct dsp_sched_inst_t *inst;
 
-	live = mem_alloc(sizeof(struct dsp_sched_live_t) + len * (size + sizeof(struct dsp_sched_inst_t)));
+	if((len > (1u << 31)) || (size > UINT_MAX - sizeof(struct dsp_sched_inst_t) - 7))
+		throw("Invalid live scheduler configuration.");
+
+	if(len < 2)
+		len = 2;
+
+	len = 1u << (32 - __builtin_clz(len - 1));
+	stride = (sizeof(struct dsp_sched_inst_t) + size + 7) & ~7u;
+
+	if(len > (SIZE_MAX - sizeof(struct dsp_sched_live_t)) / stride)
+		throw("Invalid live scheduler configuration.");
+
+	live = mem_alloc(sizeof(struct dsp_sched_live_t) + (size_t)len * stride);
 	live->len = len;
 	live->size = size;
+	live->mask = len - 1;
+	live->stride = stride;
 	live->rd = live->wr = 0;
 
-	for(i = 0; i < len; i++) {
-		inst = inst_get(live, i);
-		inst->active = 0;
-		inst->lock = 0;
-	}
+	for(i = 0; i < len; i++)
+		inst_get(live, i)->seq = i;
 
 	return live;
 }
@@ -50,73 +60,92 @@ void dsp_sched_live_delete(struct dsp_sched_live_t *live)
 
 
 /**
- * Add data to a live scheduler.
+ * Add data to a live scheduler. Safe to call from multiple threads.
  *   @live: The live scheduler.
  *   @data: The data.
- *   &returns: True if added, false if the current element is locked.
+ *   &returns: True if added, false if the queue is full.
  */
 
 _export
 bool dsp_sched_live_add(struct dsp_sched_live_t *live, const void *data)
 {
+	int diff;
+	unsigned int pos;
 	struct dsp_sched_inst_t *inst;
 
-	inst = inst_get(live, live->wr);
-	if(!__sync_bool_compare_and_swap(&inst->lock, 0, 1))
-		return false;
+	pos = __atomic_load_n(&live->wr, __ATOMIC_RELAXED);
 
-	inst->active = 1;
-	mem_copy(inst->data, data, live->size);
+	while(true) {
+		inst = inst_get(live, pos);
+		diff = (int)(__atomic_load_n(&inst->seq, __ATOMIC_ACQUIRE) - pos);
 
-	live->wr = (live->wr + 1) % live->len;
+		if(diff == 0) {
+			if(__atomic_compare_exchange_n(&live->wr, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}
+		else if(diff < 0)
+			return false;
+		else
+			pos = __atomic_load_n(&live->wr, __ATOMIC_RELAXED);
+	}
 
-	__sync_synchronize();
-	inst->lock = 0;
+	mem_copy(inst->data, data, live->size);
+	__atomic_store_n(&inst->seq, pos + 1, __ATOMIC_RELEASE);
 
 	return true;
 }
 
 /**
- * Remove data from a live scheduler.
+ * Remove data from a live scheduler. Only a single thread may remove.
  *   @live: The live scheduler.
  *   @data: The data.
- *   &returns: True if removed, false if the current element is locked or no
- *     available elements.
+ *   &returns: True if removed, false if no available elements.
  */
 
 _export
 bool dsp_sched_live_remove(struct dsp_sched_live_t *live, void *data)
 {
-	uint8_t active;
-	struct dsp_sched_inst_t *inst;
+	return dsp_sched_live_drain(live, data, 1) > 0;
+}
 
-	inst = inst_get(live, live->rd);
-	if(!__sync_bool_compare_and_swap(&inst->lock, 0, 1))
-		return false;
+/**
+ * Remove all pending data from a live scheduler in a single pass. Only a
+ * single thread may remove.
+ *   @live: The live scheduler.
+ *   @data: The data array, 'max' elements long.
+ *   @max: The maximum number of elements to remove.
+ *   &returns: The number of elements removed.
+ */
+
+_export
+unsigned int dsp_sched_live_drain(struct dsp_sched_live_t *live, void *data, unsigned int max)
+{
+	unsigned int n, pos = live->rd;
+	struct dsp_sched_inst_t *inst;
 
-	active = inst->active;
-	if(inst->active) {
-		inst->active = 0;
-		mem_copy(data, inst->data, live->size);
+	for(n = 0; n < max; n++, pos++) {
+		inst = inst_get(live, pos);
+		if(__atomic_load_n(&inst->seq, __ATOMIC_ACQUIRE) != pos + 1)
+			break;
 
-		live->rd = (live->rd + 1) % live->len;
+		mem_copy(data + n * live->size, inst->data, live->size);
+		__atomic_store_n(&inst->seq, pos + live->len, __ATOMIC_RELEASE);
 	}
 
-	__sync_synchronize();
-	inst->lock = 0;
+	__atomic_store_n(&live->rd, pos, __ATOMIC_RELAXED);
 
-	return active;
+	return n;
 }
 
 
 /**
  * Obtain an instance by index.
  *   @live: The live scheduler.
- *   @idx: The index.
+ *   @idx: The index, wrapped to the list length.
  *   &returns: The instance.
  */
 
 static struct dsp_sched_inst_t *inst_get(struct dsp_sched_live_t *live, unsigned int idx)
 {
-	return (struct dsp_sched_inst_t *)(live->data + idx * (live->size + sizeof(struct dsp_sched_inst_t)));
+	return (struct dsp_sched_inst_t *)(live->data + (size_t)(idx & live->mask) * live->stride);
 }
@@ -8,28 +8,38 @@
 /* %dsp.h% */
 
 /**
- * Live scheduler.
- *   @len, size: The list length and element size.
- *   @head, tail: The head and tail instances,
+ * Live scheduler, a bounded multi-producer single-consumer queue. The write
+ * and read indices are placed on separate cache lines so that producers and
+ * the consumer do not contend.
+ *   @len, size: The list length, always a power of two, and element size.
+ *   @mask, stride: The index mask and instance stride in bytes.
+ *   @wr: The write index, shared by producers.
+ *   @rd: The read index, owned by the consumer.
  *   @data: The data.
  */
 
 struct dsp_sched_live_t {
 	unsigned int len, size;
-	unsigned int rd, wr;
-	struct dsp_sched_inst_t *head, *tail;
+	unsigned int mask, stride;
+	uint8_t pad0[DSP_CACHELINE];
+
+	unsigned int wr;
+	uint8_t pad1[DSP_CACHELINE - sizeof(unsigned int)];
+
+	unsigned int rd;
+	uint8_t pad2[DSP_CACHELINE - sizeof(unsigned int)];
 
 	uint8_t data[];
 };
 
 /**
  * Live scheduled instance.
- *   @active: The lock and active flag.
+ *   @seq: The sequence number.
  *   @data: The data.
  */
 
 struct dsp_sched_inst_t {
-	uint8_t lock, active;
+	unsigned int seq;
 
 	uint8_t data[];
 };
@@ -44,6 +54,7 @@ void dsp_sched_live_delete(struct dsp_sched_live_t *live);
 
 bool dsp_sched_live_add(struct dsp_sched_live_t *live, const void *data);
 bool dsp_sched_live_remove(struct dsp_sched_live_t *live, void *data);
+unsigned int dsp_sched_live_drain(struct dsp_sched_live_t *live, void *data, unsigned int max);
 
 /* %~dsp.h% */
 
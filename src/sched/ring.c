@@ -6,7 +6,12 @@
  * local function declarations
  */
 
-static void refresh(struct dsp_sched_ring_t *sched);
+static struct dsp_sched_ring_buf_t *buf_new(init_f init, unsigned int len, unsigned int size);
+static void buf_copy(struct dsp_sched_ring_buf_t *dest, struct dsp_sched_ring_buf_t *src, uint64_t seq, uint64_t cnt);
+static void *buf_ref(struct dsp_sched_ring_buf_t *buf, uint64_t seq);
+
+static void publish(struct dsp_sched_ring_t *sched, bool keep);
+static void reclaim(struct dsp_sched_ring_t *sched);
 
 
 /**
@@ -22,14 +27,15 @@ struct dsp_sched_ring_t *dsp_sched_ring_new(init_f init, unsigned int len, unsig
 {
 	struct dsp_sched_ring_t *sched;
 
-	sched = mem_alloc(sizeof(struct dsp_sched_ring_t) + len * size);
+	sched = mem_alloc(sizeof(struct dsp_sched_ring_t));
 	sched->init = init;
 	sched->lock = thread_mutex_new(NULL);
-	sched->idx = 0;
 	sched->len = len;
 	sched->size = size;
-
-	refresh(sched);
+	sched->seq = 0;
+	sched->cur = buf_new(init, len, size);
+	sched->pend = NULL;
+	sched->retired = NULL;
 
 	return sched;
 }
@@ -42,58 +48,205 @@ struct dsp_sched_ring_t *dsp_sched_ring_new(init_f init, unsigned int len, unsig
 _export
 void dsp_sched_ring_delete(struct dsp_sched_ring_t *sched)
 {
+	struct dsp_sched_ring_buf_t *buf;
+
+	while((buf = sched->retired) != NULL) {
+		sched->retired = buf->next;
+		mem_free(buf);
+	}
+
+	mem_delete(sched->pend);
+	mem_free(sched->cur);
+	thread_mutex_delete(&sched->lock);
 	mem_free(sched);
 }
 
 
 /**
- * Resize the ring scheduler.
- *   @sched: The scheduler reference.
+ * Resize the ring scheduler. The new buffer is built and initialized on the
+ * calling thread; the reader switches to it on its next increment. Since
+ * the reference layout changes, no history is carried over.
+ *   @sched: The scheduler.
  *   @size: The new size.
  */
 
 _export
-void dsp_sched_ring_resize(struct dsp_sched_ring_t **sched, unsigned int size)
+void dsp_sched_ring_resize(struct dsp_sched_ring_t *sched, unsigned int size)
 {
-	thread_mutex_lock(&(*sched)->lock);
-
-	*sched = mem_realloc(*sched, sizeof(struct dsp_sched_ring_t) + (*sched)->len * size);
-	(*sched)->size = size;
+	thread_mutex_lock(&sched->lock);
 
-	refresh(*sched);
+	sched->size = size;
+	publish(sched, false);
 
-	thread_mutex_unlock(&(*sched)->lock);
+	thread_mutex_unlock(&sched->lock);
 }
 
 /**
- * Resize the length of the ring scheduler.
- *   @sched: The scheduler reference.
+ * Resize the length of the ring scheduler. The new buffer is built and
+ * initialized on the calling thread; the reader copies the most recent
+ * history into it as it switches over on its next increment, since only the
+ * reader may touch the references of the current buffer. At most
+ * 'DSP_SCHED_RING_CARRY' references are carried over, bounding the work
+ * done by the reader.
+ *   @sched: The scheduler.
  *   @len: The new length.
  */
 
 _export
-void dsp_sched_ring_relen(struct dsp_sched_ring_t **sched, unsigned int len)
+void dsp_sched_ring_relen(struct dsp_sched_ring_t *sched, unsigned int len)
+{
+	thread_mutex_lock(&sched->lock);
+
+	sched->len = len;
+	publish(sched, true);
+
+	thread_mutex_unlock(&sched->lock);
+}
+
+/**
+ * Adopt the pending buffer. Called by the reader from the increment, it
+ * copies the history if the buffer keeps it and retires the old buffer
+ * without blocking.
+ *   @sched: The scheduler.
+ */
+
+_export
+void dsp_sched_ring_adopt(struct dsp_sched_ring_t *sched)
 {
-	thread_mutex_lock(&(*sched)->lock);
+	struct dsp_sched_ring_buf_t *buf, *old = sched->cur;
 
-	*sched = mem_realloc(*sched, sizeof(struct dsp_sched_ring_t) + len * (*sched)->size);
-	(*sched)->len = len;
+	buf = __atomic_exchange_n(&sched->pend, NULL, __ATOMIC_ACQUIRE);
+	if(buf == NULL)
+		return;
 
-	refresh(*sched);
+	if(buf->retire != UINT64_MAX)
+		buf_copy(buf, old, sched->seq, (sched->seq < DSP_SCHED_RING_CARRY) ? (sched->seq + 1) : DSP_SCHED_RING_CARRY);
 
-	thread_mutex_unlock(&(*sched)->lock);
+	old->retire = sched->seq;
+	__atomic_store_n(&sched->cur, buf, __ATOMIC_RELEASE);
+
+	old->next = __atomic_load_n(&sched->retired, __ATOMIC_RELAXED);
+	while(!__atomic_compare_exchange_n(&sched->retired, &old->next, old, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
 }
 
 
 /**
- * Refresh the scheduler, initializing all reference.
- *   @sched: The scheduler.
+ * Create a new, initialized ring buffer.
+ *   @init: The initializer.
+ *   @len: The length.
+ *   @size: The size.
+ *   &returns: The buffer.
  */
 
-static void refresh(struct dsp_sched_ring_t *sched)
+static struct dsp_sched_ring_buf_t *buf_new(init_f init, unsigned int len, unsigned int size)
 {
 	unsigned int i;
+	struct dsp_sched_ring_buf_t *buf;
+
+	buf = mem_alloc(sizeof(struct dsp_sched_ring_buf_t) + len * size);
+	buf->next = NULL;
+	buf->retire = 0;
+	buf->len = len;
+	buf->size = size;
 
-	for(i = 0; i < sched->len; i++)
-		sched->init(dsp_sched_ring_idx(sched, i));
+	for(i = 0; i < len; i++)
+		init(buf->data + i * size);
+
+	return buf;
+}
+
+/**
+ * Copy the most recent references between buffers of the same size.
+ *   @dest: The destination buffer.
+ *   @src: The source buffer.
+ *   @seq: The sequence of the most recent reference.
+ *   @cnt: The number of references to copy, clamped to the history.
+ */
+
+static void buf_copy(struct dsp_sched_ring_buf_t *dest, struct dsp_sched_ring_buf_t *src, uint64_t seq, uint64_t cnt)
+{
+	uint64_t i;
+
+	if(cnt > dest->len)
+		cnt = dest->len;
+
+	if(cnt > src->len)
+		cnt = src->len;
+
+	for(i = 0; i < cnt; i++)
+		mem_copy(buf_ref(dest, seq - i), buf_ref(src, seq - i), src->size);
+}
+
+/**
+ * Retrieve a buffer reference by sequence.
+ *   @buf: The buffer.
+ *   @seq: The sequence.
+ *   &returns: The reference.
+ */
+
+static void *buf_ref(struct dsp_sched_ring_buf_t *buf, uint64_t seq)
+{
+	return buf->data + (seq % buf->len) * buf->size;
+}
+
+
+/**
+ * Build and publish a pending buffer with the requested length and size.
+ * Any earlier buffer the reader has not yet adopted is withdrawn first, so
+ * the current buffer stays put while the new one is built; if that buffer
+ * dropped the history, so does the new one. Called with the lock held.
+ *   @sched: The scheduler.
+ *   @keep: Carry the history over.
+ */
+
+static void publish(struct dsp_sched_ring_t *sched, bool keep)
+{
+	struct dsp_sched_ring_buf_t *buf;
+
+	reclaim(sched);
+
+	buf = __atomic_exchange_n(&sched->pend, NULL, __ATOMIC_ACQUIRE);
+	if(buf != NULL) {
+		keep &= (buf->retire != UINT64_MAX);
+		mem_free(buf);
+	}
+
+	buf = buf_new(sched->init, sched->len, sched->size);
+	buf->retire = keep ? 0 : UINT64_MAX;
+	__atomic_store_n(&sched->pend, buf, __ATOMIC_RELEASE);
+}
+
+/**
+ * Release retired buffers that the reader can no longer reference. A buffer
+ * is released once the reader has incremented past the period in which it
+ * was retired.
+ *   @sched: The scheduler.
+ */
+
+static void reclaim(struct dsp_sched_ring_t *sched)
+{
+	uint64_t seq;
+	struct dsp_sched_ring_buf_t *buf, *next, *keep = NULL;
+
+	buf = __atomic_exchange_n(&sched->retired, NULL, __ATOMIC_ACQUIRE);
+	seq = __atomic_load_n(&sched->seq, __ATOMIC_ACQUIRE);
+
+	for(; buf != NULL; buf = next) {
+		next = buf->next;
+
+		if(seq >= buf->retire + 2)
+			mem_free(buf);
+		else {
+			buf->next = keep;
+			keep = buf;
+		}
+	}
+
+	while(keep != NULL) {
+		buf = keep;
+		keep = buf->next;
+
+		buf->next = __atomic_load_n(&sched->retired, __ATOMIC_RELAXED);
+		while(!__atomic_compare_exchange_n(&sched->retired, &buf->next, buf, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	}
 }
@@ -7,20 +7,51 @@
 
 /* %dsp.h% */
 
+/*
+ * ring scheduler definitions
+ */
+
+#define DSP_SCHED_RING_CARRY 8
+
+
 /**
- * Ring scheduler.
- *   @init: The initializer.
- *   @lock: The lock.
- *   @idx, len, size: The index, length, and size.
+ * Ring scheduler buffer. The position of the most recent reference is
+ * always the scheduler sequence modulo the length, so a buffer of any
+ * length can take over from another at any sequence.
+ *   @next: The next retired buffer.
+ *   @retire: The sequence at which the buffer was retired or, while pending,
+ *     zero if the history is carried over, 'UINT64_MAX' if not.
+ *   @len, size: The length and size.
  *   @data: The data array.
  */
 
+struct dsp_sched_ring_buf_t {
+	struct dsp_sched_ring_buf_t *next;
+	uint64_t retire;
+
+	unsigned int len, size;
+	uint8_t data[];
+};
+
+/**
+ * Ring scheduler. Readers only touch the current buffer and sequence, and
+ * never block; resizing builds a pending buffer that the reader adopts on
+ * its next increment.
+ *   @init: The initializer.
+ *   @lock: The resize lock.
+ *   @len, size: The requested length and size, guarded by the lock.
+ *   @seq: The sequence, advanced by the reader.
+ *   @cur, pend: The current and pending buffers.
+ *   @retired: The retired buffers awaiting release.
+ */
+
 struct dsp_sched_ring_t {
 	init_f init;
 	struct thread_mutex_t lock;
+	unsigned int len, size;
 
-	unsigned int idx, len, size;
-	uint8_t data[];
+	uint64_t seq;
+	struct dsp_sched_ring_buf_t *cur, *pend, *retired;
 };
 
 
@@ -31,8 +62,9 @@ struct dsp_sched_ring_t {
 struct dsp_sched_ring_t *dsp_sched_ring_new(init_f init, unsigned int len, unsigned int size);
 void dsp_sched_ring_delete(struct dsp_sched_ring_t *sched);
 
-void dsp_sched_ring_resize(struct dsp_sched_ring_t **sched, unsigned int size);
-void dsp_sched_ring_relen(struct dsp_sched_ring_t **sched, unsigned int len);
+void dsp_sched_ring_resize(struct dsp_sched_ring_t *sched, unsigned int size);
+void dsp_sched_ring_relen(struct dsp_sched_ring_t *sched, unsigned int len);
+void dsp_sched_ring_adopt(struct dsp_sched_ring_t *sched);
 
 
 /**
@@ -44,7 +76,7 @@ void dsp_sched_ring_relen(struct dsp_sched_ring_t **sched, unsigned int len);
 
 static inline void *dsp_sched_ring_idx(struct dsp_sched_ring_t *sched, unsigned int idx)
 {
-	return sched->data + idx * sched->size;
+	return sched->cur->data + idx * sched->cur->size;
 }
 
 /**
@@ -55,19 +87,24 @@ static inline void *dsp_sched_ring_idx(struct dsp_sched_ring_t *sched, unsigned
 
 static inline void *dsp_sched_ring_get(struct dsp_sched_ring_t *sched, unsigned int idx)
 {
-	return dsp_sched_ring_idx(sched, dsp_mod(sched->idx - idx, sched->len));
+	unsigned int len = sched->cur->len;
+
+	return dsp_sched_ring_idx(sched, (sched->seq % len + len - idx % len) % len);
 }
 
 /**
- * Increment the ring scheduler.
+ * Increment the ring scheduler, first adopting any pending buffer.
  *   @sched: The scheduler.
  */
 
 static inline void *dsp_sched_ring_inc(struct dsp_sched_ring_t *sched)
 {
-	sched->idx = (sched->idx + 1) % sched->len;
+	if(__atomic_load_n(&sched->pend, __ATOMIC_ACQUIRE) != NULL)
+		dsp_sched_ring_adopt(sched);
+
+	__atomic_store_n(&sched->seq, sched->seq + 1, __ATOMIC_RELEASE);
 
-	return dsp_sched_ring_idx(sched, sched->idx);
+	return dsp_sched_ring_idx(sched, sched->seq % sched->cur->len);
 }
 
 /* %~dsp.h% */
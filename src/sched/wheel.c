@@ -0,0 +1,386 @@
+#include "../common.h"
+#include "wheel.h"
+#include "live.h"
+
+
+/*
+ * wheel definitions
+ */
+
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 8
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+
+/**
+ * Event node structure. The time and data are laid out contiguously so that
+ * posted events are copied directly out of the live queue.
+ *   @next: The next node.
+ *   @t: The absolute time in samples.
+ *   @data: The event data.
+ */
+
+struct wheel_node_t {
+	struct wheel_node_t *next;
+
+	uint64_t t;
+	uint8_t data[];
+};
+
+/**
+ * Wheel slot structure.
+ *   @head, tail: The head and tail nodes.
+ */
+
+struct wheel_slot_t {
+	struct wheel_node_t *head, *tail;
+};
+
+/**
+ * Timer wheel structure.
+ *   @now: The current time.
+ *   @size, stride: The event size and node stride.
+ *   @live: The posting queue.
+ *   @avail: The free node list.
+ *   @pool: The node pool.
+ *   @over: The overflow list for events beyond the top level.
+ *   @bits: The slot occupancy bitmaps.
+ *   @slot: The slots.
+ */
+
+struct dsp_sched_wheel_t {
+	uint64_t now;
+	unsigned int size, stride;
+
+	struct dsp_sched_live_t *live;
+	struct wheel_node_t *avail;
+	void *pool;
+
+	struct wheel_slot_t over;
+	uint64_t bits[WHEEL_LEVELS][WHEEL_SLOTS / 64];
+	struct wheel_slot_t slot[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void wheel_insert(struct dsp_sched_wheel_t *wheel, struct wheel_node_t *node);
+static void wheel_cascade(struct dsp_sched_wheel_t *wheel, unsigned int level);
+static void wheel_fire(struct dsp_sched_wheel_t *wheel, unsigned int idx, uint64_t base, dsp_sched_wheel_f func, void *arg);
+static uint64_t wheel_skip(struct dsp_sched_wheel_t *wheel);
+static unsigned int wheel_next(struct dsp_sched_wheel_t *wheel, unsigned int level, unsigned int idx);
+
+static void slot_push(struct wheel_slot_t *slot, struct wheel_node_t *node);
+
+
+/**
+ * Create a new timer wheel. Events live in a preallocated pool, so neither
+ * adding nor processing allocates memory.
+ *   @nevent: The maximum number of pending events.
+ *   @size: The event data size.
+ *   @queue: The posting queue length.
+ *   &returns: The timer wheel.
+ */
+
+_export
+struct dsp_sched_wheel_t *dsp_sched_wheel_new(unsigned int nevent, unsigned int size, unsigned int queue)
+{
+	unsigned int i;
+	struct wheel_node_t *node;
+	struct dsp_sched_wheel_t *wheel;
+
+	wheel = mem_alloc(sizeof(struct dsp_sched_wheel_t));
+	wheel->now = 0;
+	wheel->size = size;
+	wheel->stride = (sizeof(struct wheel_node_t) + size + 7) & ~7u;
+	wheel->live = dsp_sched_live_new(queue, sizeof(uint64_t) + size);
+	wheel->pool = mem_alloc(nevent * wheel->stride);
+	wheel->avail = NULL;
+	wheel->over = (struct wheel_slot_t){ NULL, NULL };
+
+	mem_set(wheel->bits, 0x00, sizeof(wheel->bits));
+	mem_set(wheel->slot, 0x00, sizeof(wheel->slot));
+
+	for(i = nevent; i-- > 0; ) {
+		node = wheel->pool + i * wheel->stride;
+		node->next = wheel->avail;
+		wheel->avail = node;
+	}
+
+	return wheel;
+}
+
+/**
+ * Delete a timer wheel.
+ *   @wheel: The timer wheel.
+ */
+
+_export
+void dsp_sched_wheel_delete(struct dsp_sched_wheel_t *wheel)
+{
+	dsp_sched_live_delete(wheel->live);
+	mem_free(wheel->pool);
+	mem_free(wheel);
+}
+
+
+/**
+ * Post an event to the timer wheel from any thread. The event is inserted
+ * by the next call to process.
+ *   @wheel: The timer wheel.
+ *   @t: The absolute time in samples.
+ *   @data: The event data.
+ *   &returns: True if posted, false if the posting queue is full.
+ */
+
+_export
+bool dsp_sched_wheel_post(struct dsp_sched_wheel_t *wheel, uint64_t t, const void *data)
+{
+	uint8_t buf[sizeof(uint64_t) + wheel->size];
+
+	mem_copy(buf, &t, sizeof(uint64_t));
+	mem_copy(buf + sizeof(uint64_t), data, wheel->size);
+
+	return dsp_sched_live_add(wheel->live, buf);
+}
+
+/**
+ * Add an event directly to the timer wheel. Only the processing thread may
+ * add events. Events in the past are delivered at the start of the next
+ * processed block.
+ *   @wheel: The timer wheel.
+ *   @t: The absolute time in samples.
+ *   @data: The event data.
+ *   &returns: True if added, false if the pool is exhausted.
+ */
+
+_export
+bool dsp_sched_wheel_add(struct dsp_sched_wheel_t *wheel, uint64_t t, const void *data)
+{
+	struct wheel_node_t *node = wheel->avail;
+
+	if(node == NULL)
+		return false;
+
+	wheel->avail = node->next;
+	node->t = t;
+	mem_copy(node->data, data, wheel->size);
+	wheel_insert(wheel, node);
+
+	return true;
+}
+
+
+/**
+ * Process all events due before the end of a block, in time order. Posted
+ * events are inserted first, and events that are already late are
+ * delivered at offset zero. The cost is proportional to the number of
+ * events due, independent of the block length.
+ *   @wheel: The timer wheel.
+ *   @t: The block start time.
+ *   @len: The block length.
+ *   @func: The callback function.
+ *   @arg: The callback argument.
+ */
+
+_export
+void dsp_sched_wheel_proc(struct dsp_sched_wheel_t *wheel, uint64_t t, unsigned int len, dsp_sched_wheel_f func, void *arg)
+{
+	unsigned int idx;
+	uint64_t next, end = t + len;
+	struct wheel_node_t *node;
+
+	while((node = wheel->avail) != NULL) {
+		if(!dsp_sched_live_remove(wheel->live, &node->t))
+			break;
+
+		wheel->avail = node->next;
+		wheel_insert(wheel, node);
+	}
+
+	while(wheel->now < end) {
+		idx = wheel_next(wheel, 0, wheel->now & WHEEL_MASK);
+
+		if((idx < WHEEL_SLOTS) && ((wheel->now & ~(uint64_t)WHEEL_MASK) + idx < end)) {
+			wheel->now = (wheel->now & ~(uint64_t)WHEEL_MASK) + idx;
+			wheel_fire(wheel, idx, t, func, arg);
+			wheel->now++;
+		}
+		else if((next = wheel_skip(wheel)) <= end)
+			wheel->now = next;
+		else {
+			wheel->now = end;
+			break;
+		}
+
+		if((wheel->now & WHEEL_MASK) == 0)
+			wheel_cascade(wheel, 1);
+	}
+}
+
+
+/**
+ * Insert a node into the wheel, at the lowest level whose span contains
+ * both the current time and the event time.
+ *   @wheel: The timer wheel.
+ *   @node: The node.
+ */
+
+static void wheel_insert(struct dsp_sched_wheel_t *wheel, struct wheel_node_t *node)
+{
+	unsigned int level, idx;
+	uint64_t t = (node->t < wheel->now) ? wheel->now : node->t;
+
+	for(level = 0; level < WHEEL_LEVELS; level++) {
+		if((t >> (WHEEL_BITS * (level + 1))) == (wheel->now >> (WHEEL_BITS * (level + 1))))
+			break;
+	}
+
+	if(level == WHEEL_LEVELS) {
+		slot_push(&wheel->over, node);
+		return;
+	}
+
+	idx = (t >> (WHEEL_BITS * level)) & WHEEL_MASK;
+	slot_push(&wheel->slot[level][idx], node);
+	wheel->bits[level][idx / 64] |= (uint64_t)1 << (idx % 64);
+}
+
+/**
+ * Cascade events from a level into the levels below after the current time
+ * has crossed a boundary of that level. Higher levels are cascaded first
+ * when their boundaries coincide.
+ *   @wheel: The timer wheel.
+ *   @level: The level.
+ */
+
+static void wheel_cascade(struct dsp_sched_wheel_t *wheel, unsigned int level)
+{
+	unsigned int idx;
+	struct wheel_node_t *node, *next;
+	struct wheel_slot_t *slot;
+
+	if(level == WHEEL_LEVELS)
+		slot = &wheel->over;
+	else {
+		if(((wheel->now >> (WHEEL_BITS * level)) & WHEEL_MASK) == 0)
+			wheel_cascade(wheel, level + 1);
+
+		idx = (wheel->now >> (WHEEL_BITS * level)) & WHEEL_MASK;
+		if((wheel->bits[level][idx / 64] & ((uint64_t)1 << (idx % 64))) == 0)
+			return;
+
+		wheel->bits[level][idx / 64] &= ~((uint64_t)1 << (idx % 64));
+		slot = &wheel->slot[level][idx];
+	}
+
+	node = slot->head;
+	*slot = (struct wheel_slot_t){ NULL, NULL };
+
+	for(; node != NULL; node = next) {
+		next = node->next;
+		wheel_insert(wheel, node);
+	}
+}
+
+/**
+ * Fire all events in a bottom level slot and return their nodes to the
+ * pool.
+ *   @wheel: The timer wheel.
+ *   @idx: The slot index.
+ *   @base: The block start time.
+ *   @func: The callback function.
+ *   @arg: The callback argument.
+ */
+
+static void wheel_fire(struct dsp_sched_wheel_t *wheel, unsigned int idx, uint64_t base, dsp_sched_wheel_f func, void *arg)
+{
+	struct wheel_node_t *node, *next;
+	struct wheel_slot_t *slot = &wheel->slot[0][idx];
+	unsigned int off = (wheel->now > base) ? (wheel->now - base) : 0;
+
+	node = slot->head;
+	*slot = (struct wheel_slot_t){ NULL, NULL };
+	wheel->bits[0][idx / 64] &= ~((uint64_t)1 << (idx % 64));
+
+	for(; node != NULL; node = next) {
+		next = node->next;
+		func(off, node->data, arg);
+
+		node->next = wheel->avail;
+		wheel->avail = node;
+	}
+}
+
+/**
+ * Find the next time at which an upper level slot must be cascaded, once
+ * the bottom level has been exhausted. Empty slots are skipped entirely, so
+ * idle stretches cost a handful of bitmap scans.
+ *   @wheel: The timer wheel.
+ *   &returns: The time of the next cascade, always on a bottom boundary.
+ */
+
+static uint64_t wheel_skip(struct dsp_sched_wheel_t *wheel)
+{
+	unsigned int level, idx, shift;
+
+	for(level = 1; level < WHEEL_LEVELS; level++) {
+		shift = WHEEL_BITS * level;
+		idx = (wheel->now >> shift) & WHEEL_MASK;
+
+		if(idx + 1 < WHEEL_SLOTS) {
+			idx = wheel_next(wheel, level, idx + 1);
+			if(idx < WHEEL_SLOTS)
+				return ((wheel->now >> (shift + WHEEL_BITS)) << (shift + WHEEL_BITS)) + ((uint64_t)idx << shift);
+		}
+	}
+
+	return ((wheel->now >> (WHEEL_BITS * WHEEL_LEVELS)) + 1) << (WHEEL_BITS * WHEEL_LEVELS);
+}
+
+/**
+ * Find the next occupied slot on a level.
+ *   @wheel: The timer wheel.
+ *   @level: The level.
+ *   @idx: The starting slot index.
+ *   &returns: The slot index, or 'WHEEL_SLOTS' if none.
+ */
+
+static unsigned int wheel_next(struct dsp_sched_wheel_t *wheel, unsigned int level, unsigned int idx)
+{
+	uint64_t word;
+	unsigned int i = idx / 64;
+
+	word = wheel->bits[level][i] & (~(uint64_t)0 << (idx % 64));
+
+	while(word == 0) {
+		if(++i == WHEEL_SLOTS / 64)
+			return WHEEL_SLOTS;
+
+		word = wheel->bits[level][i];
+	}
+
+	return 64 * i + __builtin_ctzll(word);
+}
+
+
+/**
+ * Append a node to a slot.
+ *   @slot: The slot.
+ *   @node: The node.
+ */
+
+static void slot_push(struct wheel_slot_t *slot, struct wheel_node_t *node)
+{
+	node->next = NULL;
+
+	if(slot->tail == NULL)
+		slot->head = node;
+	else
+		slot->tail->next = node;
+
+	slot->tail = node;
+}
@@ -0,0 +1,44 @@
+#ifndef SCHED_WHEEL_H
+#define SCHED_WHEEL_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/**
+ * Timed event callback.
+ *   @off: The offset of the event within the block.
+ *   @data: The event data.
+ *   @arg: The callback argument.
+ */
+
+typedef void (*dsp_sched_wheel_f)(unsigned int off, void *data, void *arg);
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_sched_wheel_t;
+
+/*
+ * timer wheel function declarations
+ */
+
+struct dsp_sched_wheel_t *dsp_sched_wheel_new(unsigned int nevent, unsigned int size, unsigned int queue);
+void dsp_sched_wheel_delete(struct dsp_sched_wheel_t *wheel);
+
+bool dsp_sched_wheel_post(struct dsp_sched_wheel_t *wheel, uint64_t t, const void *data);
+bool dsp_sched_wheel_add(struct dsp_sched_wheel_t *wheel, uint64_t t, const void *data);
+
+void dsp_sched_wheel_proc(struct dsp_sched_wheel_t *wheel, uint64_t t, unsigned int len, dsp_sched_wheel_f func, void *arg);
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/**
+ * Vector of four doubles. The compiler lowers operations on the vector to
+ * whichever instruction set is enabled, falling back to pairs of SSE2 or
+ * scalar operations when AVX is not available. Vectors are only passed by
+ * reference so that the calling convention does not depend on AVX.
+ */
+
+typedef double dsp_vec_t __attribute__((vector_size(4 * sizeof(double))));
+
+/**
+ * Native vector, as wide as the enabled instruction set: four doubles with
+ * AVX and two otherwise. Code whose data flows between lanes, and so cannot
+ * be split into independent halves, uses it to avoid the shuffles that the
+ * lowered 'dsp_vec_t' would need. Its width depends on compiler flags, so
+ * layouts built on it must stay private to the library.
+ */
+
+#ifdef __AVX__
+#	define DSP_NVEC_LEN 4
+#else
+#	define DSP_NVEC_LEN 2
+#endif
+
+typedef double dsp_nvec_t __attribute__((vector_size(DSP_NVEC_LEN * sizeof(double))));
+typedef long long dsp_nmask_t __attribute__((vector_size(DSP_NVEC_LEN * sizeof(long long))));
+
+
+/**
+ * Load a vector from unaligned memory.
+ *   @v: The vector.
+ *   @ptr: The pointer.
+ */
+
+static inline void dsp_vec_load(dsp_vec_t *v, const double *ptr)
+{
+	__builtin_memcpy(v, ptr, sizeof(dsp_vec_t));
+}
+
+/**
+ * Store a vector to unaligned memory.
+ *   @ptr: The pointer.
+ *   @v: The vector.
+ */
+
+static inline void dsp_vec_store(double *ptr, const dsp_vec_t *v)
+{
+	__builtin_memcpy(ptr, v, sizeof(dsp_vec_t));
+}
+
+/**
+ * Sum the lanes of a vector.
+ *   @v: The vector.
+ *   &returns: The sum.
+ */
+
+static inline double dsp_vec_sum(const dsp_vec_t *v)
+{
+	return ((*v)[0] + (*v)[2]) + ((*v)[1] + (*v)[3]);
+}
+
+/**
+ * Load a native vector from unaligned memory.
+ *   @v: The vector.
+ *   @ptr: The pointer.
+ */
+
+static inline void dsp_nvec_load(dsp_nvec_t *v, const double *ptr)
+{
+	__builtin_memcpy(v, ptr, sizeof(dsp_nvec_t));
+}
+
+/**
+ * Store a native vector to unaligned memory.
+ *   @ptr: The pointer.
+ *   @v: The vector.
+ */
+
+static inline void dsp_nvec_store(double *ptr, const dsp_nvec_t *v)
+{
+	__builtin_memcpy(ptr, v, sizeof(dsp_nvec_t));
+}
+
+/**
+ * Gather a native vector from one element of several arrays.
+ *   @v: The vector.
+ *   @ptr: The arrays, one per lane.
+ *   @idx: The element index.
+ */
+
+static inline void dsp_nvec_gather(dsp_nvec_t *v, double *const *ptr, unsigned int idx)
+{
+#if DSP_NVEC_LEN == 4
+	*v = (dsp_nvec_t){ ptr[0][idx], ptr[1][idx], ptr[2][idx], ptr[3][idx] };
+#else
+	*v = (dsp_nvec_t){ ptr[0][idx], ptr[1][idx] };
+#endif
+}
+
+/**
+ * Scatter a native vector to one element of several arrays. Lanes are
+ * written from last to first, so when arrays alias the lowest lane wins.
+ *   @ptr: The arrays, one per lane.
+ *   @idx: The element index.
+ *   @v: The vector.
+ */
+
+static inline void dsp_nvec_scatter(double *const *ptr, unsigned int idx, const dsp_nvec_t *v)
+{
+#if DSP_NVEC_LEN == 4
+	ptr[3][idx] = (*v)[3];
+	ptr[2][idx] = (*v)[2];
+#endif
+	ptr[1][idx] = (*v)[1];
+	ptr[0][idx] = (*v)[0];
+}
+
+/**
+ * Shift a native vector up by one lane, inserting a value in the first lane.
+ *   @v: The vector.
+ *   @x: The value.
+ */
+
+static inline void dsp_nvec_shift(dsp_nvec_t *v, double x)
+{
+#if DSP_NVEC_LEN == 4
+	*v = __builtin_shuffle(*v, (dsp_nvec_t){ x, x, x, x }, (dsp_nmask_t){ 4, 0, 1, 2 });
+#else
+	*v = __builtin_shuffle(*v, (dsp_nvec_t){ x, x }, (dsp_nmask_t){ 2, 0 });
+#endif
+}
+
+/**
+ * Compute the inner product of two arrays.
+ *   @a: The first array.
+ *   @b: The second array.
+ *   @len: The length.
+ *   &returns: The inner product.
+ */
+
+static inline double dsp_vec_dot(const double *restrict a, const double *restrict b, unsigned int len)
+{
+	unsigned int i;
+	double sum;
+	dsp_vec_t x0, x1, y0, y1, s0 = { 0.0, 0.0, 0.0, 0.0 }, s1 = { 0.0, 0.0, 0.0, 0.0 };
+
+	for(i = 0; i + 8 <= len; i += 8) {
+		dsp_vec_load(&x0, a + i);
+		dsp_vec_load(&y0, b + i);
+		dsp_vec_load(&x1, a + i + 4);
+		dsp_vec_load(&y1, b + i + 4);
+		s0 += x0 * y0;
+		s1 += x1 * y1;
+	}
+
+	if(i + 4 <= len) {
+		dsp_vec_load(&x0, a + i);
+		dsp_vec_load(&y0, b + i);
+		s0 += x0 * y0;
+		i += 4;
+	}
+
+	s0 += s1;
+	for(sum = dsp_vec_sum(&s0); i < len; i++)
+		sum += a[i] * b[i];
+
+	return sum;
+}
+
+/**
+ * Add a scaled array to another array.
+ *   @y: The destination array.
+ *   @x: The source array.
+ *   @a: The scale.
+ *   @len: The length.
+ */
+
+static inline void dsp_vec_axpy(double *restrict y, const double *restrict x, double a, unsigned int len)
+{
+	unsigned int i;
+	dsp_vec_t u, v, s = { a, a, a, a };
+
+	for(i = 0; i + 4 <= len; i += 4) {
+		dsp_vec_load(&u, x + i);
+		dsp_vec_load(&v, y + i);
+		v += s * u;
+		dsp_vec_store(y + i, &v);
+	}
+
+	for(; i < len; i++)
+		y[i] += a * x[i];
+}
+
+#endif
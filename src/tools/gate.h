@@ -87,6 +87,27 @@ static inline double dsp_gate_proc(double x, struct dsp_gate_t gate, struct dsp_
 	return data->level;
 }
 
+/**
+ * Process a gate over a block, writing the level for each sample. The input
+ * and output may be the same buffer.
+ *   @x: The input.
+ *   @y: The output levels.
+ *   @len: The length.
+ *   @gate: The gate.
+ *   @data: The gate data.
+ */
+
+static inline void dsp_gate_block(const double *x, double *y, unsigned int len, struct dsp_gate_t gate, struct dsp_gate_data_t *data)
+{
+	unsigned int i;
+	struct dsp_gate_data_t d = *data;
+
+	for(i = 0; i < len; i++)
+		y[i] = dsp_gate_proc(x[i], gate, &d);
+
+	*data = d;
+}
+
 /*
  * gate function declarations
  */
@@ -0,0 +1,462 @@
+#include "../common.h"
+#include "carray.h"
+#include "lock.h"
+#include "sync.h"
+
+
+/**
+ * Hashed index structure.
+ *   @cap, cnt: The table capacity, always a power of two, and entry count.
+ *   @slot: The slots, each an element index or 'UINT_MAX' if empty.
+ */
+
+struct dsp_carray_idx_t {
+	unsigned int cap, cnt;
+	unsigned int *slot;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void sync_commit(void *arg);
+
+static struct dsp_carray_chunk_t *chunk_new(unsigned int nbytes);
+static void chunk_release(struct dsp_carray_chunk_t *chunk);
+static void ver_release(struct dsp_carray_ver_t *ver);
+
+static void *elem_get(struct dsp_carray_t *arr, unsigned int n);
+static void *elem_mut(struct dsp_carray_t *arr, unsigned int n);
+static unsigned int elem_find(struct dsp_carray_t *arr, const void *ptr);
+
+static uint64_t idx_hash(const void *ptr, unsigned int nbytes);
+static unsigned int idx_probe(struct dsp_carray_t *arr, const void *ptr, unsigned int n);
+static void idx_insert(struct dsp_carray_t *arr, unsigned int n);
+static void idx_erase(struct dsp_carray_t *arr, unsigned int pos);
+static void idx_grow(struct dsp_carray_t *arr);
+
+
+/**
+ * Create an empty chunked array.
+ *   @nbytes: Width of each data element.
+ *   @index: Maintain a hashed index for constant time removal.
+ *   &returns: The chunked array.
+ */
+
+_export
+struct dsp_carray_t dsp_carray_empty(unsigned int nbytes, bool index)
+{
+	struct dsp_carray_t arr;
+
+	arr.lock = dsp_lock_gen();
+	arr.nbytes = nbytes;
+	arr.ver[0] = arr.ver[1] = (struct dsp_carray_ver_t){ 0, 0, NULL };
+	arr.idx = NULL;
+
+	if(index) {
+		arr.idx = mem_alloc(sizeof(struct dsp_carray_idx_t));
+		arr.idx->cap = 16;
+		arr.idx->cnt = 0;
+		arr.idx->slot = mem_alloc(16 * sizeof(unsigned int));
+		mem_set(arr.idx->slot, 0xff, 16 * sizeof(unsigned int));
+	}
+
+	return arr;
+}
+
+/**
+ * Destroy a chunked array.
+ *   @arr: The chunked array.
+ */
+
+_export
+void dsp_carray_destroy(struct dsp_carray_t *arr)
+{
+	ver_release(&arr->ver[0]);
+	ver_release(&arr->ver[1]);
+	mem_delete(arr->ver[0].dir);
+	mem_delete(arr->ver[1].dir);
+
+	if(arr->idx != NULL) {
+		mem_free(arr->idx->slot);
+		mem_free(arr->idx);
+	}
+
+	dsp_lock_destroy(&arr->lock);
+}
+
+
+/**
+ * Add to a chunked array. The directory grows geometrically and only the
+ * last chunk is written.
+ *   @arr: The chunked array.
+ *   @ptr: The data pointer.
+ *   @sync: The synchronization structure.
+ */
+
+_export
+void dsp_carray_add(struct dsp_carray_t *arr, const void *restrict ptr, struct dsp_sync_t *sync)
+{
+	if(sync == NULL) {
+		struct dsp_sync_t sync;
+
+		sync = dsp_sync_empty();
+		dsp_carray_add(arr, ptr, &sync);
+		dsp_sync_commit(&sync);
+	}
+	else {
+		struct dsp_carray_ver_t *ver = &arr->ver[0];
+
+		if(dsp_sync_add(sync, arr, sync_commit))
+			dsp_lock_wrlock(&arr->lock);
+
+		if((ver->len & (DSP_CARRAY_CHUNK - 1)) == 0) {
+			if((ver->len >> DSP_CARRAY_SHIFT) == ver->cap) {
+				ver->cap = ver->cap ? (2 * ver->cap) : 4;
+				ver->dir = mem_realloc(ver->dir, ver->cap * sizeof(void *));
+			}
+
+			ver->dir[ver->len >> DSP_CARRAY_SHIFT] = chunk_new(arr->nbytes);
+		}
+
+		mem_copy(elem_mut(arr, ver->len), ptr, arr->nbytes);
+		ver->len++;
+
+		if(arr->idx != NULL)
+			idx_insert(arr, ver->len - 1);
+	}
+}
+
+/**
+ * Add a pointer to the chunked array.
+ *   @arr: The chunked array
+ *   @ptr: The pointer.
+ *   @sync: The synchronization structure.
+ */
+
+_export
+void dsp_carray_addptr(struct dsp_carray_t *arr, void *ptr, struct dsp_sync_t *sync)
+{
+	dsp_carray_add(arr, &ptr, sync);
+}
+
+/**
+ * Remove from a chunked array. The last element is moved into the removed
+ * slot, so at most two chunks are written.
+ *   @arr: The chunked array.
+ *   @ptr: The data pointer.
+ *   @sync: The synchronization structure.
+ *   &returns: True if removed, false if not found.
+ */
+
+_export
+bool dsp_carray_rem(struct dsp_carray_t *arr, const void *restrict ptr, struct dsp_sync_t *sync)
+{
+	if(sync == NULL) {
+		bool res;
+		struct dsp_sync_t sync;
+
+		sync = dsp_sync_empty();
+		res = dsp_carray_rem(arr, ptr, &sync);
+		dsp_sync_commit(&sync);
+
+		return res;
+	}
+	else {
+		unsigned int n, last;
+		struct dsp_carray_ver_t *ver = &arr->ver[0];
+
+		if(dsp_sync_add(sync, arr, sync_commit))
+			dsp_lock_wrlock(&arr->lock);
+
+		n = elem_find(arr, ptr);
+		if(n == UINT_MAX)
+			return false;
+
+		last = ver->len - 1;
+
+		if(arr->idx != NULL) {
+			idx_erase(arr, idx_probe(arr, elem_get(arr, n), n));
+			if(n != last)
+				arr->idx->slot[idx_probe(arr, elem_get(arr, last), last)] = n;
+		}
+
+		if(n != last)
+			mem_copy(elem_mut(arr, n), elem_get(arr, last), arr->nbytes);
+
+		ver->len--;
+
+		if((ver->len & (DSP_CARRAY_CHUNK - 1)) == 0)
+			chunk_release(ver->dir[ver->len >> DSP_CARRAY_SHIFT]);
+
+		return true;
+	}
+}
+
+/**
+ * Remove a pointer from the chunked array.
+ *   @arr: The chunked array
+ *   @ptr: The pointer.
+ *   @sync: The synchronization structure.
+ */
+
+_export
+void dsp_carray_remptr(struct dsp_carray_t *arr, void *ptr, struct dsp_sync_t *sync)
+{
+	dsp_carray_rem(arr, &ptr, sync);
+}
+
+
+/**
+ * Commit the chunked array for synchronizations. Only the directory is
+ * copied; chunks are shared by reference.
+ *   @arg: The argument.
+ */
+
+static void sync_commit(void *arg)
+{
+	unsigned int i, n;
+	struct dsp_carray_t *arr = arg;
+	struct dsp_carray_ver_t *src = &arr->ver[0], *dest = &arr->ver[1];
+
+	dsp_lock_wrswap(&arr->lock);
+
+	ver_release(dest);
+
+	if(dest->cap < src->cap) {
+		dest->cap = src->cap;
+		dest->dir = mem_realloc(dest->dir, dest->cap * sizeof(void *));
+	}
+
+	n = (src->len + DSP_CARRAY_CHUNK - 1) >> DSP_CARRAY_SHIFT;
+	for(i = 0; i < n; i++) {
+		dest->dir[i] = src->dir[i];
+		dest->dir[i]->ref++;
+	}
+
+	dest->len = src->len;
+
+	dsp_lock_wrunlock(&arr->lock);
+}
+
+
+/**
+ * Create a chunk.
+ *   @nbytes: The element size.
+ *   &returns: The chunk.
+ */
+
+static struct dsp_carray_chunk_t *chunk_new(unsigned int nbytes)
+{
+	struct dsp_carray_chunk_t *chunk;
+
+	chunk = mem_alloc(sizeof(struct dsp_carray_chunk_t) + DSP_CARRAY_CHUNK * nbytes);
+	chunk->ref = 1;
+
+	return chunk;
+}
+
+/**
+ * Release a chunk reference.
+ *   @chunk: The chunk.
+ */
+
+static void chunk_release(struct dsp_carray_chunk_t *chunk)
+{
+	if(--chunk->ref == 0)
+		mem_free(chunk);
+}
+
+/**
+ * Release all chunks referenced by a version.
+ *   @ver: The version.
+ */
+
+static void ver_release(struct dsp_carray_ver_t *ver)
+{
+	unsigned int i, n;
+
+	n = (ver->len + DSP_CARRAY_CHUNK - 1) >> DSP_CARRAY_SHIFT;
+	for(i = 0; i < n; i++)
+		chunk_release(ver->dir[i]);
+
+	ver->len = 0;
+}
+
+
+/**
+ * Retrieve an element of the writer version.
+ *   @arr: The chunked array.
+ *   @n: The element index.
+ *   &returns: The element pointer.
+ */
+
+static void *elem_get(struct dsp_carray_t *arr, unsigned int n)
+{
+	return arr->ver[0].dir[n >> DSP_CARRAY_SHIFT]->data + (n & (DSP_CARRAY_CHUNK - 1)) * arr->nbytes;
+}
+
+/**
+ * Retrieve a writable element of the writer version, copying its chunk if
+ * shared with the reader version.
+ *   @arr: The chunked array.
+ *   @n: The element index.
+ *   &returns: The element pointer.
+ */
+
+static void *elem_mut(struct dsp_carray_t *arr, unsigned int n)
+{
+	struct dsp_carray_chunk_t **chunk = &arr->ver[0].dir[n >> DSP_CARRAY_SHIFT];
+
+	if((*chunk)->ref > 1) {
+		(*chunk)->ref--;
+		*chunk = mem_dup(*chunk, sizeof(struct dsp_carray_chunk_t) + DSP_CARRAY_CHUNK * arr->nbytes);
+		(*chunk)->ref = 1;
+	}
+
+	return elem_get(arr, n);
+}
+
+/**
+ * Find an element in the writer version.
+ *   @arr: The chunked array.
+ *   @ptr: The data pointer.
+ *   &returns: The element index, or 'UINT_MAX' if not found.
+ */
+
+static unsigned int elem_find(struct dsp_carray_t *arr, const void *ptr)
+{
+	unsigned int n, pos;
+
+	if(arr->idx != NULL) {
+		pos = idx_probe(arr, ptr, UINT_MAX);
+
+		return (pos == UINT_MAX) ? UINT_MAX : arr->idx->slot[pos];
+	}
+
+	for(n = 0; n < arr->ver[0].len; n++) {
+		if(mem_isequal(elem_get(arr, n), ptr, arr->nbytes))
+			return n;
+	}
+
+	return UINT_MAX;
+}
+
+
+/**
+ * Hash an element.
+ *   @ptr: The element pointer.
+ *   @nbytes: The element size.
+ *   &returns: The hash.
+ */
+
+static uint64_t idx_hash(const void *ptr, unsigned int nbytes)
+{
+	unsigned int i;
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for(i = 0; i < nbytes; i++)
+		hash = (hash ^ ((const uint8_t *)ptr)[i]) * 0x100000001b3ull;
+
+	return hash ^ (hash >> 32);
+}
+
+/**
+ * Probe the index for an element.
+ *   @arr: The chunked array.
+ *   @ptr: The element data.
+ *   @n: The element index to match, or 'UINT_MAX' to match any equal
+ *     element.
+ *   &returns: The slot position, or 'UINT_MAX' if not found.
+ */
+
+static unsigned int idx_probe(struct dsp_carray_t *arr, const void *ptr, unsigned int n)
+{
+	unsigned int pos, val, mask = arr->idx->cap - 1;
+
+	for(pos = idx_hash(ptr, arr->nbytes) & mask; (val = arr->idx->slot[pos]) != UINT_MAX; pos = (pos + 1) & mask) {
+		if(n == UINT_MAX) {
+			if(mem_isequal(elem_get(arr, val), ptr, arr->nbytes))
+				return pos;
+		}
+		else if(val == n)
+			return pos;
+	}
+
+	return UINT_MAX;
+}
+
+/**
+ * Insert an element into the index.
+ *   @arr: The chunked array.
+ *   @n: The element index.
+ */
+
+static void idx_insert(struct dsp_carray_t *arr, unsigned int n)
+{
+	unsigned int pos, mask;
+
+	if(2 * (arr->idx->cnt + 1) > arr->idx->cap)
+		idx_grow(arr);
+
+	mask = arr->idx->cap - 1;
+	for(pos = idx_hash(elem_get(arr, n), arr->nbytes) & mask; arr->idx->slot[pos] != UINT_MAX; pos = (pos + 1) & mask);
+
+	arr->idx->slot[pos] = n;
+	arr->idx->cnt++;
+}
+
+/**
+ * Erase a slot from the index, shifting back any displaced entries so that
+ * no tombstones are needed.
+ *   @arr: The chunked array.
+ *   @pos: The slot position.
+ */
+
+static void idx_erase(struct dsp_carray_t *arr, unsigned int pos)
+{
+	unsigned int i = pos, j = pos, k, mask = arr->idx->cap - 1;
+	unsigned int *slot = arr->idx->slot;
+
+	while(true) {
+		j = (j + 1) & mask;
+		if(slot[j] == UINT_MAX)
+			break;
+
+		k = idx_hash(elem_get(arr, slot[j]), arr->nbytes) & mask;
+		if((j > i) ? ((k <= i) || (k > j)) : ((k <= i) && (k > j))) {
+			slot[i] = slot[j];
+			i = j;
+		}
+	}
+
+	slot[i] = UINT_MAX;
+	arr->idx->cnt--;
+}
+
+/**
+ * Double the index capacity and rehash all entries.
+ *   @arr: The chunked array.
+ */
+
+static void idx_grow(struct dsp_carray_t *arr)
+{
+	unsigned int i, cnt = arr->idx->cnt;
+	unsigned int *slot = arr->idx->slot, cap = arr->idx->cap;
+
+	arr->idx->cap = 2 * cap;
+	arr->idx->cnt = 0;
+	arr->idx->slot = mem_alloc(2 * cap * sizeof(unsigned int));
+	mem_set(arr->idx->slot, 0xff, 2 * cap * sizeof(unsigned int));
+
+	for(i = 0; i < cap; i++) {
+		if(slot[i] != UINT_MAX)
+			idx_insert(arr, slot[i]);
+	}
+
+	mem_free(slot);
+
+	if(arr->idx->cnt != cnt)
+		throw("Corrupt chunked array index.");
+}
@@ -0,0 +1,137 @@
+#ifndef CARRAY_H
+#define CARRAY_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * chunked array definitions
+ */
+
+#define DSP_CARRAY_SHIFT 6
+#define DSP_CARRAY_CHUNK (1 << DSP_CARRAY_SHIFT)
+
+
+/*
+ * structure prototypes
+ */
+
+struct dsp_sync_t;
+struct dsp_carray_idx_t;
+
+/**
+ * Chunked array chunk, shared between versions.
+ *   @ref: The reference count.
+ *   @data: The data, 'DSP_CARRAY_CHUNK' elements, aligned for any type.
+ */
+
+struct dsp_carray_chunk_t {
+	unsigned int ref;
+	_Alignas(max_align_t) uint8_t data[];
+};
+
+/**
+ * Chunked array version.
+ *   @len, cap: The length in elements and the directory capacity.
+ *   @dir: The chunk directory.
+ */
+
+struct dsp_carray_ver_t {
+	unsigned int len, cap;
+	struct dsp_carray_chunk_t **dir;
+};
+
+/**
+ * Chunked array structure. Versions share unmodified chunks, so a commit
+ * copies the chunk directory and only the chunks written since the last
+ * commit. Removal moves the last element into the removed slot, so the
+ * order of elements is not preserved.
+ *   @lock: Data lock.
+ *   @nbytes: Size of each data element.
+ *   @ver: The versions.
+ *   @idx: Optional. The hashed index of the writer version.
+ */
+
+struct dsp_carray_t {
+	struct dsp_lock_t lock;
+	unsigned int nbytes;
+
+	struct dsp_carray_ver_t ver[2];
+	struct dsp_carray_idx_t *idx;
+};
+
+
+/*
+ * chunked array function declarations
+ */
+
+struct dsp_carray_t dsp_carray_empty(unsigned int nbytes, bool index);
+void dsp_carray_destroy(struct dsp_carray_t *arr);
+
+void dsp_carray_add(struct dsp_carray_t *arr, const void *restrict ptr, struct dsp_sync_t *sync);
+void dsp_carray_addptr(struct dsp_carray_t *arr, void *ptr, struct dsp_sync_t *sync);
+bool dsp_carray_rem(struct dsp_carray_t *arr, const void *restrict ptr, struct dsp_sync_t *sync);
+void dsp_carray_remptr(struct dsp_carray_t *arr, void *ptr, struct dsp_sync_t *sync);
+
+
+/*
+ * external function declarations
+ */
+
+uint8_t dsp_lock_rdlock(struct dsp_lock_t *lock);
+void dsp_lock_rdunlock(struct dsp_lock_t *lock, uint8_t idx);
+
+
+/**
+ * Lock the chunked array for reading.
+ *   @arr: The chunked array.
+ *   @len: Optional. A reference to store the data length.
+ *   &returns: The locked selector.
+ */
+
+static inline uint8_t dsp_carray_lock(struct dsp_carray_t *arr, unsigned int *len)
+{
+	uint8_t sel;
+
+	sel = dsp_lock_rdlock(&arr->lock);
+
+	if(len != NULL)
+		*len = arr->ver[sel].len;
+
+	return sel;
+}
+
+/**
+ * Retrieve an element from a locked chunked array.
+ *   @arr: The chunked array.
+ *   @idx: The index.
+ *   @sel: The locked selector.
+ *   &returns: The element pointer.
+ */
+
+static inline void *dsp_carray_at(struct dsp_carray_t *arr, unsigned int idx, uint8_t sel)
+{
+	return arr->ver[sel].dir[idx >> DSP_CARRAY_SHIFT]->data + (idx & (DSP_CARRAY_CHUNK - 1)) * arr->nbytes;
+}
+
+/**
+ * Unlock the chunked array data.
+ *   @arr: The chunked array.
+ *   @sel: The locked selector.
+ */
+
+static inline void dsp_carray_unlock(struct dsp_carray_t *arr, uint8_t sel)
+{
+	dsp_lock_rdunlock(&arr->lock, sel);
+}
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
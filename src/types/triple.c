@@ -0,0 +1,61 @@
+#include "../common.h"
+#include "triple.h"
+
+
+/**
+ * Create a triple buffer.
+ *   @size: The value size.
+ *   @init: The initial value.
+ *   &returns: The triple buffer.
+ */
+
+_export
+struct dsp_triple_t *dsp_triple_new(unsigned int size, const void *init)
+{
+	unsigned int i;
+	struct dsp_triple_t *triple;
+
+	triple = mem_alloc(sizeof(struct dsp_triple_t) + 3 * ((size + 7) & ~7u));
+	triple->size = size;
+	triple->stride = (size + 7) & ~7u;
+	triple->lock = thread_mutex_new(NULL);
+	triple->back = 0;
+	triple->mid = 1;
+	triple->front = 2;
+
+	for(i = 0; i < 3; i++)
+		mem_copy(triple->data + i * triple->stride, init, size);
+
+	return triple;
+}
+
+/**
+ * Delete a triple buffer.
+ *   @triple: The triple buffer.
+ */
+
+_export
+void dsp_triple_delete(struct dsp_triple_t *triple)
+{
+	thread_mutex_delete(&triple->lock);
+	mem_free(triple);
+}
+
+
+/**
+ * Publish a new value. Multiple writers are serialized among themselves by
+ * the writer lock, but never wait on the reader.
+ *   @triple: The triple buffer.
+ *   @data: The value.
+ */
+
+_export
+void dsp_triple_write(struct dsp_triple_t *triple, const void *data)
+{
+	thread_mutex_lock(&triple->lock);
+
+	mem_copy(triple->data + triple->back * triple->stride, data, triple->size);
+	triple->back = __atomic_exchange_n(&triple->mid, triple->back | DSP_TRIPLE_DIRTY, __ATOMIC_ACQ_REL) & DSP_TRIPLE_MASK;
+
+	thread_mutex_unlock(&triple->lock);
+}
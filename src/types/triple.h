@@ -0,0 +1,90 @@
+#ifndef TRIPLE_H
+#define TRIPLE_H
+
+/*
+ * Start Header Creation: dsp.h
+ */
+
+/* %dsp.h% */
+
+/*
+ * triple buffer definitions
+ */
+
+#define DSP_TRIPLE_DIRTY 0x4
+#define DSP_TRIPLE_MASK 0x3
+
+
+/**
+ * Triple buffer structure. Each of the writer and reader owns one buffer,
+ * and the third is exchanged between them, so the writer never waits on the
+ * reader and the reader never waits on anything.
+ *   @size, stride: The value size and buffer stride.
+ *   @lock: The writer lock, only contended between writers.
+ *   @back: The writer buffer index.
+ *   @mid: The exchanged buffer index and dirty flag.
+ *   @front: The reader buffer index.
+ *   @data: The buffers.
+ */
+
+struct dsp_triple_t {
+	unsigned int size, stride;
+
+	struct thread_mutex_t lock;
+	uint8_t back;
+	uint8_t pad0[DSP_CACHELINE - 1];
+
+	uint8_t mid;
+	uint8_t pad1[DSP_CACHELINE - 1];
+
+	uint8_t front;
+	uint8_t pad2[DSP_CACHELINE - 1];
+
+	uint8_t data[];
+};
+
+
+/*
+ * triple buffer function declarations
+ */
+
+struct dsp_triple_t *dsp_triple_new(unsigned int size, const void *init);
+void dsp_triple_delete(struct dsp_triple_t *triple);
+
+void dsp_triple_write(struct dsp_triple_t *triple, const void *data);
+
+
+/**
+ * Read the most recently published value. At most one atomic exchange is
+ * performed, and only when a newer value is available. The returned pointer
+ * is valid until the next read.
+ *   @triple: The triple buffer.
+ *   &returns: The value.
+ */
+
+static inline const void *dsp_triple_read(struct dsp_triple_t *triple)
+{
+	if(__atomic_load_n(&triple->mid, __ATOMIC_RELAXED) & DSP_TRIPLE_DIRTY)
+		triple->front = __atomic_exchange_n(&triple->mid, triple->front, __ATOMIC_ACQ_REL) & DSP_TRIPLE_MASK;
+
+	return triple->data + triple->front * triple->stride;
+}
+
+/**
+ * Check if a newer value has been published since the last read.
+ *   @triple: The triple buffer.
+ *   &returns: True if a newer value is available.
+ */
+
+static inline bool dsp_triple_fresh(struct dsp_triple_t *triple)
+{
+	return __atomic_load_n(&triple->mid, __ATOMIC_RELAXED) & DSP_TRIPLE_DIRTY;
+}
+
+/* %~dsp.h% */
+
+/*
+ * End Header Creation: dsp.h
+ */
+
+#endif
@@ -0,0 +1,118 @@
+#include "common.h"
+#include <unistd.h>
+
+
+/*
+ * local function declarations
+ */
+
+static void auto_model(const char *path, struct dsp_filter_auto_model_t model);
+static void auto_check(const struct dsp_pt_t *pt, unsigned int npts, unsigned int blk, enum dsp_filter_auto_e kind);
+
+
+/**
+ * Automatic FIR test. Each engine is forced through a loaded cost model and
+ * must match direct convolution across uneven and in-place blocks, and a
+ * block length of one must not select the FFT engine.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_auto()
+{
+	unsigned int i;
+	char path[] = "/tmp/dsp-auto-XXXXXX";
+	struct dsp_filter_auto_model_t orig;
+	struct dsp_pt_t pt[12];
+
+	printf("auto... ");
+
+	for(i = 0; i < 12; i++)
+		pt[i] = (struct dsp_pt_t){ (i * 131) % 1500, 0.3 * sin(1.0 + i) };
+
+	orig = dsp_filter_auto_model();
+	close(mkstemp(path));
+
+	auto_model(path, (struct dsp_filter_auto_model_t){ 1e-6, 1.0, 1.0, 1.0 });
+	auto_check(pt, 12, 64, dsp_filter_auto_sparse);
+
+	auto_model(path, (struct dsp_filter_auto_model_t){ 1.0, 1e-6, 1.0, 1.0 });
+	auto_check(pt, 12, 64, dsp_filter_auto_dense);
+
+	auto_model(path, (struct dsp_filter_auto_model_t){ 1000.0, 1.0, 1e-9, 1e-9 });
+	auto_check(pt, 12, 64, dsp_filter_auto_fft);
+	auto_check(pt, 12, 1, dsp_filter_auto_dense);
+
+	auto_model(path, orig);
+	unlink(path);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Load a cost model through the calibration cache file.
+ *   @path: The cache file path.
+ *   @model: The model.
+ */
+
+static void auto_model(const char *path, struct dsp_filter_auto_model_t model)
+{
+	FILE *file;
+
+	file = fopen(path, "w");
+	if(file == NULL)
+		printf("failed\n"), sys_exit(1);
+
+	fprintf(file, "dsp-auto-1 %.17g %.17g %.17g %.17g\n", model.sparse, model.dense, model.fft, model.mac);
+	fclose(file);
+
+	dsp_filter_auto_calib(path);
+}
+
+/**
+ * Check the selected engine against direct convolution, both out of place
+ * and in place.
+ *   @pt: The point set.
+ *   @npts: The number of points.
+ *   @blk: The block length.
+ *   @kind: The expected engine.
+ */
+
+static void auto_check(const struct dsp_pt_t *pt, unsigned int npts, unsigned int blk, enum dsp_filter_auto_e kind)
+{
+	unsigned int i, k, n, off, cnt;
+	double in[4000], out[4000], buf[4000], ref;
+	struct dsp_filter_auto_t *filt[2];
+
+	for(i = 0; i < 2; i++) {
+		filt[i] = dsp_filter_auto_new(pt, npts, blk);
+		if(dsp_filter_auto_kind(filt[i]) != kind)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	for(i = 0; i < 4000; i++)
+		in[i] = sin(0.05 * i) + 0.5 * sin(1.3 * i + 1.0);
+
+	mem_copy(buf, in, sizeof(in));
+
+	for(off = 0, cnt = 1; off < 4000; off += n, cnt = (cnt * 37 + 11) % 700 + 1) {
+		n = (4000 - off < cnt) ? (4000 - off) : cnt;
+		dsp_filter_auto_proc(filt[0], in + off, out + off, n);
+		dsp_filter_auto_proc(filt[1], buf + off, buf + off, n);
+	}
+
+	for(i = 0; i < 4000; i++) {
+		for(ref = in[i], k = 0; k < npts; k++) {
+			if(pt[k].n <= i)
+				ref += pt[k].a * in[i - pt[k].n];
+		}
+
+		if((fabs(out[i] - ref) > 1e-9) || (fabs(buf[i] - ref) > 1e-9))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_filter_auto_delete(filt[0]);
+	dsp_filter_auto_delete(filt[1]);
+}
@@ -0,0 +1,71 @@
+#include "common.h"
+
+
+/**
+ * Filter bank test. Channels mixing every filter kind, plus an untouched
+ * channel, are checked against the scalar filters over uneven blocks.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_bank()
+{
+	unsigned int i, c, n, off;
+	double x, y, in[7][1000], out[7][1000], *ptr[7];
+	struct dsp_data_1 d1[2];
+	struct dsp_data_2 d2[3];
+	struct dsp_data_4 d4;
+	struct dsp_filter_bank_t *bank;
+
+	printf("bank... ");
+
+	for(c = 0; c < 7; c++) {
+		for(i = 0; i < 1000; i++)
+			in[c][i] = out[c][i] = sin(0.01 * (c + 1) * i) + ((i % (50 + c) == 0) ? 1.0 : 0.0);
+	}
+
+	bank = dsp_filter_bank_new(7);
+	dsp_filter_bank_rc_low(bank, 0, dsp_rc_1(48000, 500.0));
+	dsp_filter_bank_rc_high(bank, 1, dsp_rc_1(48000, 300.0));
+	dsp_filter_bank_rc_pass(bank, 2, dsp_rc_2(48000, 200.0, 2000.0));
+	dsp_filter_bank_butter2_low(bank, 3, dsp_filt_butter2_init(48000, 1000.0));
+	dsp_filter_bank_butter2_high(bank, 4, dsp_filt_butter2_init(48000, 800.0));
+	dsp_filter_bank_moog(bank, 5, dsp_moog_init(48000, 2000.0, 2.0));
+
+	for(off = 0; off < 1000; off += n) {
+		n = (1000 - off < 77) ? (1000 - off) : 77;
+
+		for(c = 0; c < 7; c++)
+			ptr[c] = out[c] + off;
+
+		dsp_filter_bank_proc(ptr, n, bank);
+	}
+
+	dsp_filter_bank_delete(bank);
+
+	d1[0] = d1[1] = dsp_data_1();
+	mem_set(d2, 0x00, sizeof(d2));
+	mem_set(&d4, 0x00, sizeof(d4));
+
+	for(i = 0; i < 1000; i++) {
+		for(c = 0; c < 7; c++) {
+			x = in[c][i];
+
+			switch(c) {
+			case 0: y = dsp_rc_low(x, dsp_rc_1(48000, 500.0), &d1[0]); break;
+			case 1: y = dsp_rc_high(x, dsp_rc_1(48000, 300.0), &d1[1]); break;
+			case 2: y = dsp_rc_pass(x, dsp_rc_2(48000, 200.0, 2000.0), &d2[0]); break;
+			case 3: y = dsp_filt_butter2_low(x, dsp_filt_butter2_init(48000, 1000.0), &d2[1]); break;
+			case 4: y = dsp_filt_butter2_high(x, dsp_filt_butter2_init(48000, 800.0), &d2[2]); break;
+			case 5: y = dsp_moog_next(x, dsp_moog_init(48000, 2000.0, 2.0), &d4); break;
+			default: y = x; break;
+			}
+
+			if(fabs(out[c][i] - y) > 1e-9 * (1.0 + fabs(y)))
+				printf("failed\n"), sys_exit(1);
+		}
+	}
+
+	printf("okay\n");
+
+	return true;
+}
@@ -0,0 +1,472 @@
+#include "common.h"
+#include <errno.h>
+
+
+/*
+ * bench definitions
+ */
+
+#define BENCH_SAMPLES (1 << 18)
+#define BENCH_INIT 64
+
+
+/**
+ * Benchmark configuration.
+ *   @nread, nwrite: The number of reader and writer threads.
+ *   @rate: The commit rate of each writer per second, zero for unlimited.
+ *   @period: The reader period in microseconds, zero for a tight loop.
+ *   @thresh: The latency in nanoseconds considered blocking.
+ *   @secs: The run time of each benchmark in seconds.
+ */
+
+struct bench_conf_t {
+	unsigned int nread, nwrite;
+	unsigned int rate, period, thresh, secs;
+};
+
+/**
+ * Per-thread latency statistics.
+ *   @ops, over: The operation count and the count exceeding the threshold.
+ *   @max: The maximum latency.
+ *   @lat: The latency samples, the most recent 'BENCH_SAMPLES' are kept.
+ */
+
+struct bench_stat_t {
+	uint64_t ops, over;
+	uint32_t max;
+	uint32_t *lat;
+};
+
+/**
+ * Benchmark instance.
+ *   @conf: The configuration.
+ *   @run: The run flag.
+ *   @arr: The array.
+ *   @carr: The chunked array.
+ *   @live: The live queue.
+ *   @kind: The structure under test.
+ */
+
+enum bench_kind_e { bench_array_v, bench_carray_v, bench_live_v };
+
+struct bench_t {
+	struct bench_conf_t conf;
+	volatile bool run;
+
+	struct dsp_array_t arr;
+	struct dsp_carray_t carr;
+	struct dsp_sched_live_t *live;
+
+	enum bench_kind_e kind;
+};
+
+/**
+ * Thread argument.
+ *   @bench: The benchmark.
+ *   @id: The thread identifier.
+ *   @stat: The statistics.
+ */
+
+struct bench_arg_t {
+	struct bench_t *bench;
+	unsigned int id;
+	struct bench_stat_t stat;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void bench_exec(struct bench_conf_t *conf, enum bench_kind_e kind, const char *name);
+static void *bench_read(void *arg);
+static void *bench_write(void *arg);
+
+static void stat_init(struct bench_stat_t *stat);
+static void stat_add(struct bench_stat_t *stat, uint64_t lat, uint32_t thresh);
+static void stat_report(const char *name, const char *over, struct bench_arg_t *arg, unsigned int n, double secs);
+static int stat_cmp(const void *left, const void *right);
+
+static uint64_t bench_now(void);
+static void bench_sleep(uint64_t until);
+
+/*
+ * global variables
+ */
+
+static volatile uint64_t bench_sink;
+
+
+/**
+ * Main entry point.
+ *   @argc: The argument count.
+ *   @argv: The argument array.
+ *   &returns: The exit code.
+ */
+
+int main(int argc, char **argv)
+{
+	int i;
+	struct bench_conf_t conf = { 2, 1, 1000, 1333, 50000, 2 };
+
+	for(i = 1; i < argc; i++) {
+		unsigned int *val;
+
+		if(strcmp(argv[i], "-r") == 0)
+			val = &conf.nread;
+		else if(strcmp(argv[i], "-w") == 0)
+			val = &conf.nwrite;
+		else if(strcmp(argv[i], "-c") == 0)
+			val = &conf.rate;
+		else if(strcmp(argv[i], "-p") == 0)
+			val = &conf.period;
+		else if(strcmp(argv[i], "-b") == 0)
+			val = &conf.thresh;
+		else if(strcmp(argv[i], "-t") == 0)
+			val = &conf.secs;
+		else
+			val = NULL;
+
+		if((val == NULL) || (++i == argc)) {
+			fprintf(stderr, "usage: dsp-bench [-r readers] [-w writers] [-c commits/s] [-p period_us] [-b block_ns] [-t secs]\n");
+			return 1;
+		}
+
+		*val = strtoul(argv[i], NULL, 0);
+	}
+
+	if((conf.nread == 0) || (conf.nwrite == 0))
+		fprintf(stderr, "dsp-bench: At least one reader and writer required.\n"), sys_exit(1);
+
+	printf("readers=%u writers=%u rate=%u/s period=%uus block=%uns time=%us\n", conf.nread, conf.nwrite, conf.rate, conf.period, conf.thresh, conf.secs);
+
+	bench_exec(&conf, bench_array_v, "array");
+	bench_exec(&conf, bench_carray_v, "carray");
+	bench_exec(&conf, bench_live_v, "live");
+
+	return 0;
+}
+
+
+/**
+ * Execute a single benchmark, printing the results.
+ *   @conf: The configuration.
+ *   @kind: The structure under test.
+ *   @name: The display name.
+ */
+
+static void bench_exec(struct bench_conf_t *conf, enum bench_kind_e kind, const char *name)
+{
+	unsigned int i;
+	uint64_t val, start;
+	double secs;
+	struct bench_t bench;
+	struct bench_arg_t rd[conf->nread], wr[conf->nwrite];
+	struct thread_t *rdthread[conf->nread], *wrthread[conf->nwrite];
+
+	bench.conf = *conf;
+	bench.run = true;
+	bench.kind = kind;
+	bench.arr = dsp_array_empty(sizeof(uint64_t));
+	bench.carr = dsp_carray_empty(sizeof(uint64_t), true);
+	bench.live = dsp_sched_live_new(1024, sizeof(uint64_t));
+
+	for(val = 0; val < BENCH_INIT; val++) {
+		dsp_array_add(&bench.arr, &val, NULL);
+		dsp_carray_add(&bench.carr, &val, NULL);
+	}
+
+	for(i = 0; i < conf->nread; i++) {
+		rd[i].bench = &bench;
+		rd[i].id = i;
+		stat_init(&rd[i].stat);
+	}
+
+	for(i = 0; i < conf->nwrite; i++) {
+		wr[i].bench = &bench;
+		wr[i].id = i;
+		stat_init(&wr[i].stat);
+	}
+
+	start = bench_now();
+
+	for(i = 0; i < conf->nread; i++)
+		rdthread[i] = thread_new(bench_read, &rd[i], NULL);
+
+	for(i = 0; i < conf->nwrite; i++)
+		wrthread[i] = thread_new(bench_write, &wr[i], NULL);
+
+	bench_sleep(start + conf->secs * 1000000000ull);
+	bench.run = false;
+
+	for(i = 0; i < conf->nwrite; i++)
+		thread_join(wrthread[i]);
+
+	for(i = 0; i < conf->nread; i++)
+		thread_join(rdthread[i]);
+
+	secs = (bench_now() - start) / 1e9;
+
+	printf("%s\n", name);
+	if(kind == bench_live_v) {
+		stat_report("consumer", "late", rd, 1, secs);
+		stat_report("producer", "full", wr, conf->nwrite, secs);
+	}
+	else {
+		stat_report("reader", "blocked", rd, conf->nread, secs);
+		stat_report("writer", "over", wr, conf->nwrite, secs);
+	}
+
+	for(i = 0; i < conf->nread; i++)
+		mem_free(rd[i].stat.lat);
+
+	for(i = 0; i < conf->nwrite; i++)
+		mem_free(wr[i].stat.lat);
+
+	dsp_sched_live_delete(bench.live);
+	dsp_carray_destroy(&bench.carr);
+	dsp_array_destroy(&bench.arr);
+}
+
+/**
+ * Reader thread. Each iteration acquires the structure, touches every element
+ * and releases it, as an audio callback would. For the live queue only the
+ * first reader consumes, measuring the queueing delay of each element.
+ *   @ptr: The thread argument.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *bench_read(void *ptr)
+{
+	struct bench_arg_t *arg = ptr;
+	struct bench_t *bench = arg->bench;
+	uint64_t next, t, sum = 0;
+
+	if((bench->kind == bench_live_v) && (arg->id > 0))
+		return NULL;
+
+	next = bench_now();
+
+	while(bench->run) {
+		unsigned int i, n, len;
+		uint8_t sel;
+		uint64_t *data, buf[64];
+
+		t = bench_now();
+
+		switch(bench->kind) {
+		case bench_array_v:
+			sel = dsp_array_lock(&bench->arr, (void **)&data, &len);
+			for(i = 0; i < len; i++)
+				sum += data[i];
+
+			dsp_array_unlock(&bench->arr, sel);
+			stat_add(&arg->stat, bench_now() - t, bench->conf.thresh);
+			break;
+
+		case bench_carray_v:
+			sel = dsp_carray_lock(&bench->carr, &len);
+			for(i = 0; i < len; i++)
+				sum += *(uint64_t *)dsp_carray_at(&bench->carr, i, sel);
+
+			dsp_carray_unlock(&bench->carr, sel);
+			stat_add(&arg->stat, bench_now() - t, bench->conf.thresh);
+			break;
+
+		case bench_live_v:
+			n = dsp_sched_live_drain(bench->live, buf, 64);
+			t = bench_now();
+			for(i = 0; i < n; i++)
+				stat_add(&arg->stat, t - buf[i], bench->conf.thresh);
+
+			break;
+		}
+
+		if(bench->conf.period > 0) {
+			next += bench->conf.period * 1000ull;
+			bench_sleep(next);
+		}
+		else
+			sched_yield();
+	}
+
+	bench_sink += sum;
+
+	return NULL;
+}
+
+/**
+ * Writer thread. Each iteration adds and commits a value and then removes and
+ * commits it again, so the length stays constant. For the live queue each
+ * iteration posts a timestamp.
+ *   @ptr: The thread argument.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *bench_write(void *ptr)
+{
+	struct bench_arg_t *arg = ptr;
+	struct bench_t *bench = arg->bench;
+	uint64_t next, t, val;
+
+	next = bench_now();
+	val = BENCH_INIT + arg->id;
+
+	while(bench->run) {
+		t = bench_now();
+
+		switch(bench->kind) {
+		case bench_array_v:
+			dsp_array_add(&bench->arr, &val, NULL);
+			dsp_array_rem(&bench->arr, &val, NULL);
+			break;
+
+		case bench_carray_v:
+			dsp_carray_add(&bench->carr, &val, NULL);
+			dsp_carray_rem(&bench->carr, &val, NULL);
+			break;
+
+		case bench_live_v:
+			if(!dsp_sched_live_add(bench->live, &t))
+				arg->stat.over++;
+
+			break;
+		}
+
+		if(bench->kind == bench_live_v)
+			stat_add(&arg->stat, bench_now() - t, UINT32_MAX);
+		else
+			stat_add(&arg->stat, (bench_now() - t) / 2, bench->conf.thresh);
+
+		if(bench->conf.rate > 0) {
+			next += 1000000000ull / bench->conf.rate;
+			bench_sleep(next);
+		}
+		else
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Initialize statistics.
+ *   @stat: The statistics.
+ */
+
+static void stat_init(struct bench_stat_t *stat)
+{
+	stat->ops = stat->over = 0;
+	stat->max = 0;
+	stat->lat = mem_alloc(BENCH_SAMPLES * sizeof(uint32_t));
+}
+
+/**
+ * Add a latency sample.
+ *   @stat: The statistics.
+ *   @lat: The latency in nanoseconds.
+ *   @thresh: The threshold considered blocking.
+ */
+
+static void stat_add(struct bench_stat_t *stat, uint64_t lat, uint32_t thresh)
+{
+	uint32_t val = (lat > UINT32_MAX) ? UINT32_MAX : lat;
+
+	stat->lat[stat->ops++ % BENCH_SAMPLES] = val;
+
+	if(val > stat->max)
+		stat->max = val;
+
+	if(val > thresh)
+		stat->over++;
+}
+
+/**
+ * Report merged statistics for a group of threads.
+ *   @name: The group name.
+ *   @over: The label for the over threshold count.
+ *   @arg: The thread arguments.
+ *   @n: The number of threads.
+ *   @secs: The elapsed time in seconds.
+ */
+
+static void stat_report(const char *name, const char *over, struct bench_arg_t *arg, unsigned int n, double secs)
+{
+	unsigned int i, num, len = 0;
+	uint64_t ops = 0, cnt = 0;
+	uint32_t max = 0, *lat;
+
+	for(i = 0; i < n; i++) {
+		ops += arg[i].stat.ops;
+		cnt += arg[i].stat.over;
+		len += (arg[i].stat.ops < BENCH_SAMPLES) ? arg[i].stat.ops : BENCH_SAMPLES;
+		max = (arg[i].stat.max > max) ? arg[i].stat.max : max;
+	}
+
+	if(len == 0) {
+		printf("  %s: no samples\n", name);
+		return;
+	}
+
+	lat = mem_alloc(len * sizeof(uint32_t));
+
+	for(len = i = 0; i < n; i++) {
+		num = (arg[i].stat.ops < BENCH_SAMPLES) ? arg[i].stat.ops : BENCH_SAMPLES;
+		mem_copy(lat + len, arg[i].stat.lat, num * sizeof(uint32_t));
+		len += num;
+	}
+
+	qsort(lat, len, sizeof(uint32_t), stat_cmp);
+
+	printf("  %s: %.0f ops/s  p50 %uns  p99 %uns  p99.9 %uns  max %uns  %s %llu\n", name, ops / secs,
+			lat[len / 2], lat[(uint64_t)len * 99 / 100], lat[(uint64_t)len * 999 / 1000], max,
+			over, (unsigned long long)cnt);
+
+	mem_free(lat);
+}
+
+/**
+ * Compare two latency samples.
+ *   @left: The left sample.
+ *   @right: The right sample.
+ *   &returns: Their order.
+ */
+
+static int stat_cmp(const void *left, const void *right)
+{
+	uint32_t l = *(const uint32_t *)left, r = *(const uint32_t *)right;
+
+	return (l > r) - (l < r);
+}
+
+
+/**
+ * Retrieve the monotonic time.
+ *   &returns: The time in nanoseconds.
+ */
+
+static uint64_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * Sleep until an absolute monotonic time.
+ *   @until: The time in nanoseconds.
+ */
+
+static void bench_sleep(uint64_t until)
+{
+	int err;
+	struct timespec ts = { until / 1000000000ull, until % 1000000000ull };
+
+	while((err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR);
+
+	if(err != 0)
+		fprintf(stderr, "dsp-bench: Failed to sleep. %s.\n", strerror(err)), sys_exit(1);
+}
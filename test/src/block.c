@@ -0,0 +1,114 @@
+#include "common.h"
+
+
+/**
+ * Compare two buffers.
+ *   @a: The first buffer.
+ *   @b: The second buffer.
+ *   @len: The length.
+ *   &returns: True if equal to rounding.
+ */
+
+static bool block_isequal(const double *a, const double *b, unsigned int len)
+{
+	unsigned int i;
+
+	for(i = 0; i < len; i++) {
+		if(fabs(a[i] - b[i]) > 1e-12 * (1.0 + fabs(b[i])))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Block kernel test. Every block variant is run in place over uneven blocks
+ * and checked against its per-sample kernel.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_block()
+{
+	unsigned int i, k, n, off;
+	double in[2000], out[2000], ref[2000];
+	struct dsp_data_1 d1[2];
+	struct dsp_data_2 d2[2];
+	struct dsp_data_4 d4[2];
+	struct dsp_gate_data_t gd[2];
+	struct dsp_ring_t *ring[2];
+	struct dsp_rc_1 rc1 = dsp_rc_1(48000, 700.0);
+	struct dsp_rc_2 rc2 = dsp_rc_2(48000, 300.0, 3000.0);
+	struct dsp_butter_2 bt = dsp_filt_butter2_init(48000, 900.0);
+	struct dsp_moog_t mg = dsp_moog_init(48000, 1500.0, 1.5);
+	struct dsp_notch_t nt = dsp_notch_init(48000, 1000.0, 0.5);
+	struct dsp_gate_t gate = dsp_gate_new(48000, 0.001, 0.01, 0.005, 0.5, 0.3);
+	struct dsp_reverb_allpass_t ap = dsp_reverb_allpass_new(0.7, 113);
+	struct dsp_reverb_allpass_lpf_t apl = dsp_reverb_allpass_lpf_new(0.6, 97, 48000, 4000.0, 0.4);
+	struct dsp_reverb_comb_t cb = dsp_reverb_comb_new(0.8, 211);
+	struct dsp_reverb_comb_lpf_t cbl = dsp_reverb_comb_lpf_new(0.75, 173, 48000, 3000.0, 0.5);
+
+	printf("block... ");
+
+	for(i = 0; i < 2000; i++)
+		in[i] = sin(0.03 * i) * ((i / 300) % 2) + ((i % 89 == 0) ? 0.8 : 0.0);
+
+	for(k = 0; k < 13; k++) {
+		d1[0] = d1[1] = dsp_data_1();
+		d2[0] = d2[1] = dsp_data_2();
+		d4[0] = d4[1] = dsp_data_4();
+		gd[0] = gd[1] = dsp_gate_data();
+		ring[0] = dsp_ring_new(256);
+		ring[1] = dsp_ring_new(256);
+
+		for(i = 0; i < 2000; i++) {
+			switch(k) {
+			case 0: ref[i] = dsp_rc_low(in[i], rc1, &d1[0]); break;
+			case 1: ref[i] = dsp_rc_high(in[i], rc1, &d1[0]); break;
+			case 2: ref[i] = dsp_rc_pass(in[i], rc2, &d2[0]); break;
+			case 3: ref[i] = dsp_filt_butter2_low(in[i], bt, &d2[0]); break;
+			case 4: ref[i] = dsp_filt_butter2_high(in[i], bt, &d2[0]); break;
+			case 5: ref[i] = dsp_moog_next(in[i], mg, &d4[0]); break;
+			case 6: ref[i] = dsp_notch_res(in[i], nt, &d2[0]); break;
+			case 7: ref[i] = dsp_notch_cut(in[i], nt, &d2[0]); break;
+			case 8: ref[i] = dsp_gate_proc(fabs(in[i]), gate, &gd[0]); break;
+			case 9: ref[i] = dsp_reverb_allpass(in[i], ring[0], ap); break;
+			case 10: ref[i] = dsp_reverb_allpass_lpf(in[i], ring[0], apl); break;
+			case 11: ref[i] = dsp_reverb_comb(ring[0], in[i], cb); break;
+			case 12: ref[i] = dsp_reverb_comb_lpf(ring[0], in[i], 0.0, 0, cbl); break;
+			}
+		}
+
+		for(i = 0; i < 2000; i++)
+			out[i] = (k == 8) ? fabs(in[i]) : in[i];
+
+		for(off = 0; off < 2000; off += n) {
+			n = (2000 - off < 131) ? (2000 - off) : 131;
+
+			switch(k) {
+			case 0: dsp_rc_low_block(out + off, out + off, n, rc1, &d1[1]); break;
+			case 1: dsp_rc_high_block(out + off, out + off, n, rc1, &d1[1]); break;
+			case 2: dsp_rc_pass_block(out + off, out + off, n, rc2, &d2[1]); break;
+			case 3: dsp_filt_butter2_low_block(out + off, out + off, n, bt, &d2[1]); break;
+			case 4: dsp_filt_butter2_high_block(out + off, out + off, n, bt, &d2[1]); break;
+			case 5: dsp_moog_block(out + off, out + off, n, mg, &d4[1]); break;
+			case 6: dsp_notch_res_block(out + off, out + off, n, nt, &d2[1]); break;
+			case 7: dsp_notch_cut_block(out + off, out + off, n, nt, &d2[1]); break;
+			case 8: dsp_gate_block(out + off, out + off, n, gate, &gd[1]); break;
+			case 9: dsp_reverb_allpass_block(out + off, out + off, n, ring[1], ap); break;
+			case 10: dsp_reverb_allpass_lpf_block(out + off, out + off, n, ring[1], apl); break;
+			case 11: dsp_reverb_comb_block(out + off, out + off, n, ring[1], cb); break;
+			case 12: dsp_reverb_comb_lpf_block(out + off, out + off, n, ring[1], cbl); break;
+			}
+		}
+
+		if(!block_isequal(out, ref, 2000))
+			printf("failed\n"), sys_exit(1);
+
+		dsp_ring_delete(ring[0]);
+		dsp_ring_delete(ring[1]);
+	}
+
+	printf("okay\n");
+
+	return true;
+}
@@ -0,0 +1,91 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void carray_check(struct dsp_carray_t *arr, unsigned int n);
+
+
+/**
+ * Chunked array test.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_carray()
+{
+	unsigned int i, j;
+	uint64_t val;
+	struct dsp_sync_t sync;
+	struct dsp_carray_t arr;
+
+	printf("carray... ");
+
+	for(j = 0; j < 2; j++) {
+		arr = dsp_carray_empty(sizeof(uint64_t), j);
+
+		sync = dsp_sync_empty();
+		for(i = 0; i < 1000; i++)
+			dsp_carray_add(&arr, mem_getref(uint64_t, i), &sync);
+
+		carray_check(&arr, 0);
+		dsp_sync_commit(&sync);
+		carray_check(&arr, 1000);
+
+		for(i = 0; i < 1000; i += 2) {
+			if(!dsp_carray_rem(&arr, mem_getref(uint64_t, i), NULL))
+				printf("failed\n"), sys_exit(1);
+		}
+
+		val = 0;
+		if(dsp_carray_rem(&arr, &val, NULL))
+			printf("failed\n"), sys_exit(1);
+
+		carray_check(&arr, 500);
+
+		for(i = 1; i < 1000; i += 2) {
+			if(!dsp_carray_rem(&arr, mem_getref(uint64_t, i), NULL))
+				printf("failed\n"), sys_exit(1);
+		}
+
+		carray_check(&arr, 0);
+		dsp_carray_add(&arr, mem_getref(uint64_t, 7), NULL);
+		carray_check(&arr, 1);
+
+		dsp_carray_destroy(&arr);
+	}
+
+	printf("okay\n");
+
+	return true;
+}
+
+/**
+ * Check the contents of a chunked array. All elements must be distinct and
+ * odd when fewer than were added.
+ *   @arr: The chunked array.
+ *   @n: The expected length.
+ */
+
+static void carray_check(struct dsp_carray_t *arr, unsigned int n)
+{
+	uint8_t sel;
+	unsigned int i, len;
+	uint64_t val;
+	bool seen[1000] = { false };
+
+	sel = dsp_carray_lock(arr, &len);
+	if(len != n)
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < len; i++) {
+		val = *(uint64_t *)dsp_carray_at(arr, i, sel);
+		if((val >= 1000) || seen[val] || ((n == 500) && !(val & 1)))
+			printf("failed\n"), sys_exit(1);
+
+		seen[val] = true;
+	}
+
+	dsp_carray_unlock(arr, sel);
+}
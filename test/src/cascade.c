@@ -0,0 +1,77 @@
+#include "common.h"
+
+
+/**
+ * Section cascade test. Cascades of one to eleven sections, covering full
+ * and partial groups, are checked against a direct per-section reference
+ * with irregular block lengths.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_cascade()
+{
+	unsigned int i, k, n, off, nsos;
+	double x, y, in[4000], out[4000], ref[4000], st[11][2];
+	struct dsp_sos_t sos[11];
+	struct dsp_design_t *design;
+	struct dsp_filter_cascade_t *cascade;
+	struct dsp_design_param_t param;
+
+	printf("cascade... ");
+
+	for(i = 0; i < 4000; i++)
+		in[i] = sin(0.05 * i) + cos(0.0007 * i * i) + ((i % 97 == 0) ? 1.0 : 0.0);
+
+	for(nsos = 1; nsos <= 11; nsos++) {
+		param = (struct dsp_design_param_t){ dsp_design_cheby1, dsp_band_low, 2 * nsos, 48000.0, 3000.0, 0.0, 0.5 };
+		design = dsp_design_get(&param);
+		mem_copy(sos, design->sos, nsos * sizeof(struct dsp_sos_t));
+		dsp_design_put(design);
+
+		mem_set(st, 0x00, sizeof(st));
+
+		for(i = 0; i < 4000; i++) {
+			for(x = in[i], k = 0; k < nsos; k++) {
+				y = sos[k].b0 * x + st[k][0];
+				st[k][0] = sos[k].b1 * x - sos[k].a1 * y + st[k][1];
+				st[k][1] = sos[k].b2 * x - sos[k].a2 * y;
+				x = y;
+			}
+
+			ref[i] = x;
+		}
+
+		cascade = dsp_filter_cascade_new(sos, nsos);
+
+		for(off = 0, k = 0; off < 4000; off += n, k++) {
+			n = (k * 37) % 150;
+			n = (4000 - off < n) ? (4000 - off) : n;
+
+			if(k % 2)
+				dsp_filter_cascade_proc(cascade, in + off, out + off, n);
+			else {
+				mem_copy(out + off, in + off, n * sizeof(double));
+				dsp_filter_cascade_proc(cascade, out + off, out + off, n);
+			}
+		}
+
+		for(i = 0; i < 4000; i++) {
+			if(fabs(out[i] - ref[i]) > 1e-9 * (1.0 + fabs(ref[i])))
+				printf("failed\n"), sys_exit(1);
+		}
+
+		dsp_filter_cascade_reset(cascade);
+		dsp_filter_cascade_proc(cascade, in, out, 100);
+
+		for(i = 0; i < 100; i++) {
+			if(fabs(out[i] - ref[i]) > 1e-9 * (1.0 + fabs(ref[i])))
+				printf("failed\n"), sys_exit(1);
+		}
+
+		dsp_filter_cascade_delete(cascade);
+	}
+
+	printf("okay\n");
+
+	return true;
+}
@@ -0,0 +1,148 @@
+#include "common.h"
+#include <unistd.h>
+
+
+/*
+ * local function declarations
+ */
+
+static double codec_quant(double x, unsigned int bits);
+static void codec_crafted(const char *path, uint32_t len, uint32_t size);
+
+
+/**
+ * Lossless codec test. Silence, full-scale, noise and tone channels are
+ * encoded at 16 and 24 bits, with and without worker threads, in blocks of
+ * irregular length, and must decode to exactly the quantized input. Frames
+ * with oversized lengths must end the stream.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_codec()
+{
+	unsigned int i, n, k, t, len, off, bits[2] = { 16, 24 }, nthread[2] = { 0, 3 };
+	uint32_t seed = 1;
+	double in[4][5000], out[4][600], *inbuf[4], *outbuf[4] = { out[0], out[1], out[2], out[3] };
+	char path[] = "/tmp/dsp-codec-XXXXXX";
+	struct dsp_enc_t *enc;
+	struct dsp_dec_t *dec;
+
+	printf("codec... ");
+
+	for(i = 0; i < 5000; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		in[0][i] = 0.0;
+		in[1][i] = (i % 3 == 0) ? 1.0 : ((i % 3 == 1) ? -1.0 : 1.5);
+		in[2][i] = seed * (2.0 / 4294967296.0) - 1.0;
+		in[3][i] = 0.7 * sin(0.013 * i);
+	}
+
+	close(mkstemp(path));
+
+	for(k = 0; k < 2; k++) {
+		for(t = 0; t < 2; t++) {
+			enc = dsp_enc_new(path, 4, 48000, bits[k], nthread[t]);
+
+			for(off = 0, len = 1; off < 5000; off += len, len = (len * 37 + 11) % 600 + 1) {
+				len = (5000 - off < len) ? (5000 - off) : len;
+
+				for(n = 0; n < 4; n++)
+					inbuf[n] = in[n] + off;
+
+				dsp_enc_proc(enc, inbuf, len);
+			}
+
+			if(dsp_enc_size(enc) == 0)
+				printf("failed\n"), sys_exit(1);
+
+			dsp_enc_delete(enc);
+
+			dec = dsp_dec_new(path);
+			if((dsp_dec_nchan(dec) != 4) || (dsp_dec_rate(dec) != 48000) || (dsp_dec_bits(dec) != bits[k]))
+				printf("failed\n"), sys_exit(1);
+
+			for(off = 0, len = 599; off < 5000; off += len, len = (len * 13) % 600 + 1) {
+				if(dsp_dec_read(dec, outbuf, len) != ((5000 - off < len) ? (5000 - off) : len))
+					printf("failed\n"), sys_exit(1);
+
+				for(i = 0; (i < len) && (off + i < 5000); i++) {
+					for(n = 0; n < 4; n++) {
+						if(out[n][i] != codec_quant(in[n][off + i], bits[k]))
+							printf("failed\n"), sys_exit(1);
+					}
+				}
+			}
+
+			if(dsp_dec_read(dec, outbuf, 10) != 0 || (out[1][9] != 0.0))
+				printf("failed\n"), sys_exit(1);
+
+			dsp_dec_delete(dec);
+		}
+	}
+
+	codec_crafted(path, UINT32_C(0x80000000), 4);
+	codec_crafted(path, DSP_CODEC_MAXLEN + 1, 4);
+	codec_crafted(path, 16, UINT32_C(0xfffffff0));
+
+	unlink(path);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Quantize a sample the way the encoder does, clipping to full scale.
+ *   @x: The sample.
+ *   @bits: The sample width.
+ *   &returns: The quantized sample.
+ */
+
+static double codec_quant(double x, unsigned int bits)
+{
+	double scale = ldexp(1.0, bits - 1), q;
+
+	q = rint(((x > 1.0) ? 1.0 : ((x < -1.0) ? -1.0 : x)) * scale);
+
+	return ((q >= scale) ? (scale - 1.0) : q) / scale;
+}
+
+/**
+ * Check that a two-channel file holding one crafted frame decodes to an
+ * empty stream.
+ *   @path: The file path.
+ *   @len: The frame length.
+ *   @size: The per-channel data size.
+ */
+
+static void codec_crafted(const char *path, uint32_t len, uint32_t size)
+{
+	unsigned int i;
+	FILE *file;
+	double out[2][16], *outbuf[2] = { out[0], out[1] };
+	uint8_t data[DSP_CODEC_HDRLEN + 16] = { 'D', 'S', 'P', 'L', 1, 16, 2, 0, 0x80, 0xbb, 0, 0 };
+	struct dsp_dec_t *dec;
+
+	for(i = 0; i < 4; i++) {
+		data[DSP_CODEC_HDRLEN + i] = len >> (8 * i);
+		data[DSP_CODEC_HDRLEN + 4 + i] = size >> (8 * i);
+		data[DSP_CODEC_HDRLEN + 12 + i] = size >> (8 * i);
+	}
+
+	file = fopen(path, "wb");
+	if(file == NULL)
+		printf("failed\n"), sys_exit(1);
+
+	fwrite(data, 1, sizeof(data), file);
+	fclose(file);
+
+	dec = dsp_dec_new(path);
+	if(dsp_dec_read(dec, outbuf, 16) != 0)
+		printf("failed\n"), sys_exit(1);
+
+	dsp_dec_delete(dec);
+}
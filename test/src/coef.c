@@ -0,0 +1,102 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void *coef_proc(void *arg);
+
+
+/**
+ * Coefficient cache test. Identical parameters must share one constant equal
+ * to the direct computation, referenced constants must survive a purge, and
+ * lookups from several threads must stay valid while the cache is purged.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_coef()
+{
+	unsigned int i;
+	struct thread_t *thread[4];
+	const struct dsp_butter_2 *butter, *dup, *other;
+	const struct dsp_moog_t *moog;
+	const struct dsp_rc_2 *rc;
+	struct dsp_butter_2 ref;
+	struct dsp_moog_t mref;
+	struct dsp_rc_2 rref;
+
+	printf("coef... ");
+
+	dsp_coef_purge();
+
+	butter = dsp_coef_butter2(48000, 1000.0);
+	dup = dsp_coef_butter2(48000, 1000.0);
+	other = dsp_coef_butter2(44100, 1000.0);
+	ref = dsp_filt_butter2_init(48000, 1000.0);
+	if((butter != dup) || (other == butter) || !mem_isequal(butter, &ref, sizeof(ref)))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_coef_put(dup);
+	dsp_coef_put(other);
+
+	moog = dsp_coef_moog(48000, 1000.0, 0.5);
+	rc = dsp_coef_rc_2(48000, 100.0, 2000.0);
+	mref = dsp_moog_init(48000, 1000.0, 0.5);
+	rref = dsp_rc_2(48000, 100.0, 2000.0);
+	if(((const void *)moog == (const void *)butter) || !mem_isequal(moog, &mref, sizeof(mref)) || !mem_isequal(rc, &rref, sizeof(rref)))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_coef_put(moog);
+	dsp_coef_put(rc);
+
+	if((dsp_coef_purge() != 3) || (dsp_coef_butter2(48000, 1000.0) != butter))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_coef_put(butter);
+	dsp_coef_put(butter);
+
+	for(i = 0; i < 4; i++)
+		thread[i] = thread_new(coef_proc, (void *)(uintptr_t)i, NULL);
+
+	for(i = 0; i < 2000; i++)
+		dsp_coef_purge();
+
+	for(i = 0; i < 4; i++)
+		thread_join(thread[i]);
+
+	dsp_coef_purge();
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Lookup thread, checking shared constants against the direct computation
+ * while the main thread purges.
+ *   @arg: The thread index.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *coef_proc(void *arg)
+{
+	unsigned int i;
+	double freq;
+	const struct dsp_notch_t *notch;
+	struct dsp_notch_t ref;
+
+	for(i = 0; i < 20000; i++) {
+		freq = 100.0 * (1 + (i + (uintptr_t)arg) % 16);
+		notch = dsp_coef_notch(48000, freq, 0.7);
+
+		ref = dsp_notch_init(48000, freq, 0.7);
+		if(!mem_isequal(notch, &ref, sizeof(ref)))
+			printf("failed\n"), sys_exit(1);
+
+		dsp_coef_put(notch);
+	}
+
+	return NULL;
+}
@@ -0,0 +1,79 @@
+#include "common.h"
+
+
+/**
+ * Partitioned convolution test. The transform is checked against a direct
+ * DFT and the convolver against direct convolution, with an impulse
+ * response long enough to use every level.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_convolve()
+{
+	unsigned int i, k, n, off;
+	double re, im, x[64], spec[66], ir[40000], *in, *out, *ptr[2];
+	struct dsp_fft_t *fft;
+	struct dsp_convolve_t *conv;
+
+	printf("convolve... ");
+
+	fft = dsp_fft_new(64);
+
+	for(i = 0; i < 64; i++)
+		x[i] = sin(0.3 * i * i) + 0.1 * i;
+
+	dsp_fft_fwd(fft, x, spec);
+
+	for(k = 0; k <= 32; k++) {
+		for(re = im = 0.0, i = 0; i < 64; i++) {
+			re += x[i] * cos(2.0 * M_PI * i * k / 64);
+			im -= x[i] * sin(2.0 * M_PI * i * k / 64);
+		}
+
+		if((fabs(re - spec[2 * k]) > 1e-9) || (fabs(im - spec[2 * k + 1]) > 1e-9))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_fft_inv(fft, spec, spec);
+
+	for(i = 0; i < 64; i++) {
+		if(fabs(spec[i] / 64.0 - x[i]) > 1e-12)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_fft_delete(fft);
+
+	for(i = 0; i < 40000; i++)
+		ir[i] = cos(0.01 * i * i) * exp(-i / 8000.0);
+
+	in = mem_alloc(50000 * sizeof(double));
+	out = mem_alloc(50000 * sizeof(double));
+
+	for(i = 0; i < 50000; i++)
+		in[i] = sin(0.7 * i) + cos(0.011 * i * i);
+
+	conv = dsp_convolve_new(mem_getref(double *, ir), 40000, 1, 32);
+
+	for(off = 0; off < 50000; off += n) {
+		n = (50000 - off < 300) ? (50000 - off) : 300;
+		ptr[0] = in + off;
+		ptr[1] = out + off;
+		dsp_convolve_proc(conv, &ptr[0], &ptr[1], n);
+	}
+
+	for(i = 32; i < 50000; i += 97) {
+		for(re = 0.0, k = 0; (k < 40000) && (k <= i - 32); k++)
+			re += ir[k] * in[i - 32 - k];
+
+		if(fabs(re - out[i]) > 1e-9)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_convolve_delete(conv);
+	mem_free(in);
+	mem_free(out);
+
+	printf("okay\n");
+
+	return true;
+}
@@ -0,0 +1,206 @@
+#include "common.h"
+#include <complex.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+
+/**
+ * Check a design's magnitude against an expected level in decibels.
+ *   @design: The design.
+ *   @freq: The frequency.
+ *   @db: The expected level.
+ *   @tol: The tolerance in decibels.
+ *   &returns: True if within tolerance.
+ */
+
+static bool design_near(struct dsp_design_t *design, double freq, double db, double tol)
+{
+	return fabs(20.0 * log10(dsp_design_mag(design, freq)) - db) <= tol;
+}
+
+/**
+ * Compute the complex response of a design.
+ *   @design: The design.
+ *   @freq: The frequency.
+ *   &returns: The response.
+ */
+
+static double complex design_resp(struct dsp_design_t *design, double freq)
+{
+	unsigned int i;
+	double complex e, h = 1.0;
+	struct dsp_sos_t *sos;
+
+	e = cexp(-I * 2.0 * M_PI * freq / design->param.rate);
+
+	for(i = 0; i < design->nsos; i++) {
+		sos = &design->sos[i];
+		h *= (sos->b0 + sos->b1 * e + sos->b2 * e * e) / (1.0 + sos->a1 * e + sos->a2 * e * e);
+	}
+
+	return h;
+}
+
+/**
+ * Repeatedly retrieve and release designs from a small set of parameters,
+ * racing other threads to build and free the same entries.
+ *   @arg: Unused.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *design_proc(void *arg)
+{
+	unsigned int i;
+	struct dsp_design_t *design;
+	struct dsp_design_param_t param = { dsp_design_butter, dsp_band_low, 4, 48000.0, 0.0, 0.0, 0.0 };
+
+	for(i = 0; i < 2000; i++) {
+		param.freq = 1000.0 * (1 + i % 3);
+		design = dsp_design_get(&param);
+		if((design->nsos != 2) || (design->param.freq != param.freq))
+			printf("failed\n"), sys_exit(1);
+
+		dsp_design_put(design);
+	}
+
+	return NULL;
+}
+
+/**
+ * Check that a design request is rejected, running it in a child process
+ * since rejection throws.
+ *   @param: The parameters.
+ *   &returns: True if rejected.
+ */
+
+static bool design_reject(const struct dsp_design_param_t *param)
+{
+	int status;
+	pid_t pid;
+
+	fflush(stdout);
+	pid = fork();
+	if(pid == 0) {
+		freopen("/dev/null", "w", stderr);
+		dsp_design_get(param);
+		_exit(0);
+	}
+
+	return (pid > 0) && (waitpid(pid, &status, 0) == pid) && !(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
+
+/**
+ * Filter design test. Cutoff levels, ripple, attenuation and crossover sums
+ * are checked against the analytic responses, identical parameters must
+ * share one design, concurrent users must not disturb the cache, and NaN
+ * parameters must be rejected.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_design()
+{
+	unsigned int i;
+	double f;
+	struct dsp_design_t *lo, *hi, *dup;
+	struct dsp_design_param_t param;
+	struct thread_t *thread[3];
+
+	printf("design... ");
+
+	param = (struct dsp_design_param_t){ dsp_design_butter, dsp_band_low, 5, 48000.0, 1000.0, 0.0, 0.0 };
+	lo = dsp_design_get(&param);
+	if((lo->nsos != 3) || !design_near(lo, 0.0, 0.0, 1e-9) || !design_near(lo, 1000.0, -3.0103, 1e-3) || (dsp_design_mag(lo, 10000.0) > 1e-5))
+		printf("failed\n"), sys_exit(1);
+
+	param.width = 123.0;
+	dup = dsp_design_get(&param);
+	if(dup != lo)
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < lo->nsos; i++) {
+		if((fabs(lo->sos[i].a2) >= 1.0) || (fabs(lo->sos[i].a1) >= 1.0 + lo->sos[i].a2))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_design_put(dup);
+	dsp_design_put(lo);
+
+	param = (struct dsp_design_param_t){ dsp_design_butter, dsp_band_high, 4, 48000.0, 200.0, 0.0, 0.0 };
+	hi = dsp_design_get(&param);
+	if(!design_near(hi, 24000.0, 0.0, 1e-9) || !design_near(hi, 200.0, -3.0103, 1e-3) || (dsp_design_mag(hi, 0.0) > 1e-9))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_design_put(hi);
+
+	param = (struct dsp_design_param_t){ dsp_design_cheby1, dsp_band_low, 5, 48000.0, 2000.0, 0.0, 1.0 };
+	lo = dsp_design_get(&param);
+	if(!design_near(lo, 0.0, 0.0, 1e-9) || !design_near(lo, 2000.0, -1.0, 1e-6))
+		printf("failed\n"), sys_exit(1);
+
+	for(f = 0.0; f < 2000.0; f += 10.0) {
+		if((20.0 * log10(dsp_design_mag(lo, f)) < -1.0 - 1e-6) || (dsp_design_mag(lo, f) > 1.0 + 1e-9))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_design_put(lo);
+
+	param = (struct dsp_design_param_t){ dsp_design_cheby2, dsp_band_low, 6, 48000.0, 3000.0, 0.0, 60.0 };
+	lo = dsp_design_get(&param);
+	if(!design_near(lo, 0.0, 0.0, 1e-9) || !design_near(lo, 3000.0, -60.0, 1e-6))
+		printf("failed\n"), sys_exit(1);
+
+	for(f = 3000.0; f < 24000.0; f += 10.0) {
+		if(dsp_design_mag(lo, f) > 1e-3 * (1.0 + 1e-6))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_design_put(lo);
+
+	param = (struct dsp_design_param_t){ dsp_design_linkwitz, dsp_band_low, 4, 48000.0, 2500.0, 0.0, 0.0 };
+	lo = dsp_design_get(&param);
+	param.band = dsp_band_high;
+	hi = dsp_design_get(&param);
+	if(!design_near(lo, 2500.0, -6.0206, 1e-3) || !design_near(hi, 2500.0, -6.0206, 1e-3))
+		printf("failed\n"), sys_exit(1);
+
+	for(f = 10.0; f < 24000.0; f *= 1.1) {
+		if(fabs(cabs(design_resp(lo, f) + design_resp(hi, f)) - 1.0) > 1e-9)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_design_put(lo);
+	dsp_design_put(hi);
+
+	param = (struct dsp_design_param_t){ dsp_design_butter, dsp_band_pass, 3, 48000.0, 4000.0, 1000.0, 0.0 };
+	lo = dsp_design_get(&param);
+	if((lo->nsos != 3) || (dsp_design_mag(lo, 0.0) > 1e-9) || (dsp_design_mag(lo, 24000.0) > 1e-9) || !design_near(lo, 4000.0, 0.0, 0.1) || !design_near(lo, 3500.0, -3.0103, 1e-3) || !design_near(lo, 4500.0, -3.0103, 1e-3))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_design_put(lo);
+
+	for(i = 0; i < 3; i++)
+		thread[i] = thread_new(design_proc, NULL, NULL);
+
+	for(i = 0; i < 3; i++)
+		thread_join(thread[i]);
+
+	param = (struct dsp_design_param_t){ dsp_design_butter, dsp_band_low, 4, 48000.0, NAN, 0.0, 0.0 };
+	if(!design_reject(&param))
+		printf("failed\n"), sys_exit(1);
+
+	param = (struct dsp_design_param_t){ dsp_design_butter, dsp_band_low, 4, NAN, 1000.0, 0.0, 0.0 };
+	if(!design_reject(&param))
+		printf("failed\n"), sys_exit(1);
+
+	param = (struct dsp_design_param_t){ dsp_design_cheby1, dsp_band_pass, 4, 48000.0, 1000.0, NAN, 1.0 };
+	if(!design_reject(&param))
+		printf("failed\n"), sys_exit(1);
+
+	param = (struct dsp_design_param_t){ dsp_design_cheby1, dsp_band_low, 4, 48000.0, 1000.0, 0.0, NAN };
+	if(!design_reject(&param))
+		printf("failed\n"), sys_exit(1);
+
+	printf("okay\n");
+
+	return true;
+}
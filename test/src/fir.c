@@ -0,0 +1,85 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void fir_check(const struct dsp_pt_t *pt, unsigned int npts, unsigned int len, bool sparse);
+
+
+/**
+ * Sparse block FIR filter test. Filters built from points and from sparse
+ * filters must match the per-sample sparse FIR across uneven and in-place
+ * blocks.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_fir()
+{
+	const struct dsp_pt_t wrap[] = {
+		{ 0, 0.3 }, { 1, -0.2 }, { 7, 0.1 }, { 49, 0.05 }, { 50, 0.07 }, { 120, 0.15 }
+	};
+	const struct dsp_pt_t wide[] = {
+		{ 250, 0.2 }, { 1, -0.4 }, { 64, 0.3 }, { 65, 0.1 }, { 3, 0.25 }, { 128, -0.15 }, { 191, 0.05 }
+	};
+
+	printf("fir... ");
+
+	fir_check(wrap, 6, 50, true);
+	fir_check(wide, 7, 300, true);
+	fir_check(wide, 7, 300, false);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Check a block FIR filter against the per-sample sparse FIR.
+ *   @pt: The point set.
+ *   @npts: The number of points.
+ *   @len: The ring length of the sparse filter.
+ *   @sparse: Build the block filter from the sparse filter if true, from the
+ *     points otherwise.
+ */
+
+static void fir_check(const struct dsp_pt_t *pt, unsigned int npts, unsigned int len, bool sparse)
+{
+	unsigned int i, n, off, blk;
+	const unsigned int size[] = { 1, 63, 64, 65, 200, 7, 128, 3, 500 };
+	double in[2000], out[2000], buf[2000], ref[2000];
+	struct dsp_filter_sparse_t *filt;
+	struct dsp_filter_fir_t *fir[2];
+
+	filt = dsp_filter_sparse_empty(npts, len);
+
+	for(i = 0; i < npts; i++)
+		filt->pt[i] = pt[i];
+
+	for(i = 0; i < 2; i++)
+		fir[i] = sparse ? dsp_filter_fir_sparse(filt) : dsp_filter_fir_new(pt, npts);
+
+	for(i = 0; i < 2000; i++) {
+		in[i] = sin(0.05 * i) + 0.5 * sin(0.31 * i + 1.0);
+		ref[i] = dsp_filter_sparse_fir(filt, in[i]);
+	}
+
+	mem_copy(buf, in, sizeof(in));
+
+	for(off = blk = 0; off < 2000; off += n, blk++) {
+		n = (2000 - off < size[blk % 9]) ? (2000 - off) : size[blk % 9];
+		dsp_filter_fir_proc(fir[0], in + off, out + off, n);
+		dsp_filter_fir_proc(fir[1], buf + off, buf + off, n);
+	}
+
+	for(i = 0; i < 2000; i++) {
+		if((fabs(out[i] - ref[i]) > 1e-12) || (fabs(buf[i] - ref[i]) > 1e-12))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_filter_fir_delete(fir[0]);
+	dsp_filter_fir_delete(fir[1]);
+	dsp_filter_sparse_delete(filt);
+}
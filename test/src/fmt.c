@@ -0,0 +1,51 @@
+#include "common.h"
+
+
+/**
+ * Sample format conversion test.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_fmt()
+{
+	unsigned int i, n;
+	double in[2][64], out[2][64], *inbuf[2] = { in[0], in[1] }, *outbuf[2] = { out[0], out[1] };
+	enum dsp_fmt_e fmt[5] = { dsp_fmt_s16, dsp_fmt_s24, dsp_fmt_s32, dsp_fmt_f32, dsp_fmt_f64 };
+	double tol[5] = { 1.0 / 32768.0, 1.0 / 8388608.0, 1.0 / 2147483648.0, 1e-7, 0.0 };
+	uint8_t packed[2 * 64 * 8];
+	struct dsp_dither_t *dither;
+
+	printf("fmt... ");
+
+	for(i = 0; i < 64; i++) {
+		in[0][i] = sin(i * 0.1) * 0.9;
+		in[1][i] = (i % 2) ? 2.0 : -2.0;
+	}
+
+	for(n = 0; n < 5; n++) {
+		dsp_arr2fmt(packed, inbuf, fmt[n], 2, 64, NULL);
+		dsp_fmt2arr(outbuf, packed, fmt[n], 2, 64);
+
+		for(i = 0; i < 64; i++) {
+			if(fabs(out[0][i] - in[0][i]) > tol[n])
+				printf("failed\n"), sys_exit(1);
+
+			if((n < 3) && (fabs(out[1][i]) > 1.0))
+				printf("failed\n"), sys_exit(1);
+		}
+	}
+
+	dither = dsp_dither_new(2, 2);
+	dsp_arr2fmt(packed, inbuf, dsp_fmt_s16, 2, 64, dither);
+	dsp_fmt2arr(outbuf, packed, dsp_fmt_s16, 2, 64);
+	dsp_dither_delete(dither);
+
+	for(i = 0; i < 64; i++) {
+		if(fabs(out[0][i] - in[0][i]) > 16.0 / 32768.0)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	printf("okay\n");
+
+	return true;
+}
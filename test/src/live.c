@@ -0,0 +1,129 @@
+#include "common.h"
+#include <unistd.h>
+#include <sys/wait.h>
+
+
+/*
+ * local function declarations
+ */
+
+static void *live_proc(void *arg);
+static bool live_reject(unsigned int len);
+
+/*
+ * global variables
+ */
+
+static struct dsp_sched_live_t *live_queue;
+
+
+/**
+ * Live scheduler test. Lengths that cannot be rounded up to a power of two
+ * must be rejected.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_live()
+{
+	unsigned int i, n, cnt, val[32], next[4] = { 0 };
+	struct thread_t *thread[4];
+
+	printf("live... ");
+
+	live_queue = dsp_sched_live_new(6, sizeof(unsigned int));
+	if(live_queue->len != 8)
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < 8; i++) {
+		if(!dsp_sched_live_add(live_queue, &i))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	if(dsp_sched_live_add(live_queue, &i))
+		printf("failed\n"), sys_exit(1);
+
+	if(!dsp_sched_live_remove(live_queue, &val[0]) || (val[0] != 0))
+		printf("failed\n"), sys_exit(1);
+
+	if((dsp_sched_live_drain(live_queue, val, 32) != 7) || (val[0] != 1) || (val[6] != 7))
+		printf("failed\n"), sys_exit(1);
+
+	if(dsp_sched_live_remove(live_queue, &val[0]))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_sched_live_delete(live_queue);
+
+	if(!live_reject((1u << 31) + 1) || !live_reject(UINT_MAX))
+		printf("failed\n"), sys_exit(1);
+
+	live_queue = dsp_sched_live_new(16, sizeof(unsigned int));
+
+	for(i = 0; i < 4; i++)
+		thread[i] = thread_new(live_proc, (void *)(uintptr_t)i, NULL);
+
+	for(cnt = 0; cnt < 4 * 20000; ) {
+		n = dsp_sched_live_drain(live_queue, val, 32);
+		if(n == 0)
+			sched_yield();
+
+		for(i = 0; i < n; i++) {
+			if((val[i] & 0xffff) != next[val[i] >> 16]++)
+				printf("failed\n"), sys_exit(1);
+		}
+
+		cnt += n;
+	}
+
+	for(i = 0; i < 4; i++)
+		thread_join(thread[i]);
+
+	dsp_sched_live_delete(live_queue);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Producer thread, posting an ordered sequence tagged with its index.
+ *   @arg: The producer index.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *live_proc(void *arg)
+{
+	unsigned int i, val;
+
+	for(i = 0; i < 20000; i++) {
+		val = ((uintptr_t)arg << 16) | i;
+
+		while(!dsp_sched_live_add(live_queue, &val))
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+/**
+ * Check that a live scheduler length is rejected, running the creation in a
+ * child process since rejection throws.
+ *   @len: The length.
+ *   &returns: True if rejected.
+ */
+
+static bool live_reject(unsigned int len)
+{
+	int status;
+	pid_t pid;
+
+	fflush(stdout);
+	pid = fork();
+	if(pid == 0) {
+		freopen("/dev/null", "w", stderr);
+		dsp_sched_live_new(len, sizeof(unsigned int));
+		_exit(0);
+	}
+
+	return (pid > 0) && (waitpid(pid, &status, 0) == pid) && !(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
@@ -0,0 +1,122 @@
+#include "common.h"
+#include <unistd.h>
+
+
+/**
+ * Loopback chain structure, a single-producer single-consumer ring from
+ * the recorder callback to the playback callback.
+ *   @ring: The ring data.
+ *   @rd, wr: The read and write counts.
+ */
+
+struct loop_chain_t {
+	double ring[4096];
+	unsigned int rd, wr;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static void loop_rec(double **buf, unsigned int len, void *arg);
+static void loop_play(double **buf, unsigned int len, void *arg);
+
+
+/**
+ * Loopback device test. The device input is recorded and played back
+ * through a ring, so every probe must come back with a latency bounded by
+ * the helper buffering, and none may be lost. Each period missed on a busy
+ * machine skips frames the helpers never see, so it widens the bound.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_loop()
+{
+	struct loop_chain_t chain = { { 0.0 }, 0, 0 };
+	struct dsp_loop_stat_t stat;
+	struct dsp_loop_t *loop;
+	struct dsp_rec_t *rec;
+	struct dsp_play_t *play;
+
+	printf("loop... ");
+
+	rec = dsp_rec_new(1, 128);
+	play = dsp_play_new(1, 128);
+	dsp_rec_conf(rec, loop_rec, &chain);
+	dsp_play_conf(play, loop_play, &chain);
+	dsp_play_prep(play);
+
+	loop = dsp_loop_new(1, 48000, 64);
+	dsp_loop_conf(loop, rec, play);
+	dsp_loop_jitter(loop, 100);
+	dsp_loop_probe(loop, 4800, 0.5);
+
+	dsp_loop_start(loop);
+	usleep(450000);
+	dsp_loop_stop(loop);
+	dsp_loop_stat(loop, &stat);
+
+	if((stat.periods + stat.missed < 150) || (stat.probes == 0) || (stat.lost != 0))
+		printf("failed\n"), sys_exit(1);
+
+	if((stat.latmin < 128) || (stat.latmax > 4 * 128 + 64 * stat.missed) || (stat.latavg < stat.latmin) || (stat.latavg > stat.latmax))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_loop_delete(loop);
+	dsp_rec_delete(rec);
+	dsp_play_delete(play);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Recorder callback, appending to the ring.
+ *   @buf: The input buffers.
+ *   @len: The length.
+ *   @arg: The chain.
+ */
+
+static void loop_rec(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i, wr;
+	struct loop_chain_t *chain = arg;
+
+	wr = __atomic_load_n(&chain->wr, __ATOMIC_RELAXED);
+	if(wr + len - __atomic_load_n(&chain->rd, __ATOMIC_ACQUIRE) > 4096)
+		return;
+
+	for(i = 0; i < len; i++)
+		chain->ring[(wr + i) % 4096] = buf[0][i];
+
+	__atomic_store_n(&chain->wr, wr + len, __ATOMIC_RELEASE);
+}
+
+/**
+ * Playback callback, draining the ring or playing silence if it is short.
+ *   @buf: The output buffers.
+ *   @len: The length.
+ *   @arg: The chain.
+ */
+
+static void loop_play(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i, rd;
+	struct loop_chain_t *chain = arg;
+
+	rd = __atomic_load_n(&chain->rd, __ATOMIC_RELAXED);
+	if(__atomic_load_n(&chain->wr, __ATOMIC_ACQUIRE) - rd < len) {
+		for(i = 0; i < len; i++)
+			buf[0][i] = 0.0;
+
+		return;
+	}
+
+	for(i = 0; i < len; i++)
+		buf[0][i] = chain->ring[(rd + i) % 4096];
+
+	__atomic_store_n(&chain->rd, rd + len, __ATOMIC_RELEASE);
+}
@@ -5,7 +5,30 @@
  * test function declarations
  */
 
+bool test_auto();
+bool test_bank();
+bool test_block();
+bool test_carray();
+bool test_cascade();
+bool test_codec();
+bool test_coef();
+bool test_convolve();
+bool test_design();
+bool test_fir();
+bool test_fmt();
+bool test_live();
+bool test_loop();
 bool test_map();
+bool test_mmap();
+bool test_mod();
+bool test_multirate();
+bool test_poly();
+bool test_probe();
+bool test_render();
+bool test_ring();
+bool test_sparse();
+bool test_triple();
+bool test_wheel();
 
 
 /**
@@ -117,6 +140,28 @@ bool test_conv()
 	if(dsp_int2len(48000, 17828, 44100, 2) != 8190)
 		printf("failed\n"), sys_exit(1);
 
+	{
+		unsigned int i, len;
+		double in[2 * 4410], left[4800], right[4800], *out[2] = { left, right };
+
+		for(i = 0; i < 4410; i++) {
+			in[2 * i + 0] = sin(2.0 * M_PI * 1000.0 * i / 44100.0);
+			in[2 * i + 1] = 0.5;
+		}
+
+		len = dsp_int2arr(in, 44100, out, 48000, 2 * 4410, 2);
+		if(len != 4800)
+			printf("failed\n"), sys_exit(1);
+
+		for(i = 100; i < 4700; i++) {
+			if(fabs(left[i] - sin(2.0 * M_PI * 1000.0 * i / 48000.0)) > 1e-3)
+				printf("failed\n"), sys_exit(1);
+
+			if(fabs(right[i] - 0.5) > 1e-3)
+				printf("failed\n"), sys_exit(1);
+		}
+	}
+
 	printf("okay\n");
 
 	return true;
@@ -137,7 +182,30 @@ int main(int argc, char *argv[])
 	suc &= test_coprime();
 	suc &= test_array();
 	suc &= test_conv();
+	suc &= test_auto();
+	suc &= test_bank();
+	suc &= test_block();
+	suc &= test_carray();
+	suc &= test_cascade();
+	suc &= test_codec();
+	suc &= test_coef();
+	suc &= test_convolve();
+	suc &= test_design();
+	suc &= test_fir();
+	suc &= test_fmt();
+	suc &= test_live();
+	suc &= test_loop();
 	suc &= test_map();
+	suc &= test_mmap();
+	suc &= test_mod();
+	suc &= test_multirate();
+	suc &= test_poly();
+	suc &= test_probe();
+	suc &= test_render();
+	suc &= test_ring();
+	suc &= test_sparse();
+	suc &= test_triple();
+	suc &= test_wheel();
 
 	return suc ? 0 : 1;
 }
@@ -0,0 +1,122 @@
+#include "common.h"
+#include <unistd.h>
+
+
+/*
+ * local function declarations
+ */
+
+static void mmap_file(char *path, const uint8_t *data, size_t size);
+
+
+/**
+ * Memory-mapped file test. A WAV file written with 'dsp_wav_header' is read
+ * back in blocks shorter and longer than the read-ahead, past the end, and
+ * after a seek, then the same data is mapped as a raw file. Files with an
+ * 18-byte format chunk place wider samples at unaligned offsets.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_mmap()
+{
+	unsigned int i, k, n, idx, len;
+	double in[2][1000], out[2][300], *inbuf[2] = { in[0], in[1] }, *outbuf[2] = { out[0], out[1] };
+	uint8_t data[DSP_WAV_HDRLEN + 4 * 1000], odd[DSP_WAV_HDRLEN + 2 + 16 * 300];
+	enum dsp_fmt_e fmt[3] = { dsp_fmt_s32, dsp_fmt_f32, dsp_fmt_f64 };
+	char path[] = "/tmp/dsp-mmap-XXXXXX";
+	struct dsp_mmap_t *file;
+
+	printf("mmap... ");
+
+	for(i = 0; i < 1000; i++) {
+		in[0][i] = sin(0.01 * i) * 0.9;
+		in[1][i] = (i % 7) / 7.0 - 0.5;
+	}
+
+	dsp_wav_header(data, dsp_fmt_s16, 2, 44100, 1000);
+	dsp_arr2fmt(data + DSP_WAV_HDRLEN, inbuf, dsp_fmt_s16, 2, 1000, NULL);
+	mmap_file(path, data, sizeof(data));
+
+	file = dsp_mmap_new(path);
+	if((dsp_mmap_nchan(file) != 2) || (dsp_mmap_rate(file) != 44100) || (dsp_mmap_len(file) != 1000))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_mmap_ahead(file, 16);
+
+	for(idx = 0, len = 1; idx < 1100; idx += len, len = (len * 7) % 300 + 1) {
+		n = dsp_mmap_read(file, outbuf, len);
+		if(n != ((idx < 1000) ? ((1000 - idx < len) ? (1000 - idx) : len) : 0))
+			printf("failed\n"), sys_exit(1);
+
+		for(i = 0; i < len; i++) {
+			if((i < n) && ((fabs(out[0][i] - in[0][idx + i]) > 1.0 / 32768.0) || (fabs(out[1][i] - in[1][idx + i]) > 1.0 / 32768.0)))
+				printf("failed\n"), sys_exit(1);
+			else if((i >= n) && ((out[0][i] != 0.0) || (out[1][i] != 0.0)))
+				printf("failed\n"), sys_exit(1);
+		}
+	}
+
+	dsp_mmap_seek(file, 500);
+	if((dsp_mmap_read(file, outbuf, 10) != 10) || (fabs(out[0][3] - in[0][503]) > 1.0 / 32768.0))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_mmap_delete(file);
+
+	file = dsp_mmap_raw(path, dsp_fmt_s16, 1, 8000);
+	if((dsp_mmap_len(file) != sizeof(data) / 2) || (dsp_mmap_read(file, outbuf, 300) != 300))
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < 100; i++) {
+		if(fabs(out[0][DSP_WAV_HDRLEN / 2 + 2 * i] - in[0][i]) > 1.0 / 32768.0)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_mmap_delete(file);
+	unlink(path);
+
+	for(k = 0; k < 3; k++) {
+		dsp_wav_header(odd, fmt[k], 2, 48000, 300);
+		odd[16] = 18;
+		mem_move(odd + 38, odd + 36, 8);
+		odd[36] = odd[37] = 0;
+		dsp_arr2fmt(odd + DSP_WAV_HDRLEN + 2, inbuf, fmt[k], 2, 300, NULL);
+
+		mem_copy(path + sizeof(path) - 7, "XXXXXX", 6);
+		mmap_file(path, odd, DSP_WAV_HDRLEN + 2 + 2 * 300 * dsp_fmt_size(fmt[k]));
+
+		file = dsp_mmap_new(path);
+		if((dsp_mmap_len(file) != 300) || (dsp_mmap_read(file, outbuf, 300) != 300))
+			printf("failed\n"), sys_exit(1);
+
+		for(i = 0; i < 300; i++) {
+			if((fabs(out[0][i] - in[0][i]) > 1e-7) || (fabs(out[1][i] - in[1][i]) > 1e-7))
+				printf("failed\n"), sys_exit(1);
+		}
+
+		dsp_mmap_delete(file);
+		unlink(path);
+	}
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Write data to a new temporary file.
+ *   @path: The path template, replaced with the file path.
+ *   @data: The data.
+ *   @size: The size.
+ */
+
+static void mmap_file(char *path, const uint8_t *data, size_t size)
+{
+	int fd;
+
+	fd = mkstemp(path);
+	if((fd < 0) || (write(fd, data, size) != (ssize_t)size))
+		printf("failed\n"), sys_exit(1);
+
+	close(fd);
+}
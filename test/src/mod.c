@@ -0,0 +1,60 @@
+#include "common.h"
+
+
+/**
+ * Modulated filter test. A constant frequency must match the plain filter,
+ * and a sweep must track per-sample coefficient updates closely without
+ * blowing up.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_mod()
+{
+	unsigned int i, n, off;
+	double err, in[4800], out[4800], freq[4800];
+	struct dsp_data_2 d2;
+	struct dsp_data_4 d4;
+	struct dsp_filter_mod_t *mod;
+
+	printf("mod... ");
+
+	for(i = 0; i < 4800; i++) {
+		in[i] = sin(0.05 * i) + 0.5 * sin(0.31 * i);
+		freq[i] = 1000.0;
+	}
+
+	mod = dsp_filter_mod_new(dsp_mod_butter2_low, 48000, 0.0);
+
+	for(off = 0; off < 4800; off += n) {
+		n = (4800 - off < 45) ? (4800 - off) : 45;
+		dsp_filter_mod_proc(mod, in + off, out + off, freq + off, n);
+	}
+
+	dsp_filter_mod_delete(mod);
+
+	d2 = dsp_data_2();
+
+	for(i = 0; i < 4800; i++) {
+		if(fabs(out[i] - dsp_filt_butter2_low(in[i], dsp_filt_butter2_init(48000, 1000.0), &d2)) > 1e-9)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	for(i = 0; i < 4800; i++)
+		freq[i] = 1500.0 + 1000.0 * sin(2.0 * M_PI * 3.0 * i / 48000.0);
+
+	mod = dsp_filter_mod_new(dsp_mod_moog, 48000, 2.0);
+	dsp_filter_mod_proc(mod, in, out, freq, 4800);
+	dsp_filter_mod_delete(mod);
+
+	d4 = dsp_data_4();
+
+	for(i = 0, err = 0.0; i < 4800; i++)
+		err = fmax(err, fabs(out[i] - dsp_moog_next(in[i], dsp_moog_init(48000, freq[i], 2.0), &d4)));
+
+	if(!(err < 0.05))
+		printf("failed\n"), sys_exit(1);
+
+	printf("okay\n");
+
+	return true;
+}
@@ -0,0 +1,244 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void multirate_decim(unsigned int factor, const double *coef, unsigned int ntaps);
+static void multirate_interp(unsigned int factor, const double *coef, unsigned int ntaps);
+static void multirate_over(unsigned int factor, unsigned int ntaps);
+static void multirate_scale(double **buf, unsigned int len, void *arg);
+
+static double multirate_in(unsigned int i);
+
+/*
+ * global variables
+ */
+
+static const unsigned int multirate_size[] = { 1, 2, 63, 64, 65, 300, 7, 256, 257, 5 };
+
+
+/**
+ * Multirate test. The decimator and interpolator must match direct
+ * convolution across uneven blocks, the filter designs must hold their
+ * shape, and the oversampler must match its own chain and pass low
+ * frequencies scaled only by its callback after the expected delay.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_multirate()
+{
+	unsigned int i;
+	double sum, sinc[25], half[31];
+
+	printf("multirate... ");
+
+	dsp_multirate_sinc(sinc, 25, 0.15, 8.0);
+	dsp_multirate_halfband(half, 31, 8.0);
+
+	for(i = 0, sum = 0.0; i < 25; i++) {
+		if(fabs(sinc[i] - sinc[24 - i]) > 1e-15)
+			printf("failed\n"), sys_exit(1);
+
+		sum += sinc[i];
+	}
+
+	if(fabs(sum - 1.0) > 1e-12)
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0, sum = 0.0; i < 31; i++) {
+		if((i != 15) && ((i % 2) == 1) && (half[i] != 0.0))
+			printf("failed\n"), sys_exit(1);
+
+		sum += half[i];
+	}
+
+	if((half[15] != 0.5) || (fabs(sum - 1.0) > 1e-12) || (dsp_multirate_kaiser(0.0, 8.0) != 1.0) || (dsp_multirate_kaiser(1.0, 8.0) != 0.0))
+		printf("failed\n"), sys_exit(1);
+
+	multirate_decim(3, sinc, 25);
+	multirate_decim(2, half, 31);
+	multirate_decim(1, sinc, 25);
+	multirate_interp(3, sinc, 25);
+	multirate_interp(2, half, 31);
+	multirate_over(2, 31);
+	multirate_over(3, 40);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Check the decimator against direct convolution.
+ *   @factor: The decimation factor.
+ *   @coef: The coefficients.
+ *   @ntaps: The number of taps.
+ */
+
+static void multirate_decim(unsigned int factor, const double *coef, unsigned int ntaps)
+{
+	unsigned int i, k, n, off, blk, cnt = 0;
+	double ref, in[300], out[3000];
+	struct dsp_decim_t *decim;
+
+	decim = dsp_decim_new(factor, coef, ntaps);
+
+	for(off = blk = 0; off < 3000; off += n, blk++) {
+		n = (3000 - off < multirate_size[blk % 10]) ? (3000 - off) : multirate_size[blk % 10];
+		n = (n < 300) ? n : 300;
+
+		for(i = 0; i < n; i++)
+			in[i] = multirate_in(off + i);
+
+		cnt += dsp_decim_proc(decim, in, n, out + cnt);
+	}
+
+	if(cnt != (3000 + factor - 1) / factor)
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < cnt; i++) {
+		for(ref = 0.0, k = 0; (k < ntaps) && (k <= i * factor); k++)
+			ref += coef[k] * multirate_in(i * factor - k);
+
+		if(fabs(out[i] - ref) > 1e-12)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_decim_delete(decim);
+}
+
+/**
+ * Check the interpolator against direct convolution of the zero-stuffed
+ * input.
+ *   @factor: The interpolation factor.
+ *   @coef: The coefficients.
+ *   @ntaps: The number of taps.
+ */
+
+static void multirate_interp(unsigned int factor, const double *coef, unsigned int ntaps)
+{
+	unsigned int i, k, n, off, blk;
+	double ref, in[300], out[3000 * factor];
+	struct dsp_interp_t *interp;
+
+	interp = dsp_interp_new(factor, coef, ntaps);
+
+	for(off = blk = 0; off < 3000; off += n, blk++) {
+		n = (3000 - off < multirate_size[blk % 10]) ? (3000 - off) : multirate_size[blk % 10];
+		n = (n < 300) ? n : 300;
+
+		for(i = 0; i < n; i++)
+			in[i] = multirate_in(off + i);
+
+		dsp_interp_proc(interp, in, n, out + off * factor);
+	}
+
+	for(i = 0; i < 3000 * factor; i++) {
+		for(ref = 0.0, k = i % factor; (k < ntaps) && (k <= i); k += factor)
+			ref += factor * coef[k] * multirate_in((i - k) / factor);
+
+		if(fabs(out[i] - ref) > 1e-12)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_interp_delete(interp);
+}
+
+/**
+ * Check the oversampler against an explicit interpolate, scale, and
+ * decimate chain, and check that a low frequency passes scaled only by the
+ * callback gain after the filter delay.
+ *   @factor: The oversampling factor.
+ *   @ntaps: The requested number of taps.
+ */
+
+static void multirate_over(unsigned int factor, unsigned int ntaps)
+{
+	unsigned int i, n, off, blk, delay;
+	double gain = 2.0, coef[ntaps + factor + 3], up[300 * factor], buf[2][3000], ref[3000];
+	double *ptr[2];
+	struct dsp_over_t *over;
+	struct dsp_interp_t *interp;
+	struct dsp_decim_t *decim;
+
+	over = dsp_over_new(2, factor, ntaps, multirate_scale, &gain);
+
+	if(factor == 2) {
+		ntaps |= 3;
+		dsp_multirate_halfband(coef, ntaps, 8.0);
+	}
+	else {
+		ntaps = (ntaps + factor - 1) / factor * factor + 1;
+		dsp_multirate_sinc(coef, ntaps, 0.45 / factor, 8.0);
+	}
+
+	interp = dsp_interp_new(factor, coef, ntaps);
+	decim = dsp_decim_new(factor, coef, ntaps);
+
+	for(i = 0; i < 3000; i++) {
+		buf[0][i] = multirate_in(i);
+		buf[1][i] = sin(2.0 * M_PI * 0.01 * i);
+	}
+
+	for(off = blk = 0; off < 3000; off += n, blk++) {
+		n = (3000 - off < multirate_size[blk % 10]) ? (3000 - off) : multirate_size[blk % 10];
+		n = (n < 300) ? n : 300;
+
+		dsp_interp_proc(interp, buf[0] + off, n, up);
+
+		for(i = 0; i < n * factor; i++)
+			up[i] *= gain;
+
+		if(dsp_decim_proc(decim, up, n * factor, ref + off) != n)
+			printf("failed\n"), sys_exit(1);
+
+		ptr[0] = buf[0] + off;
+		ptr[1] = buf[1] + off;
+		dsp_over_proc(ptr, n, over);
+	}
+
+	delay = (ntaps - 1) / factor;
+
+	for(i = 0; i < 3000; i++) {
+		if(fabs(buf[0][i] - ref[i]) > 1e-12)
+			printf("failed\n"), sys_exit(1);
+
+		if((i >= delay + 200) && (fabs(buf[1][i] - 2.0 * sin(2.0 * M_PI * 0.01 * (i - delay))) > 1e-3))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_interp_delete(interp);
+	dsp_decim_delete(decim);
+	dsp_over_delete(over);
+}
+
+/**
+ * Scale every channel by a gain at the higher rate.
+ *   @buf: The buffers.
+ *   @len: The length.
+ *   @arg: The gain.
+ */
+
+static void multirate_scale(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i;
+
+	for(i = 0; i < len; i++) {
+		buf[0][i] *= *(double *)arg;
+		buf[1][i] *= *(double *)arg;
+	}
+}
+
+/**
+ * Generate a broadband test input.
+ *   @i: The sample index.
+ *   &returns: The sample.
+ */
+
+static double multirate_in(unsigned int i)
+{
+	return sin(0.05 * i) + 0.5 * sin(1.3 * i + 1.0) + 0.25 * cos(2.9 * i);
+}
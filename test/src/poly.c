@@ -0,0 +1,247 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void poly_render(const struct dsp_poly_note_t *note, unsigned int rate, unsigned int off, const unsigned int *len, unsigned int nblk, double *buf);
+static void *poly_proc(void *arg);
+static void poly_note(struct dsp_poly_note_t *note, unsigned int seed);
+
+
+/**
+ * Polyphonic voice pool test. Rendered voices must match the scalar
+ * oscillator, envelope, and moog chain; stealing must prefer released and
+ * older voices; and the free list must survive concurrent note changes.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_poly()
+{
+	unsigned int i, n, v, off, id[6], nblk = 9;
+	const unsigned int len[9] = { 100, 37, 64, 1, 250, 31, 33, 500, 2000 };
+	double buf[3016], ref[3016];
+	struct dsp_poly_note_t note[4];
+	struct dsp_poly_t *poly;
+	struct thread_t *thread[3];
+	bool done = false, seen[6];
+	void *arg[2];
+
+	printf("poly... ");
+
+	for(i = 0; i < 4; i++) {
+		poly_note(&note[i], i);
+		note[i].release = 0.01;
+	}
+
+	poly = dsp_poly_new(5, 48000);
+
+	mem_set(buf, 0x00, sizeof(buf));
+	mem_set(ref, 0x00, sizeof(ref));
+
+	for(i = 0; i < 4; i++)
+		id[i] = dsp_poly_on(poly, &note[i]);
+
+	for(i = off = 0; i < nblk; off += len[i++]) {
+		if(i < 4)
+			dsp_poly_off(poly, id[i]);
+
+		dsp_poly_proc(poly, buf + off, len[i]);
+	}
+
+	if(dsp_poly_active(poly) != 0)
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < 4; i++)
+		poly_render(&note[i], 48000, i, len, nblk, ref);
+
+	for(i = 0; i < off; i++) {
+		if(fabs(buf[i] - ref[i]) > 1e-9)
+			printf("failed\n"), sys_exit(1);
+	}
+
+	for(i = 0; i < 4; i++) {
+		note[i].release = 1.0;
+		id[i] = dsp_poly_on(poly, &note[i]);
+		dsp_poly_proc(poly, buf, 64);
+	}
+
+	dsp_poly_on(poly, &note[0]);
+	dsp_poly_off(poly, id[1]);
+	dsp_poly_proc(poly, buf, 64);
+
+	id[4] = dsp_poly_on(poly, &note[0]);
+	id[5] = dsp_poly_on(poly, &note[0]);
+	if(((id[4] & 0xffff) != (id[1] & 0xffff)) || ((id[5] & 0xffff) != (id[0] & 0xffff)))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_poly_off(poly, id[1]);
+	dsp_poly_off(poly, id[0]);
+
+	for(i = 0; i < 100; i++)
+		dsp_poly_proc(poly, buf, 1000);
+
+	if(dsp_poly_active(poly) != 5)
+		printf("failed\n"), sys_exit(1);
+
+	dsp_poly_delete(poly);
+
+	poly = dsp_poly_new(6, 48000);
+
+	arg[0] = poly;
+	arg[1] = &done;
+
+	for(i = 0; i < 3; i++)
+		thread[i] = thread_new(poly_proc, arg, NULL);
+
+	for(n = 0; n < 3; ) {
+		dsp_poly_proc(poly, buf, 128);
+
+		if(dsp_poly_active(poly) > 6)
+			printf("failed\n"), sys_exit(1);
+
+		if(__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+			__atomic_store_n(&done, false, __ATOMIC_RELAXED);
+			n++;
+		}
+	}
+
+	for(i = 0; i < 3; i++)
+		thread_join(thread[i]);
+
+	for(i = 0; i < 100; i++)
+		dsp_poly_proc(poly, buf, 1000);
+
+	if(dsp_poly_active(poly) != 0)
+		printf("failed\n"), sys_exit(1);
+
+	mem_set(seen, 0x00, sizeof(seen));
+
+	for(i = 0; i < 6; i++) {
+		v = dsp_poly_on(poly, &note[0]);
+		if((v == UINT_MAX) || seen[v & 0xffff])
+			printf("failed\n"), sys_exit(1);
+
+		seen[v & 0xffff] = true;
+	}
+
+	if(dsp_poly_on(poly, &note[0]) != UINT_MAX)
+		printf("failed\n"), sys_exit(1);
+
+	dsp_poly_delete(poly);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Render a single voice with the scalar oscillator, envelope, and filter,
+ * following the processing block and control period boundaries.
+ *   @note: The note.
+ *   @rate: The sample rate.
+ *   @off: The block at which the note is released.
+ *   @len: The block lengths.
+ *   @nblk: The number of blocks.
+ *   @buf: The output buffer, accumulated into.
+ */
+
+static void poly_render(const struct dsp_poly_note_t *note, unsigned int rate, unsigned int off, const unsigned int *len, unsigned int nblk, double *buf)
+{
+	unsigned int i, k, n, blk, t = 0, sus = UINT_MAX / 2;
+	double db, gain = 0.0, delta, ph = 0.0, step, x;
+	struct dsp_adsr_t adsr;
+	struct dsp_moog_t moog;
+	struct dsp_data_4 data;
+
+	adsr = dsp_adsr_init(note->attack, note->decay, note->sustain, note->release, rate);
+	moog = dsp_moog_init(rate, note->cutoff, note->res);
+	step = dsp_osc_step(note->freq, rate);
+	data = dsp_data_4();
+
+	for(blk = 0; blk < nblk; buf += len[blk++]) {
+		if(blk == off)
+			sus = t;
+
+		for(k = 0; k < len[blk]; k += n) {
+			n = (len[blk] - k < 32) ? (len[blk] - k) : 32;
+
+			if(!dsp_adsr_active(adsr, t, sus))
+				return;
+
+			t += n;
+			db = dsp_adsr_proc(adsr, t, sus);
+			delta = ((isinf(db) ? 0.0 : note->amp * pow(10.0, db / 20.0)) - gain) / n;
+
+			for(i = 0; i < n; i++) {
+				ph = dsp_osc_inc(ph, step);
+				x = note->saw * dsp_osc_saw(ph) + note->square * dsp_osc_square(ph) + note->tri * dsp_osc_tri(ph);
+				buf[k + i] += dsp_moog_next(x * gain, moog, &data);
+				gain += delta;
+			}
+		}
+	}
+}
+
+/**
+ * Note thread, starting and releasing notes while the pool is processed.
+ *   @arg: The voice pool and completion flag.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *poly_proc(void *arg)
+{
+	unsigned int i, n, rand = 1, id[8];
+	struct dsp_poly_t *poly = ((void **)arg)[0];
+	struct dsp_poly_note_t note;
+
+	for(i = 0; i < 8; i++)
+		id[i] = UINT_MAX;
+
+	for(n = 0; n < 4000; n++) {
+		rand = rand * 1103515245 + 12345;
+		i = (rand >> 16) % 8;
+
+		if(id[i] != UINT_MAX)
+			dsp_poly_off(poly, id[i]);
+
+		poly_note(&note, rand >> 8);
+		id[i] = dsp_poly_on(poly, &note);
+
+		if(n % 16 == 0)
+			sched_yield();
+	}
+
+	for(i = 0; i < 8; i++) {
+		if(id[i] != UINT_MAX)
+			dsp_poly_off(poly, id[i]);
+	}
+
+	while(__atomic_exchange_n((bool *)((void **)arg)[1], true, __ATOMIC_RELEASE))
+		sched_yield();
+
+	return NULL;
+}
+
+/**
+ * Fill a note from a seed.
+ *   @note: The note.
+ *   @seed: The seed.
+ */
+
+static void poly_note(struct dsp_poly_note_t *note, unsigned int seed)
+{
+	note->freq = 110.0 * (1 + seed % 7);
+	note->amp = 0.25;
+	note->saw = (seed % 3) / 2.0;
+	note->square = (seed % 5) / 8.0;
+	note->tri = 0.5;
+	note->cutoff = 500.0 + 300.0 * (seed % 11);
+	note->res = (seed % 4) / 2.0;
+	note->attack = 0.001;
+	note->decay = 0.002;
+	note->release = 0.01;
+	note->sustain = -6.0;
+}
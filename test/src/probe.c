@@ -0,0 +1,149 @@
+#define DSP_INSTRUMENT
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void *probe_proc(void *arg);
+static void *probe_drainer(void *arg);
+static void probe_count(const char *name, double val, void *arg);
+
+/*
+ * global variables
+ */
+
+static const char *probe_name[4] = { "main", "t0", "t1", "t2" };
+
+
+/**
+ * Probe test. Entries recorded by several threads must be drained in order
+ * per thread by concurrent drainers, and entries recorded into a full
+ * buffer must be counted as lost.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_probe()
+{
+	unsigned int i, lost, cnt = 0, sub = 0;
+	double next[4] = { 0.0, 0.0, 0.0, 0.0 };
+	struct thread_t *thread[4];
+	bool done = false;
+	void *arg[3] = { next, &done, &sub };
+
+	printf("probe... ");
+
+	if(dsp_probe_attach() != dsp_probe_attach())
+		printf("failed\n"), sys_exit(1);
+
+	lost = dsp_probe_lost();
+
+	for(i = 0; i < 100; i++)
+		DSP_PROBE(probe_name[0], i);
+
+	if((dsp_probe_drain(probe_count, next) != 100) || (next[0] != 100.0))
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < DSP_PROBE_LEN + 50; i++)
+		DSP_PROBE(probe_name[0], 100 + i);
+
+	if(dsp_probe_lost() != lost + 50)
+		printf("failed\n"), sys_exit(1);
+
+	if((dsp_probe_drain(probe_count, next) != DSP_PROBE_LEN) || (next[0] != 100.0 + DSP_PROBE_LEN))
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < 3; i++)
+		thread[i] = thread_new(probe_proc, (void *)probe_name[i + 1], NULL);
+
+	thread[3] = thread_new(probe_drainer, arg, NULL);
+
+	for(i = 0; i < 1000; i++) {
+		cnt += dsp_probe_drain(probe_count, next);
+		sched_yield();
+	}
+
+	for(i = 0; i < 3; i++)
+		thread_join(thread[i]);
+
+	__atomic_store_n(&done, true, __ATOMIC_RELEASE);
+	thread_join(thread[3]);
+	cnt += sub + dsp_probe_drain(probe_count, next);
+
+	if((cnt != 3 * 3000) || (next[1] != 3000.0) || (next[2] != 3000.0) || (next[3] != 3000.0))
+		printf("failed\n"), sys_exit(1);
+
+	if((dsp_probe_lost() != lost + 50) || (dsp_probe_drain(probe_count, next) != 0))
+		printf("failed\n"), sys_exit(1);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Recording thread, recording an increasing sequence under its name.
+ *   @arg: The probe name.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *probe_proc(void *arg)
+{
+	unsigned int i;
+
+	dsp_probe_attach();
+
+	for(i = 0; i < 3000; i++) {
+		DSP_PROBE(arg, i);
+
+		if(i % 64 == 0)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+/**
+ * Drain thread, draining until signaled.
+ *   @arg: The sequence array, completion flag, and drained count.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *probe_drainer(void *arg)
+{
+	unsigned int cnt = 0;
+
+	while(!__atomic_load_n((bool *)((void **)arg)[1], __ATOMIC_ACQUIRE)) {
+		cnt += dsp_probe_drain(probe_count, ((void **)arg)[0]);
+		sched_yield();
+	}
+
+	*(unsigned int *)((void **)arg)[2] = cnt;
+
+	return NULL;
+}
+
+/**
+ * Check that each name receives its values in order.
+ *   @name: The probe name.
+ *   @val: The value.
+ *   @arg: The next expected value per name.
+ */
+
+static void probe_count(const char *name, double val, void *arg)
+{
+	unsigned int i;
+	double *next = arg;
+
+	for(i = 0; i < 4; i++) {
+		if(name == probe_name[i])
+			break;
+	}
+
+	if((i == 4) || (val != next[i]))
+		printf("failed\n"), sys_exit(1);
+
+	next[i] += 1.0;
+}
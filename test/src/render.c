@@ -0,0 +1,227 @@
+#include "common.h"
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+
+/**
+ * Direct flow endpoint structure.
+ *   @data: The channel data.
+ *   @idx, len: The position and length.
+ */
+
+struct render_io_t {
+	double *data[2];
+	unsigned int idx, len;
+};
+
+
+/*
+ * local function declarations
+ */
+
+static struct dsp_node_t *render_chain(struct dsp_flow_t *flow, struct dsp_node_t *src, struct dsp_node_t *sink, double *state);
+static void render_filt(double **buf, unsigned int len, void *arg);
+static void render_in(double **buf, unsigned int len, void *arg);
+static void render_out(double **buf, unsigned int len, void *arg);
+static void render_file(char *path, const uint8_t *data, size_t size);
+
+
+/**
+ * Offline renderer test. A stateful flow is rendered from a WAV file with a
+ * tail that ends on a partial block, and compared against the same flow run
+ * directly with 'dsp_flow_proc'. Running out of file space must fail the
+ * render instead of producing a short file.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_render()
+{
+	int status;
+	pid_t pid;
+	unsigned int i, k;
+	double in[2][1000], out[2][1050], ref[2][1050], state[2][2], *inbuf[2] = { in[0], in[1] }, *outbuf[2] = { out[0], out[1] };
+	uint8_t data[DSP_WAV_HDRLEN + 16 * 1000];
+	char inpath[] = "/tmp/dsp-render-XXXXXX", outpath[] = "/tmp/dsp-render-XXXXXX";
+	struct render_io_t src = { { in[0], in[1] }, 0, 1000 }, sink = { { ref[0], ref[1] }, 0, 1050 };
+	struct dsp_flow_t *flow;
+	struct dsp_node_t *node[3];
+	struct dsp_render_t *render;
+	struct dsp_mmap_t *file;
+	struct rlimit lim;
+
+	printf("render... ");
+
+	for(i = 0; i < 1000; i++) {
+		in[0][i] = sin(0.03 * i) * 0.8;
+		in[1][i] = ((i % 50) < 25) ? 0.5 : -0.25;
+	}
+
+	dsp_wav_header(data, dsp_fmt_f64, 2, 48000, 1000);
+	dsp_arr2fmt(data + DSP_WAV_HDRLEN, inbuf, dsp_fmt_f64, 2, 1000, NULL);
+	render_file(inpath, data, sizeof(data));
+	render_file(outpath, data, 0);
+
+	mem_set(state, 0x00, sizeof(state));
+	flow = dsp_flow_new();
+	dsp_flow_conf(flow, 16, 64);
+	node[0] = dsp_node_new(0, 2, render_in, &src);
+	node[2] = dsp_node_new(2, 0, render_out, &sink);
+	dsp_flow_sync(flow, node[0], NULL);
+	dsp_flow_sync(flow, node[2], NULL);
+	node[1] = render_chain(flow, node[0], node[2], state[0]);
+
+	for(k = 0; k < 17; k++)
+		dsp_flow_proc(flow, 64);
+
+	for(i = 0; i < 3; i++) {
+		dsp_node_reset(node[i]);
+		dsp_flow_desync(flow, node[i], NULL);
+		dsp_node_delete(node[i]);
+	}
+
+	render = dsp_render_new(flow, 64);
+	node[0] = dsp_render_source(render, inpath);
+	node[2] = dsp_render_sink(render, outpath, dsp_fmt_f64, 2, 48000);
+	node[1] = render_chain(flow, node[0], node[2], state[1]);
+
+	if(dsp_render_exec(render, 50) != 1050)
+		printf("failed\n"), sys_exit(1);
+
+	file = dsp_mmap_new(outpath);
+	if((dsp_mmap_len(file) != 1050) || (dsp_mmap_read(file, outbuf, 1050) != 1050))
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < 1050; i++) {
+		if((out[0][i] != ref[0][i]) || (out[1][i] != ref[1][i]))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_mmap_delete(file);
+
+	fflush(stdout);
+	pid = fork();
+	if(pid == 0) {
+		signal(SIGXFSZ, SIG_IGN);
+		lim.rlim_cur = lim.rlim_max = DSP_WAV_HDRLEN + 1000;
+		setrlimit(RLIMIT_FSIZE, &lim);
+		freopen("/dev/null", "w", stderr);
+
+		dsp_render_exec(render, 50);
+		_exit(0);
+	}
+
+	if((pid < 0) || (waitpid(pid, &status, 0) != pid) || (WIFEXITED(status) && (WEXITSTATUS(status) == 0)))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_node_reset(node[1]);
+	dsp_flow_desync(flow, node[1], NULL);
+	dsp_node_delete(node[1]);
+	dsp_render_delete(render);
+	dsp_flow_delete(flow);
+	unlink(inpath);
+	unlink(outpath);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Connect a stereo filter node between a source and a sink node.
+ *   @flow: The flow.
+ *   @src: The source node.
+ *   @sink: The sink node.
+ *   @state: The filter state.
+ *   &returns: The filter node.
+ */
+
+static struct dsp_node_t *render_chain(struct dsp_flow_t *flow, struct dsp_node_t *src, struct dsp_node_t *sink, double *state)
+{
+	unsigned int i;
+	struct dsp_node_t *node;
+
+	node = dsp_node_new(2, 2, render_filt, state);
+	dsp_flow_sync(flow, node, NULL);
+
+	for(i = 0; i < 2; i++) {
+		dsp_flow_attach(dsp_node_source(src, i), dsp_node_sink(node, i), NULL);
+		dsp_flow_attach(dsp_node_source(node, i), dsp_node_sink(sink, i), NULL);
+	}
+
+	return node;
+}
+
+/**
+ * Filter node callback, running a one-pole low-pass per channel.
+ *   @buf: The buffers.
+ *   @len: The length.
+ *   @arg: The filter state.
+ */
+
+static void render_filt(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i, n;
+	double *state = arg;
+
+	for(n = 0; n < 2; n++) {
+		for(i = 0; i < len; i++)
+			buf[n][i] = state[n] = state[n] + 0.1 * (buf[n][i] - state[n]);
+	}
+}
+
+/**
+ * Direct source callback, zero filling past the end of the data.
+ *   @buf: The output buffers.
+ *   @len: The length.
+ *   @arg: The source.
+ */
+
+static void render_in(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i, n;
+	struct render_io_t *io = arg;
+
+	for(i = 0; i < len; i++, io->idx++) {
+		for(n = 0; n < 2; n++)
+			buf[n][i] = (io->idx < io->len) ? io->data[n][io->idx] : 0.0;
+	}
+}
+
+/**
+ * Direct sink callback, capturing up to the data length.
+ *   @buf: The input buffers.
+ *   @len: The length.
+ *   @arg: The sink.
+ */
+
+static void render_out(double **buf, unsigned int len, void *arg)
+{
+	unsigned int i, n;
+	struct render_io_t *io = arg;
+
+	for(i = 0; (i < len) && (io->idx < io->len); i++, io->idx++) {
+		for(n = 0; n < 2; n++)
+			io->data[n][io->idx] = buf[n][i];
+	}
+}
+
+/**
+ * Write data to a new temporary file.
+ *   @path: The path template, replaced with the file path.
+ *   @data: The data.
+ *   @size: The size.
+ */
+
+static void render_file(char *path, const uint8_t *data, size_t size)
+{
+	int fd;
+
+	fd = mkstemp(path);
+	if((fd < 0) || (write(fd, data, size) != (ssize_t)size))
+		printf("failed\n"), sys_exit(1);
+
+	close(fd);
+}
@@ -0,0 +1,172 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void ring_init(void *ref);
+static void *ring_proc(void *arg);
+static unsigned int ring_count(struct dsp_sched_ring_t *sched);
+
+
+/**
+ * Ring scheduler test. A reader thread increments and checks the history
+ * while the main thread repeatedly resizes and relengths the ring. Changes
+ * made before the reader adopts them must combine, and a length change must
+ * carry over only the bounded history.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_ring()
+{
+	unsigned int n, i, len, size = 8, rand = 1;
+	struct dsp_sched_ring_t *sched;
+	struct thread_t *thread;
+	bool done = false;
+	void *arg[2];
+
+	printf("ring... ");
+
+	sched = dsp_sched_ring_new(ring_init, 4, size);
+
+	arg[0] = sched;
+	arg[1] = &done;
+	thread = thread_new(ring_proc, arg, NULL);
+
+	for(n = 0; !__atomic_load_n(&done, __ATOMIC_ACQUIRE); n++) {
+		rand = rand * 1103515245 + 12345;
+		len = (rand >> 16) % 16 + 1;
+
+		if(n % 4 == 3)
+			dsp_sched_ring_resize(sched, size = (size == 8) ? 16 : 8);
+		else
+			dsp_sched_ring_relen(sched, len);
+
+		if(ring_count(sched) > 3)
+			printf("failed\n"), sys_exit(1);
+
+		sched_yield();
+	}
+
+	thread_join(thread);
+
+	if(n < 10)
+		printf("failed\n"), sys_exit(1);
+
+	dsp_sched_ring_resize(sched, 64);
+	dsp_sched_ring_relen(sched, 16);
+	dsp_sched_ring_inc(sched);
+
+	if((sched->cur->len != 16) || (sched->cur->size != 64))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_sched_ring_relen(sched, 5);
+	dsp_sched_ring_resize(sched, 32);
+	dsp_sched_ring_inc(sched);
+
+	if((sched->cur->len != 5) || (sched->cur->size != 32) || (sched->cur->retire != UINT64_MAX))
+		printf("failed\n"), sys_exit(1);
+
+	dsp_sched_ring_relen(sched, 16);
+
+	for(i = 1; i <= 20; i++)
+		*(uint64_t *)dsp_sched_ring_inc(sched) = i;
+
+	dsp_sched_ring_relen(sched, 12);
+	*(uint64_t *)dsp_sched_ring_inc(sched) = 21;
+
+	for(i = 0; i < 12; i++) {
+		if(*(uint64_t *)dsp_sched_ring_get(sched, i) != ((i <= DSP_SCHED_RING_CARRY) ? (21 - i) : 0))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	dsp_sched_ring_inc(sched);
+	dsp_sched_ring_inc(sched);
+	dsp_sched_ring_inc(sched);
+	dsp_sched_ring_relen(sched, 4);
+
+	if(ring_count(sched) != 0)
+		printf("failed\n"), sys_exit(1);
+
+	dsp_sched_ring_delete(sched);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Initialize a reference to zero.
+ *   @ref: The reference.
+ */
+
+static void ring_init(void *ref)
+{
+	*(uint64_t *)ref = 0;
+}
+
+/**
+ * Reader thread, writing the sequence to every reference and checking that
+ * the bounded history survives length changes and is cleared by size
+ * changes.
+ *   @arg: The scheduler and completion flag.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *ring_proc(void *arg)
+{
+	uint64_t n, i, valid = 0;
+	struct dsp_sched_ring_t *sched = ((void **)arg)[0];
+	struct dsp_sched_ring_buf_t *prev;
+
+	for(n = 1; n <= 200000; n++) {
+		prev = sched->cur;
+		*(uint64_t *)dsp_sched_ring_inc(sched) = n;
+
+		if(sched->cur != prev) {
+			if(sched->cur->retire == UINT64_MAX)
+				valid = 0;
+			else {
+				if(valid > DSP_SCHED_RING_CARRY)
+					valid = DSP_SCHED_RING_CARRY;
+
+				if(valid > sched->cur->len)
+					valid = sched->cur->len;
+			}
+		}
+
+		if(valid < sched->cur->len)
+			valid++;
+
+		for(i = 0; i < valid; i++) {
+			if(*(uint64_t *)dsp_sched_ring_get(sched, i) != n - i)
+				printf("failed\n"), sys_exit(1);
+		}
+
+		if(n % 64 == 0)
+			sched_yield();
+	}
+
+	__atomic_store_n((bool *)((void **)arg)[1], true, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/**
+ * Count the retired buffers awaiting release.
+ *   @sched: The scheduler.
+ *   &returns: The number of buffers.
+ */
+
+static unsigned int ring_count(struct dsp_sched_ring_t *sched)
+{
+	unsigned int n = 0;
+	struct dsp_sched_ring_buf_t *buf;
+
+	for(buf = __atomic_load_n(&sched->retired, __ATOMIC_ACQUIRE); buf != NULL; buf = buf->next)
+		n++;
+
+	return n;
+}
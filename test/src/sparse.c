@@ -0,0 +1,85 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void sparse_check(const struct dsp_pt_t *pt, unsigned int npts, unsigned int len);
+
+
+/**
+ * Sparse block IIR test. Block processing must match the per-sample sparse
+ * IIR when runs are split by the smallest offset, when short offsets force
+ * the per-sample fallback, and when offsets are multiples of the ring
+ * length.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_sparse()
+{
+	const struct dsp_pt_t split[] = {
+		{ 17, 0.2 }, { 5, -0.3 }, { 64, 0.1 }, { 128, -0.05 }, { 70, 0.15 }
+	};
+	const struct dsp_pt_t fallback[] = {
+		{ 9, 0.3 }, { 2, -0.25 }, { 40, 0.1 }
+	};
+	const struct dsp_pt_t multiple[] = {
+		{ 32, 0.4 }, { 0, -0.2 }, { 96, 0.1 }
+	};
+
+	printf("sparse... ");
+
+	sparse_check(split, 5, 64);
+	sparse_check(fallback, 3, 64);
+	sparse_check(multiple, 3, 32);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Check the block sparse IIR against the per-sample sparse IIR, both out
+ * of place and in place.
+ *   @pt: The point set.
+ *   @npts: The number of points.
+ *   @len: The ring length.
+ */
+
+static void sparse_check(const struct dsp_pt_t *pt, unsigned int npts, unsigned int len)
+{
+	unsigned int i, n, off, blk;
+	const unsigned int size[] = { 1, 3, 4, 5, 33, 64, 100, 7, 250 };
+	double in[2000], out[2000], buf[2000], ref[2000];
+	struct dsp_filter_sparse_t *filt[3];
+
+	for(n = 0; n < 3; n++) {
+		filt[n] = dsp_filter_sparse_empty(npts, len);
+
+		for(i = 0; i < npts; i++)
+			filt[n]->pt[i] = pt[i];
+	}
+
+	for(i = 0; i < 2000; i++) {
+		in[i] = sin(0.05 * i) + 0.5 * sin(0.31 * i + 1.0);
+		ref[i] = dsp_filter_sparse_iir(filt[0], in[i]);
+	}
+
+	mem_copy(buf, in, sizeof(in));
+
+	for(off = blk = 0; off < 2000; off += n, blk++) {
+		n = (2000 - off < size[blk % 9]) ? (2000 - off) : size[blk % 9];
+		dsp_filter_sparse_iir_block(filt[1], in + off, out + off, n);
+		dsp_filter_sparse_iir_block(filt[2], buf + off, buf + off, n);
+	}
+
+	for(i = 0; i < 2000; i++) {
+		if((fabs(out[i] - ref[i]) > 1e-12) || (fabs(buf[i] - ref[i]) > 1e-12))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	for(n = 0; n < 3; n++)
+		dsp_filter_sparse_delete(filt[n]);
+}
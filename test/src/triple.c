@@ -0,0 +1,85 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void *triple_proc(void *arg);
+
+
+/**
+ * Triple buffer test.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_triple()
+{
+	unsigned int i;
+	uint64_t val[32], last = 0;
+	const uint64_t *cur;
+	struct dsp_triple_t *triple;
+	struct thread_t *thread;
+
+	printf("triple... ");
+
+	mem_set(val, 0x00, sizeof(val));
+	triple = dsp_triple_new(sizeof(val), val);
+
+	if(dsp_triple_fresh(triple))
+		printf("failed\n"), sys_exit(1);
+
+	for(i = 0; i < 32; i++)
+		val[i] = 1;
+
+	dsp_triple_write(triple, val);
+	cur = dsp_triple_read(triple);
+	if((cur[0] != 1) || (cur[31] != 1) || dsp_triple_fresh(triple))
+		printf("failed\n"), sys_exit(1);
+
+	thread = thread_new(triple_proc, triple, NULL);
+
+	while(last < 100000) {
+		cur = dsp_triple_read(triple);
+
+		for(i = 1; i < 32; i++) {
+			if(cur[i] != cur[0])
+				printf("failed\n"), sys_exit(1);
+		}
+
+		if(cur[0] < last)
+			printf("failed\n"), sys_exit(1);
+
+		last = cur[0];
+		sched_yield();
+	}
+
+	thread_join(thread);
+	dsp_triple_delete(triple);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Writer thread, publishing values with every element equal.
+ *   @arg: The triple buffer.
+ *   &returns: Always 'NULL'.
+ */
+
+static void *triple_proc(void *arg)
+{
+	unsigned int i;
+	uint64_t n, val[32];
+
+	for(n = 2; n <= 100000; n++) {
+		for(i = 0; i < 32; i++)
+			val[i] = n;
+
+		dsp_triple_write(arg, val);
+	}
+
+	return NULL;
+}
@@ -0,0 +1,88 @@
+#include "common.h"
+
+
+/*
+ * local function declarations
+ */
+
+static void wheel_proc(unsigned int off, void *data, void *arg);
+
+/*
+ * global variables
+ */
+
+static uint64_t wheel_base, wheel_last;
+static unsigned int wheel_cnt;
+
+
+/**
+ * Timer wheel test.
+ *   &returns: True of success, false on failure.
+ */
+
+bool test_wheel()
+{
+	unsigned int i;
+	uint64_t t, seed = 1;
+	struct dsp_sched_wheel_t *wheel;
+
+	printf("wheel... ");
+
+	wheel = dsp_sched_wheel_new(4096, sizeof(uint64_t), 64);
+
+	for(i = 0; i < 3000; i++) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		t = (seed >> 33) % (1 << 22);
+
+		if(!dsp_sched_wheel_add(wheel, t, &t))
+			printf("failed\n"), sys_exit(1);
+	}
+
+	t = ((uint64_t)1 << 32) + 17;
+	if(!dsp_sched_wheel_post(wheel, t, &t))
+		printf("failed\n"), sys_exit(1);
+
+	t = 1000;
+	if(!dsp_sched_wheel_post(wheel, t, &t))
+		printf("failed\n"), sys_exit(1);
+
+	wheel_last = 0;
+	wheel_cnt = 0;
+
+	for(wheel_base = 0; wheel_base < (1 << 22); wheel_base += 333)
+		dsp_sched_wheel_proc(wheel, wheel_base, 333, wheel_proc, NULL);
+
+	if(wheel_cnt != 3001)
+		printf("failed\n"), sys_exit(1);
+
+	for(; wheel_base < ((uint64_t)1 << 32) + 1024; wheel_base += 1 << 20)
+		dsp_sched_wheel_proc(wheel, wheel_base, 1 << 20, wheel_proc, NULL);
+
+	if(wheel_cnt != 3002)
+		printf("failed\n"), sys_exit(1);
+
+	dsp_sched_wheel_delete(wheel);
+
+	printf("okay\n");
+
+	return true;
+}
+
+
+/**
+ * Timer wheel callback, checking the offset and ordering of each event.
+ *   @off: The offset.
+ *   @data: The event time.
+ *   @arg: Unused.
+ */
+
+static void wheel_proc(unsigned int off, void *data, void *arg)
+{
+	uint64_t t = *(uint64_t *)data;
+
+	if((t != wheel_base + off) || (t < wheel_last))
+		printf("failed\n"), sys_exit(1);
+
+	wheel_last = t;
+	wheel_cnt++;
+}
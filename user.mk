@@ -7,13 +7,26 @@ HEADERS = \
 	src/algo.h \
 	src/calc.h \
 	src/conv.h \
+	src/convolve.h \
 	src/buf.h \
+	src/fft.h \
 	src/map.h \
 	src/osc.h \
+	src/poly.h \
+	src/probe.h \
+	src/resamp.h \
 	src/shape.h \
 	\
+	src/filter/auto.h \
+	src/filter/bank.h \
 	src/filter/butter.h \
+	src/filter/cascade.h \
+	src/filter/coef.h \
+	src/filter/design.h \
+	src/filter/fir.h \
+	src/filter/mod.h \
 	src/filter/moog.h \
+	src/filter/multirate.h \
 	src/filter/rc.h \
 	src/filter/res.h \
 	src/filter/sparse.h \
@@ -21,8 +34,13 @@ HEADERS = \
 	src/flow/flow.h \
 	src/flow/node.h \
 	\
+	src/io/codec.h \
+	src/io/loop.h \
+	src/io/mmap.h \
 	src/io/play.h \
 	src/io/rec.h \
+	src/io/render.h \
+	src/io/wav.h \
 	\
 	src/reverb/allpass.h \
 	src/reverb/comb.h \
@@ -30,12 +48,15 @@ HEADERS = \
 	\
 	src/sched/live.h \
 	src/sched/ring.h \
+	src/sched/wheel.h \
 	\
 	src/tools/gate.h \
 	\
 	src/types/array.h \
+	src/types/carray.h \
 	src/types/lock.h \
 	src/types/sync.h \
+	src/types/triple.h \
 
 all: dsp.h
 